@@ -65,6 +65,17 @@ namespace cuw::mem {
 			}
 		};
 
+		// key_ops for B+tree, block start is the key
+		struct addr_key_ops_t {
+			std::uintptr_t get_key(ad_t* descr) const {
+				return (std::uintptr_t)descr->data;
+			}
+
+			bool compare(std::uintptr_t addr1, std::uintptr_t addr2) const {
+				return addr1 < addr2;
+			}
+		};
+
 
 		alloc_descr_state_t get_state() const {
 			return {
@@ -264,6 +275,14 @@ namespace cuw::mem {
 			base_t::erase(&descr->list_entry);
 		}
 
+		// new_descr is a copy of the descriptor from the list, list neighbours are pointed to the copy
+		static void relink(ad_t* new_descr) {
+			assert(new_descr);
+			adl_t* entry = &new_descr->list_entry;
+			list::link(entry->prev, entry);
+			list::link(entry, entry->next);
+		}
+
 		ad_t* peek() const {
 			if (adl_t* adl = base_t::peek()) {
 				return ad_t::list_entry_to_descr(adl);
@@ -312,11 +331,23 @@ namespace cuw::mem {
 		alloc_descr_addr_cache_t& operator = (alloc_descr_addr_cache_t&& another) noexcept {
 			if (this != &another) {
 				index = std::exchange(another.index, nullptr);
+				finger = std::exchange(another.finger, nullptr);
 				count = std::exchange(another.count, 0);
 			}
 			return *this;
 		}
 
+		// tree nodes are embedded into descriptors so nothing has to be reserved
+		template<class alloc_t>
+		[[nodiscard]] bool reserve(alloc_t&) {
+			return true;
+		}
+
+		template<class alloc_t>
+		void release(alloc_t&) {
+			reset();
+		}
+
 		void insert(ad_t* descr) {
 			++count;
 			index = trb::insert_lb(index, &descr->addr_index, ad_t::addr_ops_t{});
@@ -324,20 +355,40 @@ namespace cuw::mem {
 
 		void erase(ad_t* descr) {
 			--count;
+			if (finger == &descr->addr_index) {
+				finger = nullptr;
+			}
 			index = trb::remove(index, &descr->addr_index);
 		}
 
+		// new_descr is a copy of old_descr (including the tree node), tree links are pointed to the copy
+		void relocate(ad_t* old_descr, ad_t* new_descr) {
+			index = bst::update_links(index, &new_descr->addr_index, &old_descr->addr_index);
+			if (finger == &old_descr->addr_index) {
+				finger = &new_descr->addr_index;
+			}
+		}
+
+		// frees tend to cluster so the search starts from the last hit
 		ad_t* find(void* addr) const {
+			if (finger && ad_t::addr_index_to_descr(finger)->has_addr(addr)) {
+				return ad_t::addr_index_to_descr(finger);
+			}
+
 			// lower_bound search can guarantee that addr < block end but it doesn't guarantee that addr belongs to block
-			if (addr_index_t* found = bst::lower_bound(index, addr, ad_t::addr_ops_t{})) {
+			if (addr_index_t* found = bst::finger_lower_bound(index, finger, addr, ad_t::addr_ops_t{})) {
 				ad_t* descr = ad_t::addr_index_to_descr(found);
-				return descr->has_addr(addr) ? descr : nullptr;
+				if (descr->has_addr(addr)) {
+					finger = found;
+					return descr;
+				}
 			}
 			return nullptr;
 		}
 
 		void reset() {
 			index = nullptr;
+			finger = nullptr;
 			count = 0;
 		}
 
@@ -346,9 +397,71 @@ namespace cuw::mem {
 		}
 
 		addr_index_t* index{};
+		mutable addr_index_t* finger{}; // last hit
 		std::size_t count{};
 	};
 
+	// same as above but B+tree is used so lookup touches a few wide nodes instead of a long chain of descriptors
+	// descriptor's addr_index node is unused, nodes are allocated from chunks of alloc_t & must be reserved before insertion
+	struct alloc_descr_btree_addr_cache_t {
+		using ad_t = alloc_descr_t;
+		using index_t = btree::btree_t<ad_t, ad_t::addr_key_ops_t>;
+
+		template<class alloc_t>
+		[[nodiscard]] bool reserve(alloc_t& alloc) {
+			return index.reserve(alloc);
+		}
+
+		template<class alloc_t>
+		void release(alloc_t& alloc) {
+			index.release(alloc);
+		}
+
+		void set_chunk_size(std::size_t chunk_size) {
+			index.set_chunk_size(chunk_size);
+		}
+
+		void insert(ad_t* descr) {
+			index.insert(descr);
+		}
+
+		void erase(ad_t* descr) {
+			if (last_hit == descr) {
+				last_hit = nullptr;
+			}
+			[[maybe_unused]] bool erased = index.erase(descr);
+			assert(erased);
+		}
+
+		void relocate(ad_t* old_descr, ad_t* new_descr) {
+			if (last_hit == old_descr) {
+				last_hit = new_descr;
+			}
+			[[maybe_unused]] bool replaced = index.replace(old_descr, new_descr);
+			assert(replaced);
+		}
+
+		ad_t* find(void* addr) const {
+			if (last_hit && last_hit->has_addr(addr)) {
+				return last_hit;
+			}
+
+			// last block starting before or at addr is the only candidate
+			if (ad_t* descr = index.floor((std::uintptr_t)addr); descr && descr->has_addr(addr)) {
+				last_hit = descr;
+				return descr;
+			}
+			return nullptr;
+		}
+
+		std::size_t get_size() const {
+			return index.get_size();
+		}
+
+		index_t index;
+		mutable ad_t* last_hit{};
+	};
+
 	// chunk_size: size of allocated chunk, real value not enum
 	// type: block_type_t value, must be pool-like
 	// free_cache: list of description blocks (pool_count) that have free chunks
@@ -410,6 +523,11 @@ namespace cuw::mem {
 			--pool_count;
 		}
 
+		void relocate([[maybe_unused]] ad_t* old_descr, ad_t* new_descr) {
+			assert(new_descr->list_entry.prev == old_descr->list_entry.prev && new_descr->list_entry.next == old_descr->list_entry.next);
+			ad_cache_t::relink(new_descr);
+		}
+
 		ad_t* peek() const {
 			return free_pools.peek();
 		}
@@ -18,7 +18,6 @@ namespace cuw::mem {
 	public:
 		using base_t = alloc_descr_pool_cache_t;
 		using ad_t = alloc_descr_t;
-		using ad_addr_cache_t = alloc_descr_addr_cache_t;
 
 		basic_pool_entry_t(attrs_t _chunk_size_log2 = 0, attrs_t _alignment = 0)
 			: chunk_size_log2{_chunk_size_log2}, alignment{_alignment} {}
@@ -47,11 +46,17 @@ namespace cuw::mem {
 			return descr;
 		}
 
-		ad_t* find(const ad_addr_cache_t& addr_cache, void* addr, int max_lookups) {
-			if (ad_t* descr = base_t::find(addr, max_lookups)) {
-				return descr;
+		// last hit of this size class is checked first
+		template<class addr_cache_t = alloc_descr_addr_cache_t>
+		ad_t* find(const addr_cache_t& addr_cache, void* addr, int max_lookups) {
+			if (last_hit && last_hit->has_addr(addr)) {
+				return last_hit;
+			} if (ad_t* descr = base_t::find(addr, max_lookups)) {
+				return last_hit = descr;
+			} if (ad_t* descr = addr_cache.find(addr)) {
+				return last_hit = descr;
 			}
-			return addr_cache.find(addr);
+			return nullptr;
 		}
 
 		[[nodiscard]] void* acquire() {
@@ -71,7 +76,8 @@ namespace cuw::mem {
 			return chunk;
 		}
 
-		[[nodiscard]] released_status_t release(const ad_addr_cache_t& addr_cache, void* ptr, int cache_lookups) {
+		template<class addr_cache_t = alloc_descr_addr_cache_t>
+		[[nodiscard]] released_status_t release(const addr_cache_t& addr_cache, void* ptr, int cache_lookups) {
 			if (ad_t* descr = find(addr_cache, ptr, cache_lookups)) {
 				return release(ptr, descr);
 			}
@@ -91,9 +97,20 @@ namespace cuw::mem {
 
 		void finish_release(ad_t* descr) {
 			check_descr(descr);
+			if (last_hit == descr) {
+				last_hit = nullptr;
+			}
 			base_t::erase(descr);
 		}
 
+		// new_descr is a copy of old_descr placed into another block
+		void relocate(ad_t* old_descr, ad_t* new_descr) {
+			base_t::relocate(old_descr, new_descr);
+			if (last_hit == old_descr) {
+				last_hit = new_descr;
+			}
+		}
+
 		// void func(ad_t* descr)
 		template<class func_t>
 		void traverse(func_t func) {
@@ -103,6 +120,7 @@ namespace cuw::mem {
 		// bool func(void* block, attrs_t offset, void* data, attrs_t size)
 		template<class func_t>
 		int release_all(func_t func) {
+			last_hit = nullptr;
 			return base_t::release_all([&] (ad_t* descr) {
 				return func(descr, descr->get_offset(), descr->get_data(), descr->get_size());
 			});
@@ -119,6 +137,7 @@ namespace cuw::mem {
 		}
 
 		void reset() {
+			last_hit = nullptr;
 			base_t::reset();
 		}
 
@@ -139,6 +158,7 @@ namespace cuw::mem {
 		}
 		
 	private:
+		ad_t* last_hit{};
 		attrs_t chunk_size_log2{};
 		attrs_t alignment{};
 	};
@@ -155,7 +175,6 @@ namespace cuw::mem {
 	public:
 		using base_t = alloc_descr_raw_cache_t;
 		using ad_t = alloc_descr_t;
-		using ad_addr_cache_t = alloc_descr_addr_cache_t;
 
 	private:
 		void check_descr(ad_t* descr) {
@@ -164,7 +183,8 @@ namespace cuw::mem {
 		}
 
 	public:
-		ad_t* find(const ad_addr_cache_t& addr_cache, void* ptr, int max_lookups) {
+		template<class addr_cache_t = alloc_descr_addr_cache_t>
+		ad_t* find(const addr_cache_t& addr_cache, void* ptr, int max_lookups) {
 			if (ad_t* descr = base_t::find(ptr, max_lookups)) {
 				return descr;
 			}
@@ -186,7 +206,8 @@ namespace cuw::mem {
 			return descr;
 		}
 
-		[[nodiscard]] ad_t* release(const ad_addr_cache_t& addr_cache, void* ptr, int max_lookups) {
+		template<class addr_cache_t = alloc_descr_addr_cache_t>
+		[[nodiscard]] ad_t* release(const addr_cache_t& addr_cache, void* ptr, int max_lookups) {
 			return find(addr_cache, ptr, max_lookups);
 		}
 
@@ -198,6 +219,12 @@ namespace cuw::mem {
 			base_t::erase(descr);
 		}
 
+		// new_descr is a copy of old_descr placed into another block
+		void relocate([[maybe_unused]] ad_t* old_descr, ad_t* new_descr) {
+			assert(new_descr->list_entry.prev == old_descr->list_entry.prev && new_descr->list_entry.next == old_descr->list_entry.next);
+			base_t::relink(new_descr);
+		}
+
 		// void func(ad_t* descr)
 		template<class func_t>
 		void traverse(func_t func) {
@@ -212,7 +239,8 @@ namespace cuw::mem {
 			});
 		}
 
-		[[nodiscard]] ad_t* extract(const ad_addr_cache_t& addr_cache, void* ptr, int max_lookups) {
+		template<class addr_cache_t = alloc_descr_addr_cache_t>
+		[[nodiscard]] ad_t* extract(const addr_cache_t& addr_cache, void* ptr, int max_lookups) {
 			if (ad_t* descr = find(addr_cache, ptr, max_lookups)) {
 				return extract(descr);
 			}
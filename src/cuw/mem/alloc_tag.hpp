@@ -1,5 +1,7 @@
 #pragma once
 
+#include <cstddef>
+#include <utility>
 #include <type_traits>
 
 namespace cuw::mem {
@@ -15,6 +17,57 @@ namespace cuw::mem {
 
 		template<class type_t, class tag_t>
 		inline constexpr bool has_tag_v = has_tag_t<type_t, tag_t>::value;
+
+		template<class type_t, class = void>
+		struct has_huge_pages_t : std::false_type {};
+
+		template<class type_t>
+		struct has_huge_pages_t<type_t, std::void_t<decltype(std::declval<const type_t&>().get_huge_page_size())>> : std::true_type {};
+
+		template<class type_t, class = void>
+		struct has_reserve_t : std::false_type {};
+
+		template<class type_t>
+		struct has_reserve_t<type_t, std::void_t<
+			decltype(std::declval<type_t&>().reserve(std::size_t{}, std::size_t{})),
+			decltype(std::declval<type_t&>().commit(std::declval<void*>(), std::size_t{})),
+			decltype(std::declval<type_t&>().uncommit(std::declval<void*>(), std::size_t{}))>> : std::true_type {};
+
+		template<class type_t, class = void>
+		struct has_decommit_t : std::false_type {};
+
+		template<class type_t>
+		struct has_decommit_t<type_t, std::void_t<decltype(std::declval<type_t&>().decommit(std::declval<void*>(), std::size_t{}))>> : std::true_type {};
+
+		template<class type_t, class = void>
+		struct has_meta_alloc_t : std::false_type {};
+
+		template<class type_t>
+		struct has_meta_alloc_t<type_t, std::void_t<
+			decltype(std::declval<type_t&>().allocate_meta(std::size_t{})),
+			decltype(std::declval<type_t&>().deallocate_meta(std::declval<void*>(), std::size_t{}))>> : std::true_type {};
+
+		template<class type_t, class = void>
+		struct has_direct_alloc_t : std::false_type {};
+
+		template<class type_t>
+		struct has_direct_alloc_t<type_t, std::void_t<
+			decltype(std::declval<type_t&>().allocate_direct(std::size_t{})),
+			decltype(std::declval<type_t&>().deallocate_direct(std::declval<void*>(), std::size_t{}))>> : std::true_type {};
+
+		template<class type_t, class = void>
+		struct has_trim_t : std::false_type {};
+
+		template<class type_t>
+		struct has_trim_t<type_t, std::void_t<decltype(std::declval<type_t&>().trim(std::size_t{}))>> : std::true_type {};
+
+		template<class type_t, class = void>
+		struct has_prefault_t : std::false_type {};
+
+		template<class type_t>
+		struct has_prefault_t<type_t, std::void_t<
+			decltype(std::declval<type_t&>().prefault(std::declval<void*>(), std::size_t{})),
+			decltype(std::declval<const type_t&>().get_prefault_mode())>> : std::true_type {};
 	}
 
 	template<class type_t>
@@ -22,4 +75,32 @@ namespace cuw::mem {
 
 	template<class type_t>
 	inline constexpr bool has_sysmem_alloc_tag_v = impl::has_tag_v<type_t, sysmem_alloc_tag_t>;
+
+	// sysmem allocator provides get_huge_page_size()
+	template<class type_t>
+	inline constexpr bool has_huge_pages_v = impl::has_huge_pages_t<type_t>::value;
+
+	// sysmem allocator provides reserve(size, alignment), commit(ptr, size) & uncommit(ptr, size)
+	template<class type_t>
+	inline constexpr bool has_reserve_v = impl::has_reserve_t<type_t>::value;
+
+	// sysmem allocator provides decommit(ptr, size)
+	template<class type_t>
+	inline constexpr bool has_decommit_v = impl::has_decommit_t<type_t>::value;
+
+	// allocator provides allocate_meta(size) & deallocate_meta(ptr, size) for descriptor block pools
+	template<class type_t>
+	inline constexpr bool has_meta_alloc_v = impl::has_meta_alloc_t<type_t>::value;
+
+	// allocator provides allocate_direct(size) & deallocate_direct(ptr, size) that bypass its free memory indices
+	template<class type_t>
+	inline constexpr bool has_direct_alloc_v = impl::has_direct_alloc_t<type_t>::value;
+
+	// allocator provides trim(keep_size) that returns free memory to the system
+	template<class type_t>
+	inline constexpr bool has_trim_v = impl::has_trim_t<type_t>::value;
+
+	// sysmem allocator provides prefault(ptr, size) & get_prefault_mode()
+	template<class type_t>
+	inline constexpr bool has_prefault_v = impl::has_prefault_t<type_t>::value;
 }
\ No newline at end of file
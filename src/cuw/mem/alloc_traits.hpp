@@ -45,6 +45,7 @@ namespace cuw::mem {
 			std::void_t<enable_option_t<std::size_t, decltype(traits_t::alloc_block_pool_size)>>> {
 			static constexpr std::size_t value = traits_t::alloc_block_pool_size;
 			static_assert(value / block_size >= min_pool_blocks);
+			static_assert(value <= max_block_pool_size); // bigger pools would be capped by the free map
 		};
 
 		template<class traits_t>
@@ -61,6 +62,7 @@ namespace cuw::mem {
 			std::void_t<enable_option_t<std::size_t, decltype(traits_t::alloc_sysmem_pool_size)>>> {
 			static constexpr std::size_t value = traits_t::alloc_sysmem_pool_size;
 			static_assert(value / block_size >= min_pool_blocks);
+			static_assert(value <= max_block_pool_size); // bigger pools would be capped by the free map
 		};
 
 		template<class traits_t>
@@ -83,6 +85,302 @@ namespace cuw::mem {
 		inline constexpr std::size_t alloc_min_block_size_v = alloc_min_block_size_t<traits_t>::value;
 
 
+		template<class traits_t, class = void>
+		struct use_heap_reservation_t {
+			static constexpr bool value = default_use_heap_reservation;
+		};
+
+		template<class traits_t>
+		struct use_heap_reservation_t<traits_t,
+			std::void_t<enable_option_t<bool, decltype(traits_t::use_heap_reservation)>>> {
+			static constexpr bool value = traits_t::use_heap_reservation;
+		};
+
+		template<class traits_t>
+		inline constexpr bool use_heap_reservation_v = use_heap_reservation_t<traits_t>::value;
+
+
+		template<class traits_t, class = void>
+		struct use_region_retention_t {
+			static constexpr bool value = default_use_region_retention;
+		};
+
+		template<class traits_t>
+		struct use_region_retention_t<traits_t,
+			std::void_t<enable_option_t<bool, decltype(traits_t::use_region_retention)>>> {
+			static constexpr bool value = traits_t::use_region_retention;
+		};
+
+		template<class traits_t>
+		inline constexpr bool use_region_retention_v = use_region_retention_t<traits_t>::value;
+
+
+		template<class traits_t, class = void>
+		struct use_prefault_t {
+			static constexpr bool value = default_use_prefault;
+		};
+
+		template<class traits_t>
+		struct use_prefault_t<traits_t,
+			std::void_t<enable_option_t<bool, decltype(traits_t::use_prefault)>>> {
+			static constexpr bool value = traits_t::use_prefault;
+		};
+
+		template<class traits_t>
+		inline constexpr bool use_prefault_v = use_prefault_t<traits_t>::value;
+
+
+		template<class traits_t, class = void>
+		struct alloc_heap_reserve_size_t {
+			static constexpr std::size_t value = default_heap_reserve_size;
+		};
+
+		template<class traits_t>
+		struct alloc_heap_reserve_size_t<traits_t,
+			std::void_t<enable_option_t<std::size_t, decltype(traits_t::alloc_heap_reserve_size)>>> {
+		private:
+			static constexpr std::size_t _alloc_page_size = alloc_page_size_v<traits_t>;
+		public:
+			static constexpr std::size_t value = traits_t::alloc_heap_reserve_size;
+			static_assert(value >= _alloc_page_size);
+		};
+
+		template<class traits_t>
+		inline constexpr std::size_t alloc_heap_reserve_size_v = alloc_heap_reserve_size_t<traits_t>::value;
+
+
+		template<class traits_t, class = void>
+		struct use_meta_region_t {
+			static constexpr bool value = default_use_meta_region;
+		};
+
+		template<class traits_t>
+		struct use_meta_region_t<traits_t,
+			std::void_t<enable_option_t<bool, decltype(traits_t::use_meta_region)>>> {
+			static constexpr bool value = traits_t::use_meta_region;
+		};
+
+		template<class traits_t>
+		inline constexpr bool use_meta_region_v = use_meta_region_t<traits_t>::value;
+
+
+		template<class traits_t, class = void>
+		struct use_compact_descr_t {
+			static constexpr bool value = default_use_compact_descr;
+		};
+
+		template<class traits_t>
+		struct use_compact_descr_t<traits_t,
+			std::void_t<enable_option_t<bool, decltype(traits_t::use_compact_descr)>>> {
+			static constexpr bool value = traits_t::use_compact_descr;
+		};
+
+		template<class traits_t>
+		inline constexpr bool use_compact_descr_v = use_compact_descr_t<traits_t>::value;
+
+
+		template<class traits_t, class = void>
+		struct alloc_meta_reserve_size_t {
+			static constexpr std::size_t value = default_meta_reserve_size;
+		};
+
+		template<class traits_t>
+		struct alloc_meta_reserve_size_t<traits_t,
+			std::void_t<enable_option_t<std::size_t, decltype(traits_t::alloc_meta_reserve_size)>>> {
+		private:
+			static constexpr std::size_t _alloc_page_size = alloc_page_size_v<traits_t>;
+		public:
+			static constexpr std::size_t value = traits_t::alloc_meta_reserve_size;
+			static_assert(value >= _alloc_page_size);
+		};
+
+		template<class traits_t>
+		inline constexpr std::size_t alloc_meta_reserve_size_v = alloc_meta_reserve_size_t<traits_t>::value;
+
+
+		template<class traits_t, class = void>
+		struct alloc_meta_commit_size_t {
+			static constexpr std::size_t value = default_meta_commit_size;
+		};
+
+		template<class traits_t>
+		struct alloc_meta_commit_size_t<traits_t,
+			std::void_t<enable_option_t<std::size_t, decltype(traits_t::alloc_meta_commit_size)>>> {
+		private:
+			static constexpr std::size_t _alloc_page_size = alloc_page_size_v<traits_t>;
+		public:
+			static constexpr std::size_t value = traits_t::alloc_meta_commit_size;
+			static_assert(value >= _alloc_page_size);
+		};
+
+		template<class traits_t>
+		inline constexpr std::size_t alloc_meta_commit_size_v = alloc_meta_commit_size_t<traits_t>::value;
+
+
+		template<class traits_t, class = void>
+		struct alloc_meta_huge_page_mode_t {
+			static constexpr huge_page_mode_t value = default_meta_huge_page_mode;
+		};
+
+		template<class traits_t>
+		struct alloc_meta_huge_page_mode_t<traits_t,
+			std::void_t<enable_option_t<huge_page_mode_t, decltype(traits_t::alloc_meta_huge_page_mode)>>> {
+			static constexpr huge_page_mode_t value = traits_t::alloc_meta_huge_page_mode;
+		};
+
+		template<class traits_t>
+		inline constexpr huge_page_mode_t alloc_meta_huge_page_mode_v = alloc_meta_huge_page_mode_t<traits_t>::value;
+
+
+		template<class traits_t, class = void>
+		struct alloc_decommit_threshold_t {
+			static constexpr std::size_t value = default_decommit_threshold;
+		};
+
+		template<class traits_t>
+		struct alloc_decommit_threshold_t<traits_t,
+			std::void_t<enable_option_t<std::size_t, decltype(traits_t::alloc_decommit_threshold)>>> {
+			static constexpr std::size_t value = traits_t::alloc_decommit_threshold;
+			static_assert(value > 0);
+		};
+
+		template<class traits_t>
+		inline constexpr std::size_t alloc_decommit_threshold_v = alloc_decommit_threshold_t<traits_t>::value;
+
+
+		template<class traits_t, class = void>
+		struct alloc_decay_time_ms_t {
+			static constexpr std::int64_t value = default_decay_time_ms;
+		};
+
+		template<class traits_t>
+		struct alloc_decay_time_ms_t<traits_t,
+			std::void_t<enable_option_t<std::int64_t, decltype(traits_t::alloc_decay_time_ms)>>> {
+			static constexpr std::int64_t value = traits_t::alloc_decay_time_ms;
+		};
+
+		template<class traits_t>
+		inline constexpr std::int64_t alloc_decay_time_ms_v = alloc_decay_time_ms_t<traits_t>::value;
+
+
+		template<class traits_t, class = void>
+		struct alloc_quick_list_pages_t {
+			static constexpr std::size_t value = default_quick_list_pages;
+		};
+
+		template<class traits_t>
+		struct alloc_quick_list_pages_t<traits_t,
+			std::void_t<enable_option_t<std::size_t, decltype(traits_t::alloc_quick_list_pages)>>> {
+			static constexpr std::size_t value = traits_t::alloc_quick_list_pages;
+		};
+
+		template<class traits_t>
+		inline constexpr std::size_t alloc_quick_list_pages_v = alloc_quick_list_pages_t<traits_t>::value;
+
+
+		template<class traits_t, class = void>
+		struct alloc_quick_list_depth_t {
+			static constexpr std::size_t value = default_quick_list_depth;
+		};
+
+		template<class traits_t>
+		struct alloc_quick_list_depth_t<traits_t,
+			std::void_t<enable_option_t<std::size_t, decltype(traits_t::alloc_quick_list_depth)>>> {
+			static constexpr std::size_t value = traits_t::alloc_quick_list_depth;
+		};
+
+		template<class traits_t>
+		inline constexpr std::size_t alloc_quick_list_depth_v = alloc_quick_list_depth_t<traits_t>::value;
+
+
+		template<class traits_t, class = void>
+		struct alloc_max_quick_list_size_t {
+			static constexpr std::size_t value = default_max_quick_list_size;
+		};
+
+		template<class traits_t>
+		struct alloc_max_quick_list_size_t<traits_t,
+			std::void_t<enable_option_t<std::size_t, decltype(traits_t::alloc_max_quick_list_size)>>> {
+			static constexpr std::size_t value = traits_t::alloc_max_quick_list_size;
+		};
+
+		template<class traits_t>
+		inline constexpr std::size_t alloc_max_quick_list_size_v = alloc_max_quick_list_size_t<traits_t>::value;
+
+
+		template<class traits_t, class = void>
+		struct alloc_sysmem_queue_size_t {
+			static constexpr std::size_t value = default_sysmem_queue_size;
+		};
+
+		template<class traits_t>
+		struct alloc_sysmem_queue_size_t<traits_t,
+			std::void_t<enable_option_t<std::size_t, decltype(traits_t::alloc_sysmem_queue_size)>>> {
+			static constexpr std::size_t value = traits_t::alloc_sysmem_queue_size;
+			static_assert(value > 0);
+		};
+
+		template<class traits_t>
+		inline constexpr std::size_t alloc_sysmem_queue_size_v = alloc_sysmem_queue_size_t<traits_t>::value;
+
+
+		template<class traits_t, class = void>
+		struct alloc_huge_page_mode_t {
+			static constexpr huge_page_mode_t value = default_huge_page_mode;
+		};
+
+		template<class traits_t>
+		struct alloc_huge_page_mode_t<traits_t,
+			std::void_t<enable_option_t<huge_page_mode_t, decltype(traits_t::alloc_huge_page_mode)>>> {
+			static constexpr huge_page_mode_t value = traits_t::alloc_huge_page_mode;
+		};
+
+		template<class traits_t>
+		inline constexpr huge_page_mode_t alloc_huge_page_mode_v = alloc_huge_page_mode_t<traits_t>::value;
+
+
+		template<class traits_t, class = void>
+		struct alloc_huge_page_size_t {
+			static constexpr std::size_t value = default_huge_page_size;
+		};
+
+		template<class traits_t>
+		struct alloc_huge_page_size_t<traits_t,
+			std::void_t<enable_option_t<std::size_t, decltype(traits_t::alloc_huge_page_size)>>> {
+		private:
+			static constexpr std::size_t _alloc_page_size = alloc_page_size_v<traits_t>;
+		public:
+			static constexpr std::size_t value = traits_t::alloc_huge_page_size;
+			static_assert(is_alignment(value));
+			static_assert(value >= _alloc_page_size);
+		};
+
+		template<class traits_t>
+		inline constexpr std::size_t alloc_huge_page_size_v = alloc_huge_page_size_t<traits_t>::value;
+
+
+		template<class traits_t, class = void>
+		struct alloc_max_block_size_t {
+		private:
+			static constexpr std::size_t _alloc_min_block_size = alloc_min_block_size_v<traits_t>;
+		public:
+			static constexpr std::size_t value = std::max(default_max_block_size, _alloc_min_block_size);
+		};
+
+		template<class traits_t>
+		struct alloc_max_block_size_t<traits_t,
+			std::void_t<enable_option_t<std::size_t, decltype(traits_t::alloc_max_block_size)>>> {
+		private:
+			static constexpr std::size_t _alloc_min_block_size = alloc_min_block_size_v<traits_t>;
+		public:
+			static constexpr std::size_t value = traits_t::alloc_max_block_size;
+			static_assert(value >= _alloc_min_block_size);
+		};
+
+		template<class traits_t>
+		inline constexpr std::size_t alloc_max_block_size_v = alloc_max_block_size_t<traits_t>::value;
+
+
 		template<class traits_t, class = void>
 		struct alloc_merge_coef_t {
 			static constexpr std::size_t value = default_merge_coef;
@@ -261,7 +559,7 @@ namespace cuw::mem {
 		inline constexpr std::size_t alloc_max_slot_size_v = alloc_max_slot_size_t<traits_t>::value;
 
 
-		template<class traits_t>
+		template<class traits_t, class = void>
 		struct alloc_max_cache_size_t {
 		private:
 			static constexpr std::size_t _alloc_cache_slots = alloc_cache_slots_v<traits_t>;
@@ -270,10 +568,69 @@ namespace cuw::mem {
 			static constexpr std::size_t value = _alloc_cache_slots * _alloc_max_slot_size;
 		};
 
+		template<class traits_t>
+		struct alloc_max_cache_size_t<traits_t,
+			std::void_t<enable_option_t<std::size_t, decltype(traits_t::alloc_max_cache_size)>>> {
+		private:
+			static constexpr std::size_t _alloc_max_slot_size = alloc_max_slot_size_v<traits_t>;
+		public:
+			static constexpr std::size_t value = traits_t::alloc_max_cache_size;
+			static_assert(value >= _alloc_max_slot_size);
+		};
+
 		template<class traits_t>
 		inline constexpr std::size_t alloc_max_cache_size_v = alloc_max_cache_size_t<traits_t>::value;
 
 
+		template<class traits_t, class = void>
+		struct alloc_large_cache_slots_t {
+			static constexpr std::size_t value = default_large_cache_slots;
+		};
+
+		template<class traits_t>
+		struct alloc_large_cache_slots_t<traits_t,
+			std::void_t<enable_option_t<std::size_t, decltype(traits_t::alloc_large_cache_slots)>>> {
+			static constexpr std::size_t value = traits_t::alloc_large_cache_slots;
+			static_assert(value > 0);
+		};
+
+		template<class traits_t>
+		inline constexpr std::size_t alloc_large_cache_slots_v = alloc_large_cache_slots_t<traits_t>::value;
+
+
+		template<class traits_t, class = void>
+		struct alloc_large_cache_size_t {
+			static constexpr std::size_t value = default_large_cache_size;
+		};
+
+		template<class traits_t>
+		struct alloc_large_cache_size_t<traits_t,
+			std::void_t<enable_option_t<std::size_t, decltype(traits_t::alloc_large_cache_size)>>> {
+		private:
+			static constexpr std::size_t _alloc_page_size = alloc_page_size_v<traits_t>;
+		public:
+			static constexpr std::size_t value = traits_t::alloc_large_cache_size;
+			static_assert(is_aligned(value, _alloc_page_size));
+		};
+
+		template<class traits_t>
+		inline constexpr std::size_t alloc_large_cache_size_v = alloc_large_cache_size_t<traits_t>::value;
+
+
+		template<class traits_t>
+		struct alloc_cache_bins_t {
+		private:
+			static constexpr std::size_t _alloc_max_slot_size = alloc_max_slot_size_v<traits_t>;
+			static constexpr std::size_t _alloc_page_size = alloc_page_size_v<traits_t>;
+		public:
+			static constexpr std::size_t value = _alloc_max_slot_size / _alloc_page_size; // one bin per page count
+			static_assert(value > 0);
+		};
+
+		template<class traits_t>
+		inline constexpr std::size_t alloc_cache_bins_v = alloc_cache_bins_t<traits_t>::value;
+
+
 		template<class traits_t, class = void>
 		struct use_alloc_cache_t {
 			static constexpr bool value = default_use_alloc_cache;
@@ -289,6 +646,36 @@ namespace cuw::mem {
 		inline constexpr bool use_alloc_cache_v = use_alloc_cache_t<traits_t>::value;
 
 
+		template<class traits_t, class = void>
+		struct use_btree_addr_index_t {
+			static constexpr bool value = default_use_btree_addr_index;
+		};
+
+		template<class traits_t>
+		struct use_btree_addr_index_t<traits_t,
+			std::void_t<enable_option_t<bool, decltype(traits_t::use_btree_addr_index)>>> {
+			static constexpr bool value = traits_t::use_btree_addr_index;
+		};
+
+		template<class traits_t>
+		inline constexpr bool use_btree_addr_index_v = use_btree_addr_index_t<traits_t>::value;
+
+
+		template<class traits_t, class = void>
+		struct use_page_map_t {
+			static constexpr bool value = default_use_page_map;
+		};
+
+		template<class traits_t>
+		struct use_page_map_t<traits_t,
+			std::void_t<enable_option_t<bool, decltype(traits_t::use_page_map)>>> {
+			static constexpr bool value = traits_t::use_page_map;
+		};
+
+		template<class traits_t>
+		inline constexpr bool use_page_map_v = use_page_map_t<traits_t>::value;
+
+
 		template<class traits_t, class = void>
 		struct use_locking_t {
 			static constexpr bool value = default_use_locking;
@@ -319,6 +706,21 @@ namespace cuw::mem {
 		inline constexpr bool use_dirty_optimization_hacks_v = use_dirty_optimization_hacks_t<traits_t>::value;
 
 
+		template<class traits_t, class = void>
+		struct use_tlsf_page_alloc_t {
+			static constexpr bool value = default_use_tlsf_page_alloc;
+		};
+
+		template<class traits_t>
+		struct use_tlsf_page_alloc_t<traits_t,
+			std::void_t<enable_option_t<bool, decltype(traits_t::use_tlsf_page_alloc)>>> {
+			static constexpr bool value = traits_t::use_tlsf_page_alloc;
+		};
+
+		template<class traits_t>
+		inline constexpr bool use_tlsf_page_alloc_v = use_tlsf_page_alloc_t<traits_t>::value;
+
+
 		template<class traits_t>
 		struct check_alloc_cache_t {
 		private:
@@ -384,6 +786,21 @@ namespace cuw::mem {
 
 		template<class traits_t>
 		inline constexpr attrs_t alloc_raw_bin_count_v = alloc_raw_bin_count_t<traits_t>::value;
+
+
+		template<class traits_t, class = void>
+		struct alloc_direct_threshold_t {
+			static constexpr std::size_t value = default_direct_threshold;
+		};
+
+		template<class traits_t>
+		struct alloc_direct_threshold_t<traits_t,
+			std::void_t<enable_option_t<std::size_t, decltype(traits_t::alloc_direct_threshold)>>> {
+			static constexpr std::size_t value = traits_t::alloc_direct_threshold;
+		};
+
+		template<class traits_t>
+		inline constexpr std::size_t alloc_direct_threshold_v = alloc_direct_threshold_t<traits_t>::value;
 	}
 
 	struct empty_traits_t {};
@@ -392,12 +809,32 @@ namespace cuw::mem {
 	struct page_alloc_traits_t {
 		static constexpr bool use_resolved_page_size = impl::use_resolved_page_size_v<traits_t>;
 		static constexpr bool use_dirty_optimization_hacks = impl::use_dirty_optimization_hacks_v<traits_t>;
+		static constexpr bool use_tlsf_page_alloc = impl::use_tlsf_page_alloc_v<traits_t>;
+		static constexpr bool use_heap_reservation = impl::use_heap_reservation_v<traits_t>;
+		static constexpr bool use_region_retention = impl::use_region_retention_v<traits_t>;
+		static constexpr bool use_prefault = impl::use_prefault_v<traits_t>;
+		static constexpr bool use_meta_region = impl::use_meta_region_v<traits_t>;
+		static constexpr bool use_compact_descr = impl::use_compact_descr_v<traits_t>; // only with the metadata region
 
 		static constexpr std::size_t alloc_page_size = impl::alloc_page_size_v<traits_t>;
 		static constexpr std::size_t alloc_block_pool_size = impl::alloc_block_pool_size_v<traits_t>;
 		static constexpr std::size_t alloc_sysmem_pool_size = impl::alloc_sysmem_pool_size_v<traits_t>;
 		static constexpr std::size_t alloc_min_block_size = impl::alloc_min_block_size_v<traits_t>;
+		static constexpr std::size_t alloc_max_block_size = impl::alloc_max_block_size_v<traits_t>;
 		static constexpr std::size_t alloc_merge_coef = impl::alloc_merge_coef_v<traits_t>; // unused
+		static constexpr std::size_t alloc_decommit_threshold = impl::alloc_decommit_threshold_v<traits_t>;
+		static constexpr std::int64_t alloc_decay_time_ms = impl::alloc_decay_time_ms_v<traits_t>; // < 0 - never, 0 - immediately
+		static constexpr std::size_t alloc_quick_list_pages = impl::alloc_quick_list_pages_v<traits_t>; // 0 - no quick lists
+		static constexpr std::size_t alloc_quick_list_depth = impl::alloc_quick_list_depth_v<traits_t>;
+		static constexpr std::size_t alloc_max_quick_list_size = impl::alloc_max_quick_list_size_v<traits_t>;
+		static constexpr std::size_t alloc_sysmem_queue_size = impl::alloc_sysmem_queue_size_v<traits_t>;
+		static constexpr std::size_t alloc_heap_reserve_size = impl::alloc_heap_reserve_size_v<traits_t>;
+		static constexpr std::size_t alloc_meta_reserve_size = impl::alloc_meta_reserve_size_v<traits_t>;
+		static constexpr std::size_t alloc_meta_commit_size = impl::alloc_meta_commit_size_v<traits_t>;
+
+		static constexpr huge_page_mode_t alloc_huge_page_mode = impl::alloc_huge_page_mode_v<traits_t>;
+		static constexpr std::size_t alloc_huge_page_size = impl::alloc_huge_page_size_v<traits_t>;
+		static constexpr huge_page_mode_t alloc_meta_huge_page_mode = impl::alloc_meta_huge_page_mode_v<traits_t>;
 	};
 
 	template<class traits_t>
@@ -406,6 +843,9 @@ namespace cuw::mem {
 		static constexpr std::size_t alloc_min_slot_size = impl::alloc_min_slot_size_v<traits_t>;
 		static constexpr std::size_t alloc_max_slot_size = impl::alloc_max_slot_size_v<traits_t>;
 		static constexpr std::size_t alloc_max_cache_size = impl::alloc_max_cache_size_v<traits_t>;
+		static constexpr std::size_t alloc_cache_bins = impl::alloc_cache_bins_v<traits_t>;
+		static constexpr std::size_t alloc_large_cache_slots = impl::alloc_large_cache_slots_v<traits_t>;
+		static constexpr std::size_t alloc_large_cache_size = impl::alloc_large_cache_size_v<traits_t>;
 	};
 
 	template<class traits_t>
@@ -420,12 +860,15 @@ namespace cuw::mem {
 		static constexpr int alloc_raw_cache_lookups = impl::alloc_raw_cache_lookups_v<traits_t>;
 
 		static constexpr bool use_alloc_cache = impl::use_alloc_cache_v<traits_t>;
+		static constexpr bool use_btree_addr_index = impl::use_btree_addr_index_v<traits_t>;
+		static constexpr bool use_page_map = impl::use_page_map_v<traits_t>;
 		static constexpr bool use_locking = impl::use_locking_v<traits_t>;
 
 		static constexpr attrs_t alloc_min_chunk_size_log2 = impl::alloc_min_chunk_size_log2_v<traits_t>;
 		static constexpr attrs_t alloc_max_chunk_size_log2 = impl::alloc_max_chunk_size_log2_v<traits_t>;
 
 		static constexpr attrs_t alloc_raw_bin_count = impl::alloc_raw_bin_count_v<traits_t>;
+		static constexpr std::size_t alloc_direct_threshold = impl::alloc_direct_threshold_v<traits_t>;
 
 		static_assert(impl::check_alloc_cache_v<traits_t>);
 	};
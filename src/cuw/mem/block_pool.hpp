@@ -9,11 +9,11 @@ namespace cuw::mem {
 	// in-memory data structure
 	// list_entry(2*64): this is a list entry:)
 	// size(48): size of memory block
-	// capacity(16): maximum count of possibly allocated blocks
-	// used(16) : current capacity
+	// capacity(16): maximum count of possibly allocated blocks, at most block_pool_map_size (rest of bigger pool is unused)
+	// used(16) : high-water mark, blocks below it were allocated at least once
 	// count(16) : allocated blocks
-	// head(16) : index of the next allocated block
-	// reserved(4*64) : reserved, no use
+	// hint(16) : first word of free_map that can have free blocks
+	// free_map(4*64) : bit is set if block is free, free blocks are not touched so lowest free block is found in the header
 	struct alignas(block_align) block_pool_t {
 		using bp_t = block_pool_t;
 		using bpl_t = block_pool_list_t;
@@ -23,8 +23,9 @@ namespace cuw::mem {
 		}
 
 		// offset is zero-based and means offset from the first possible allocated block (not primary block)
+		template<std::size_t slot_size = block_size>
 		static bp_t* primary_block(void* block, attrs_t offset) {
-			return transform_ptr<bp_t>(block, -(std::ptrdiff_t)((offset + 1) * block_size));
+			return transform_ptr<bp_t>(block, -(std::ptrdiff_t)(offset * slot_size + block_size));
 		}
 
 		static attrs_t primary_offset(bp_t* primary_block, void* block) {
@@ -44,9 +45,9 @@ namespace cuw::mem {
 		}
 
 		bpl_t list_entry;
-		attrs_t niggers:16, size:48;
-		attrs_t capacity:16, used:16, count:16, head:16;
-		attrs_t reserved[4];
+		attrs_t reserved:16, size:48;
+		attrs_t capacity:16, used:16, count:16, hint:16;
+		attrs_t free_map[block_pool_map_words];
 	};
 
 	static_assert(do_fits_block<block_pool_t>);
@@ -56,45 +57,60 @@ namespace cuw::mem {
 		attrs_t index{};
 	};
 
-	class block_pool_wrapper_t {
+	// pool header takes the first block, data segment is split into slots of slot_size bytes
+	template<std::size_t slot_size>
+	class basic_block_pool_wrapper_t {
 	public:
 		using bp_t = block_pool_t;
 
-		block_pool_wrapper_t(bp_t* _pool) : pool{_pool} {}
+		static_assert(is_alignment(slot_size) && slot_size <= block_size);
+
+		basic_block_pool_wrapper_t(bp_t* _pool) : pool{_pool} {}
 		
 	private:
 		// index start from 0 from the start of the data segment (not counting first block)
 		void* get_block(attrs_t index) const {
-			return (char*)get_data() + index * block_size;
+			return (char*)get_data() + index * slot_size;
 		}
 
 	public:
+		// all blocks are free
+		void init_map() {
+			for (attrs_t word = 0; word < block_pool_map_words; word++) {
+				attrs_t first = word * 64;
+				attrs_t bits = pool->capacity > first ? std::min<attrs_t>(pool->capacity - first, 64) : 0;
+				pool->free_map[word] = bits == 64 ? ~(attrs_t)0 : ((attrs_t)1 << bits) - 1;
+			}
+			pool->hint = 0;
+		}
+
 		// index is zero-based, zero block is the first block after pool block
+		// the lowest free block is returned so live blocks are packed at the start of the pool
 		[[nodiscard]] block_info_t acquire() {
-			attrs_t index = 0;
-			void* block = nullptr;
-			if (pool->head != block_pool_head_empty) {
-				index = pool->head;
-				block = get_block(index);
-				pool->count++;
-				pool->head = ((pool_hdr_t*)block)->next;
-			} else if (pool->used < pool->capacity) {
-				index = pool->used++;
-				block = get_block(index);
-				pool->count++;
-			} else {
-				return {nullptr, block_pool_head_empty};
+			for (attrs_t word = pool->hint; word < block_pool_map_words; word++) {
+				if (attrs_t free_bits = pool->free_map[word]) {
+					attrs_t index = word * 64 + std::countr_zero(free_bits);
+					pool->free_map[word] = free_bits & (free_bits - 1);
+					pool->hint = word;
+					pool->used = std::max<attrs_t>(pool->used, index + 1);
+					pool->count++;
+					return {get_block(index), index};
+				}
 			}
-
-			return {block, index};
+			pool->hint = block_pool_map_words;
+			return {nullptr, block_pool_head_empty};
 		}
 
 		// index is zero-based, zero block is the first block after pool block
 		void release(void* block, attrs_t index) {
-			assert(is_aligned(block, block_align));
+			assert(is_aligned(block, slot_size));
 			assert(index < pool->capacity);
-			((pool_hdr_t*)block)->next = pool->head;
-			pool->head = index;
+
+			attrs_t word = index / 64;
+			attrs_t bit = (attrs_t)1 << (index % 64);
+			assert(!(pool->free_map[word] & bit));
+			pool->free_map[word] |= bit;
+			pool->hint = std::min<attrs_t>(pool->hint, word);
 			pool->count--;
 		}
 
@@ -134,6 +150,8 @@ namespace cuw::mem {
 		bp_t* pool{};
 	};
 
+	using block_pool_wrapper_t = basic_block_pool_wrapper_t<block_size>;
+
 	class block_pool_list_cache_t : public list_cache_t<block_pool_list_t> {
 	public:
 		using bp_t = block_pool_t;
@@ -209,6 +227,12 @@ namespace cuw::mem {
 			free_entries.release_all(func);
 		}
 
+		// void func(bp_t*), pool can be erased inside of func
+		template<class func_t>
+		void traverse_free(func_t func) {
+			free_entries.traverse([&] (bpl_t* bpl) { func(bp_t::list_entry_to_block(bpl)); });
+		}
+
 	private:
 		bpl_cache_t full_entries{};
 		bpl_cache_t free_entries{};
@@ -219,20 +243,22 @@ namespace cuw::mem {
 		NoReinsertFree,
 	};
 
-	class block_pool_entry_t : protected block_pool_cache_t {
+	template<std::size_t slot_size>
+	class basic_block_pool_entry_t : protected block_pool_cache_t {
 	public:
 		using bp_t = block_pool_t;
 		using base_t = block_pool_cache_t;
+		using block_pool_wrapper_t = basic_block_pool_wrapper_t<slot_size>;
 
-		block_pool_entry_t() = default;
+		basic_block_pool_entry_t() = default;
 
-		block_pool_entry_t(const block_pool_entry_t&) = delete;
-		block_pool_entry_t(block_pool_entry_t&& another) noexcept {
+		basic_block_pool_entry_t(const basic_block_pool_entry_t&) = delete;
+		basic_block_pool_entry_t(basic_block_pool_entry_t&& another) noexcept {
 			*this = std::move(another);
 		}
 
-		block_pool_entry_t& operator = (const block_pool_entry_t&) = delete;
-		block_pool_entry_t& operator = (block_pool_entry_t&& another) noexcept {
+		basic_block_pool_entry_t& operator = (const basic_block_pool_entry_t&) = delete;
+		basic_block_pool_entry_t& operator = (basic_block_pool_entry_t&& another) noexcept {
 			if (this != & another) {
 				(base_t&)*this = std::move(another);
 				total_capacity = std::exchange(another.total_capacity, 0);
@@ -246,11 +272,14 @@ namespace cuw::mem {
 			assert(size >= 2 * block_size);
 			assert(is_aligned(mem, block_size));
 
-			std::size_t capacity = std::min<std::size_t>(max_pool_blocks, size / block_size - 1);
+			std::size_t capacity = std::min<std::size_t>(block_pool_map_size, (size - block_size) / slot_size);
 
 			bp_t* bp = new (mem) bp_t {
-				.size = size, .capacity = capacity, .head = block_pool_head_empty
+				.list_entry = {}, .reserved = 0, .size = size,
+				.capacity = capacity, .used = 0, .count = 0, .hint = 0,
+				.free_map = {}
 			};
+			block_pool_wrapper_t{bp}.init_map();
 
 			base_t::insert(bp);
 			total_capacity += capacity;
@@ -277,7 +306,7 @@ namespace cuw::mem {
 
 		// returns pool descriptor(block_pool) when it becomes empty
 		bp_t* release(void* block_mem, attrs_t block_offset, block_pool_release_mode_t mode = block_pool_release_mode_t::ReinsertFree) {
-			bp_t* primary_block = bp_t::primary_block(block_mem, block_offset);
+			bp_t* primary_block = bp_t::template primary_block<slot_size>(block_mem, block_offset);
 
 			block_pool_wrapper_t pool{primary_block};
 
@@ -307,6 +336,53 @@ namespace cuw::mem {
 			count = 0;
 		}
 
+		// void func(void* mem, std::size_t size)
+		// empty pools that were left by NoReinsertFree release are released, returns how many bytes were released
+		template<class func_t>
+		std::size_t release_empty(func_t func) {
+			std::size_t released = 0;
+			base_t::traverse_free([&] (bp_t* bp) {
+				if (block_pool_wrapper_t{bp}.empty()) {
+					released += bp->get_size();
+					finish_release(bp, func);
+				}
+			});
+			return released;
+		}
+
+		// pools having at most 1/sparse_ratio of their blocks in use are isolated: they are moved to the full list so acquire() skips them
+		// pool is isolated only if its blocks fit into spare blocks of the remaining pools, returns count of isolated pools
+		std::size_t isolate_sparse(bp_t** isolated, std::size_t max_isolated, attrs_t sparse_ratio) {
+			std::size_t spare = total_capacity - count;
+			std::size_t isolated_count = 0;
+			base_t::traverse_free([&] (bp_t* bp) {
+				block_pool_wrapper_t pool{bp};
+				attrs_t used = pool.get_count();
+				if (isolated_count < max_isolated && used != 0 && used * sparse_ratio <= pool.get_capacity() && pool.get_capacity() <= spare) {
+					spare -= pool.get_capacity();
+					isolated[isolated_count++] = bp;
+					base_t::reinsert_full(bp);
+				}
+			});
+			return isolated_count;
+		}
+
+		// void func(void* mem, std::size_t size)
+		// isolated pools that became empty are released, the rest are returned to the free list, returns how many bytes were released
+		template<class func_t>
+		std::size_t release_isolated(bp_t** isolated, std::size_t isolated_count, func_t func) {
+			std::size_t released = 0;
+			for (std::size_t i = 0; i < isolated_count; i++) {
+				if (bp_t* bp = isolated[i]; block_pool_wrapper_t{bp}.empty()) {
+					released += bp->get_size();
+					finish_release(bp, func);
+				} else {
+					base_t::reinsert_free(bp);
+				}
+			}
+			return released;
+		}
+
 		std::size_t get_count() const {
 			return count;
 		}
@@ -319,4 +395,6 @@ namespace cuw::mem {
 		std::size_t count{};
 		std::size_t total_capacity{};
 	};
+
+	using block_pool_entry_t = basic_block_pool_entry_t<block_size>;
 }
\ No newline at end of file
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <chrono>
+
 #include "core.hpp"
 #include "alloc_tag.hpp"
 
@@ -9,6 +11,14 @@ namespace cuw::mem {
 		Any,
 	};
 
+	// cache of free page blocks segregated by page count
+	// bin i stores blocks of (i + 1) pages, each bin is a LIFO stack so the most recently freed block is reused first
+	// slots(entries) are stored inside of the allocator so cached memory itself is never touched
+	// total amount of cached memory is limited by alloc_max_cache_size
+	// blocks bigger than alloc_max_slot_size (up to alloc_large_cache_size) go into the separate large cache:
+	// they are reused only with exact size, budget is alloc_large_cache_size, least recently freed block is evicted first
+	// and blocks that stayed unused longer than decay time are returned to the base allocator
+	// large cache is disabled by default (alloc_large_cache_size is zero), trim() flushes it
 	template<class basic_alloc_t>
 	class cached_alloc_t : public basic_alloc_t {
 	public:
@@ -16,9 +26,14 @@ namespace cuw::mem {
 		static_assert(has_sysmem_alloc_tag_v<base_t>);
 
 		template<class ... args_t>
-		cached_alloc_t(args_t&& ... args) : base_t(std::forward<args_t>(args)...) {}
+		cached_alloc_t(args_t&& ... args) : base_t(std::forward<args_t>(args)...) {
+			init_slots();
+		}
+
+		cached_alloc_t() {
+			init_slots();
+		}
 
-		cached_alloc_t() = default;
 		cached_alloc_t(cached_alloc_t&&) noexcept = delete;
 		cached_alloc_t(const cached_alloc_t&) = delete;
 
@@ -33,126 +48,242 @@ namespace cuw::mem {
 		static constexpr std::size_t slot_count = base_t::alloc_cache_slots;
 		static constexpr std::size_t min_slot_size = base_t::alloc_min_slot_size;
 		static constexpr std::size_t max_slot_size = base_t::alloc_max_slot_size;
+		static constexpr std::size_t max_cache_size = base_t::alloc_max_cache_size;
+
+		static constexpr std::size_t bin_count = base_t::alloc_cache_bins;
+		static constexpr std::size_t mask_bits = 64;
+		static constexpr std::size_t mask_count = (bin_count + mask_bits - 1) / mask_bits;
+		static constexpr std::size_t bin_empty = bin_count;
 
 		struct slot_t {
-			void* allocate(std::size_t alloc_size) {
-				if (size < alloc_size) {
-					return nullptr;
-				}
-				void* allocated = ptr;
-				if (alloc_size != size) {
-					ptr = (char*)ptr + alloc_size;
-					size -= alloc_size;
-				} else {
-					ptr = nullptr;
-					size = 0;
-				} return allocated;
+			slot_t* next{};
+			void* ptr{};
+		};
+
+		static constexpr std::size_t large_slot_count = base_t::alloc_large_cache_slots;
+		static constexpr std::size_t max_large_cache_size = base_t::alloc_large_cache_size;
+
+		// ptr is nullptr if slot is unused, stamp orders blocks by the time they were freed
+		struct large_slot_t {
+			void* ptr{};
+			std::size_t size{};
+			std::uint64_t stamp{};
+			std::uint64_t freed_ms{};
+		};
+
+		void init_slots() {
+			for (auto& slot : slots) {
+				slot.next = unused;
+				unused = &slot;
 			}
+		}
 
-			void reset() {
-				ptr = nullptr;
-				size = 0;
+		// returns bin_empty if block cannot be stored in any bin
+		std::size_t get_bin_index(std::size_t size) const {
+			std::size_t pages = size / base_t::get_page_size();
+			if (pages == 0 || pages > bin_count) {
+				return bin_empty;
+			} return pages - 1;
+		}
+
+		std::size_t get_bin_size(std::size_t index) const {
+			return (index + 1) * base_t::get_page_size();
+		}
+
+		// first non-empty bin with index greater than or equal to the given one
+		std::size_t find_bin(std::size_t index) const {
+			if (index >= bin_count) {
+				return bin_empty;
 			}
 
-			bool is_null() const {
-				return ptr == nullptr;
+			std::size_t word = index / mask_bits;
+			std::uint64_t bits = bin_mask[word] & (~(std::uint64_t)0 << (index % mask_bits));
+			while (true) {
+				if (bits) {
+					return word * mask_bits + std::countr_zero(bits);
+				} if (++word == mask_count) {
+					return bin_empty;
+				} bits = bin_mask[word];
 			}
+		}
 
-			void* get_ptr() const {
-				return ptr;
+		void push_slot(std::size_t index, void* ptr) {
+			assert(unused);
+
+			slot_t* slot = unused;
+			unused = slot->next;
+			slot->ptr = ptr;
+			slot->next = bins[index];
+			bins[index] = slot;
+			bin_mask[index / mask_bits] |= (std::uint64_t)1 << (index % mask_bits);
+			cached_size += get_bin_size(index);
+		}
+
+		void* pop_slot(std::size_t index) {
+			slot_t* slot = bins[index];
+			assert(slot);
+
+			bins[index] = slot->next;
+			if (!bins[index]) {
+				bin_mask[index / mask_bits] &= ~((std::uint64_t)1 << (index % mask_bits));
 			}
+			slot->next = unused;
+			unused = slot;
+			cached_size -= get_bin_size(index);
+			return slot->ptr;
+		}
 
-			std::size_t get_size() const {
-				return size;
+		// try to cache block, returns false if block is not suitable or cache is full
+		bool try_cache(void* ptr, std::size_t size) {
+			if (size < min_slot_size || size > max_slot_size || !unused || cached_size + size > max_cache_size) {
+				return false;
 			}
 
-			std::tuple<void*, std::size_t> to_tuple() const {
-				return std::make_tuple(ptr, size);
+			std::size_t index = get_bin_index(size);
+			if (index == bin_empty || get_bin_size(index) != size) {
+				return false;
 			}
 
-			// if ptr is 0 then size is zero
-			void* ptr{};
-			std::size_t size{};
-		};
+			push_slot(index, ptr);
+			return true;
+		}
 
-		// find appropriate slot and allocate from it
+		// find appropriate bin and allocate from it, the rest of the block is cached again or returned
 		void* allocate_from_slots(std::size_t size) {
 			assert(size != 0);
-			for (auto& slot : slots) {
-				void* ptr = slot.allocate(size);
-				if (!ptr) {
-					continue;
-				}
 
-				if (!slot.is_null() && slot.get_size() < min_slot_size) {
-					base_t::deallocate(slot.get_ptr(), slot.get_size());
-					slot.reset();
-				}
+			std::size_t index = find_bin(get_bin_index(size));
+			if (index == bin_empty) {
+				return nullptr;
+			}
 
-				return ptr;
+			void* ptr = pop_slot(index);
+			std::size_t rest_size = get_bin_size(index) - size;
+			if (rest_size != 0) {
+				fill_slots(advance_ptr(ptr, size), rest_size);
 			}
+			return ptr;
+		}
+
+		void fill_slots(void* ptr, std::size_t size) {
+			assert(ptr);
+			assert(size != 0);
+
+			if (!try_cache(ptr, size) && !try_cache_large(ptr, size)) {
+				base_t::deallocate(ptr, size);
+			}
+		}
 
-			return nullptr;
+	private:
+		static std::uint64_t get_time_ms() {
+			auto now = std::chrono::steady_clock::now().time_since_epoch();
+			return std::chrono::duration_cast<std::chrono::milliseconds>(now).count();
+		}
+
+		static bool is_large(std::size_t size) {
+			return size > max_slot_size && size <= max_large_cache_size;
 		}
 
-		// find slot of maximum capacity and allocate whole memory from it, can be empty
-		std::tuple<void*, std::size_t> allocate_max() {
-			auto& slot = *std::max_element(std::begin(slots), std::end(slots), [&] (auto& s0, auto& s1) {
-				return s0.get_size() < s1.get_size();
-			});
+		void evict_large(large_slot_t& slot) {
+			assert(slot.ptr);
 
-			auto alloc = slot.to_tuple();
-			slot.reset();
-			return alloc;
+			base_t::deallocate(slot.ptr, slot.size);
+			large_cached_size -= slot.size;
+			slot.ptr = nullptr;
 		}
 
-		void fill_slots(void* ptr, std::size_t size) {
-			assert(ptr);
-			assert(size != 0);
+		// blocks that stayed in the cache for decay time are evicted
+		void decay_large(std::uint64_t now_ms) {
+			if (large_decay_time_ms < 0) {
+				return;
+			}
 
-			std::sort(std::begin(slots), std::end(slots), [&] (auto& a, auto& b) {
-				return a.get_size() < b.get_size();
-			});
+			for (auto& slot : large_slots) {
+				if (slot.ptr && now_ms - slot.freed_ms >= (std::uint64_t)large_decay_time_ms) {
+					evict_large(slot);
+				}
+			}
+		}
 
-			slot_t chunk{ptr, size};
-			for (auto& slot : slots) {
-				std::size_t slot_size = std::min(chunk.get_size(), max_slot_size);
-				if (slot_size < min_slot_size) {
-					break;
+		// least recently freed block
+		large_slot_t* find_lru_large() {
+			large_slot_t* lru = nullptr;
+			for (auto& slot : large_slots) {
+				if (slot.ptr && (!lru || slot.stamp < lru->stamp)) {
+					lru = &slot;
 				}
-				
-				if (slot.get_size() < slot_size) {
-					if (!slot.is_null()) {
-						base_t::deallocate(slot.get_ptr(), slot.get_size());
-					} slot = slot_t{chunk.allocate(slot_size), slot_size};
+			} return lru;
+		}
+
+		// the most recently freed block of exactly the same size is reused
+		void* allocate_large(std::size_t size) {
+			decay_large(get_time_ms());
+
+			large_slot_t* found = nullptr;
+			for (auto& slot : large_slots) {
+				if (slot.ptr && slot.size == size && (!found || slot.stamp > found->stamp)) {
+					found = &slot;
 				}
-				
-				if (chunk.is_null()) {
+			} if (!found) {
+				return nullptr;
+			}
+
+			large_cached_size -= size;
+			return std::exchange(found->ptr, nullptr);
+		}
+
+		// least recently freed blocks are evicted to make room for the new one
+		bool try_cache_large(void* ptr, std::size_t size) {
+			if (!is_large(size)) {
+				return false;
+			}
+
+			std::uint64_t now_ms = get_time_ms();
+			decay_large(now_ms);
+
+			large_slot_t* free_slot = nullptr;
+			for (auto& slot : large_slots) {
+				if (!slot.ptr) {
+					free_slot = &slot;
 					break;
 				}
 			}
-			
-			if (!chunk.is_null()) {
-				base_t::deallocate(chunk.get_ptr(), chunk.get_size());
+			while (!free_slot || large_cached_size + size > max_large_cache_size) {
+				large_slot_t* lru = find_lru_large();
+				assert(lru); // block fits into empty cache
+				evict_large(*lru);
+				if (!free_slot) {
+					free_slot = lru;
+				}
 			}
+
+			*free_slot = {ptr, size, ++large_stamp, now_ms};
+			large_cached_size += size;
+			return true;
+		}
+
+		void* allocate_cached(std::size_t size) {
+			if (is_large(size)) {
+				return allocate_large(size);
+			} return allocate_from_slots(size);
 		}
 
 	public:
 		void* allocate(std::size_t size) {
 			size = align_value(size, base_t::get_page_size());
-			if (void* ptr = allocate_from_slots(size)) {
+			if (void* ptr = allocate_cached(size)) {
 				return ptr;
-			}	
+			}
 			return base_t::allocate(size);
 		}
 
 		void deallocate(void* ptr, std::size_t size) {
-			fill_slots(ptr, size);
+			fill_slots(ptr, align_value(size, base_t::get_page_size()));
 		}
 
 		void* reallocate(void* old_ptr, std::size_t old_size, std::size_t new_size) {
-			if (void* new_ptr = allocate_from_slots(new_size)) {
-				std::memcpy(new_ptr, old_ptr, old_size);
+			if (void* new_ptr = allocate_cached(align_value(new_size, base_t::get_page_size()))) {
+				std::memcpy(new_ptr, old_ptr, std::min(old_size, new_size));
 				deallocate(old_ptr, old_size);
 				return new_ptr;
 			}
@@ -160,21 +291,20 @@ namespace cuw::mem {
 		}
 
 	public:
+		// Any: whole cached block is returned if there is one that can satisfy request
 		std::tuple<void*, std::size_t> allocate_ext(std::size_t size, cached_alloc_flags_t flags) {
+			size = align_value(size, base_t::get_page_size());
 			switch (flags) {
 				case cached_alloc_flags_t::Exact: {
 					return {allocate(size), size};
 				}
-				
+
 				case cached_alloc_flags_t::Any: {
-					// TODO : we scan slots here twice, maybe it'd be better if we scan them once?
-					if (void* ptr = allocate_from_slots(size); ptr) {
-						return {ptr, size};
-					} if (auto [ptr, true_size] = allocate_max(); ptr) {
-						return {ptr, true_size};
-					} return base_t::allocate(size);
+					if (std::size_t index = find_bin(get_bin_index(size)); index != bin_empty) {
+						return {pop_slot(index), get_bin_size(index)};
+					} return {base_t::allocate(size), size};
 				}
-				
+
 				default: {
 					std::abort();
 				}
@@ -182,15 +312,52 @@ namespace cuw::mem {
 		}
 
 		void flush_slots() {
-			for (auto& slot : slots) {
-				if (!slot.is_null()) {
-					base_t::deallocate(slot.get_ptr(), slot.get_size());
-					slot.reset();
+			for (std::size_t index = find_bin(0); index != bin_empty; index = find_bin(index)) {
+				std::size_t size = get_bin_size(index);
+				while (bins[index]) {
+					base_t::deallocate(pop_slot(index), size);
+				}
+			}
+
+			for (auto& slot : large_slots) {
+				if (slot.ptr) {
+					evict_large(slot);
 				}
 			}
 		}
 
+		// large blocks unused for time_ms are returned to the base allocator on the next large allocation or deallocation
+		// negative value disables decay so large blocks are evicted only when the cache is full
+		void set_large_cache_decay_time(std::int64_t time_ms) {
+			large_decay_time_ms = time_ms;
+		}
+
+		// cached blocks are returned to the base allocator first
+		std::size_t trim(std::size_t keep_size = 0) {
+			flush_slots();
+			if constexpr(has_trim_v<base_t>) {
+				return base_t::trim(keep_size);
+			} return 0;
+		}
+
+		std::size_t get_cached_size() const {
+			return cached_size;
+		}
+
+		std::size_t get_large_cached_size() const {
+			return large_cached_size;
+		}
+
 	private:
 		slot_t slots[slot_count] = {};
+		slot_t* unused{};
+		slot_t* bins[bin_count] = {};
+		std::uint64_t bin_mask[mask_count] = {};
+		std::size_t cached_size{};
+
+		large_slot_t large_slots[large_slot_count] = {};
+		std::uint64_t large_stamp{};
+		std::int64_t large_decay_time_ms{default_decay_time_ms};
+		std::size_t large_cached_size{};
 	};
-}
\ No newline at end of file
+}
@@ -4,7 +4,9 @@
 
 namespace cuw::mem {
 	namespace impl {
-		struct config_traits_t{};
+		struct config_traits_t {
+			static constexpr bool use_page_map = true; // free() finds the pool of a chunk so it can be cached per CPU
+		};
 	}
 
 	struct config_traits_t
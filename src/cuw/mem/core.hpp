@@ -14,10 +14,13 @@
 
 #include <cuw/utils/ptr.hpp>
 #include <cuw/utils/bst.hpp>
+#include <cuw/utils/btree.hpp>
 #include <cuw/utils/trb.hpp>
 #include <cuw/utils/list.hpp>
 #include <cuw/utils/trb_node.hpp>
 
+#include "mem_api.hpp"
+
 namespace cuw::mem {
 	using ptr_t = std::uintptr_t;
 	using attrs_t = std::uint64_t;
@@ -38,14 +41,55 @@ namespace cuw::mem {
 	inline constexpr std::size_t block_align = 64;
 	inline constexpr std::size_t block_size = 64;
 
+	inline constexpr std::size_t compact_block_size = 32; // slot of a compact descriptor
+	inline constexpr std::size_t compact_unit_bits = 12; // compact descriptors keep addresses & sizes in 4K units
+	inline constexpr std::size_t compact_unit_size = (std::size_t)1 << compact_unit_bits;
+
+	inline constexpr attrs_t block_pool_map_words = 4;
+	inline constexpr attrs_t block_pool_map_size = block_pool_map_words * 64; // pool can't have more blocks than bits in the map
+	inline constexpr std::size_t max_block_pool_size = (block_pool_map_size + 1) * block_size; // map blocks + primary block
+
 	inline constexpr bool default_use_resolved_page_size = false;
 	inline constexpr bool default_use_dirty_optimization_hacks = false; // switch on/off some functionality
+	inline constexpr bool default_use_tlsf_page_alloc = false; // use segregated fit page allocator instead of tree-based one
+	inline constexpr bool default_use_heap_reservation = false; // reserve one contiguous heap range and commit it incrementally
+	inline constexpr bool default_use_region_retention = true; // free regions stay mapped while free memory is below one growth step
+	inline constexpr bool default_use_prefault = false; // populate new regions with physical pages when they are mapped
+	inline constexpr bool default_use_meta_region = true; // descriptor block pools are packed into one contiguous region
+	inline constexpr bool default_use_compact_descr = true; // page allocator descriptors take 32-byte slots of the metadata region
 
 	inline constexpr std::size_t default_page_size = 1 << 12; // 4K
 	inline constexpr std::size_t default_block_pool_size = 1 << 12; // 4K
+	static_assert(default_block_pool_size <= max_block_pool_size);
 	inline constexpr std::size_t default_sysmem_pool_size = 1 << 12; // 4K
 	inline constexpr std::size_t default_min_block_size = (std::size_t)1 << 20; // 1M
+	inline constexpr std::size_t default_max_block_size = (std::size_t)1 << 26; // 64M, new regions grow with heap size up to this
 	inline constexpr std::size_t default_merge_coef = 4;
+	inline constexpr std::size_t default_heap_reserve_size = (std::size_t)1 << 38; // 256G of address space
+	inline constexpr std::size_t default_meta_reserve_size = (std::size_t)1 << 28; // 256M: 8M compact descriptors (no fallback) or 4M regular ones (regular mappings are used beyond it)
+	inline constexpr std::size_t default_meta_commit_size = (std::size_t)1 << 21; // 2M, metadata region grows by this step
+	inline constexpr std::size_t default_sysmem_queue_size = 64; // unmaps (and other system calls) that can be deferred until the allocator lock is released
+	inline constexpr std::size_t default_free_batch_size = 256; // pointers buffered by a thread in deferred free mode
+	inline constexpr std::size_t default_free_batch_count = 32; // batches in flight, the freeing thread frees memory itself above
+	inline constexpr std::size_t default_cpu_cache_depth = 64; // chunks of one pool cached by one CPU
+	inline constexpr std::size_t default_cpu_cache_chunk_size = 1024; // bigger chunks bypass per-CPU caches
+	inline constexpr std::size_t default_decommit_threshold = (std::size_t)1 << 18; // 256K of dirty memory in a free block
+	inline constexpr std::int64_t default_decay_time_ms = 10000; // dirty memory is decommitted gradually during 10s
+	inline constexpr std::size_t default_quick_list_pages = 256; // exact-size free lists for runs of 1..256 pages
+	inline constexpr std::size_t default_quick_list_depth = 8; // list is flushed into the free block index when it overflows
+	inline constexpr std::size_t default_max_quick_list_size = (std::size_t)1 << 24; // 16M, all lists are flushed above this
+
+	inline constexpr huge_page_mode_t default_huge_page_mode = huge_page_mode_t::None; // regions are not backed by huge pages by default
+	inline constexpr std::size_t default_huge_page_size = (std::size_t)1 << 21; // 2M
+	inline constexpr huge_page_mode_t default_meta_huge_page_mode = huge_page_mode_t::None;
+
+	inline constexpr std::size_t decay_epoch_count = 32; // decay time is split into this count of epochs
+	inline constexpr std::size_t decay_tick_count = 16; // decay is checked once per this count of deallocations
+
+	inline constexpr attrs_t tlsf_sl_log2 = 4; // 16 second level classes per power of two
+
+	inline constexpr attrs_t descr_pool_sparse_ratio = 4; // descriptor pool is compacted if at most 1/4 of its blocks are in use
+	inline constexpr std::size_t max_compact_pools = 64; // descriptor pools evacuated during one compaction pass
 
 	inline constexpr attrs_t default_min_pool_power = 15; // 32K
 	inline constexpr attrs_t default_max_pool_power = 20; // 1M
@@ -57,6 +101,7 @@ namespace cuw::mem {
 	inline constexpr attrs_t max_possible_chunk_size_log2 = 31;
 
 	inline constexpr attrs_t default_raw_bin_count = 16;
+	inline constexpr std::size_t default_direct_threshold = (std::size_t)1 << 28; // 256M, zero disables
 
 	inline constexpr int default_pool_cache_lookups = 6; // lookups in free_list to access chunk(to realloc or free)
 	inline constexpr int default_raw_cache_lookups = 10; // lookups in a list of raw allocations(to realloc or free)
@@ -64,12 +109,16 @@ namespace cuw::mem {
 	inline constexpr std::size_t default_basic_alignment = 16; // default alignment
 
 	inline constexpr bool default_use_alloc_cache = true; // true, use allocation cache to reduce usage of page_alloc
+	inline constexpr bool default_use_btree_addr_index = false; // address index of pool_alloc is B+tree instead of red-black tree
+	inline constexpr bool default_use_page_map = false; // pool of a chunk can be found by pointer without a lock (front-end caches)
 	inline constexpr bool default_use_locking = true; // true, use locking for multithreading
 
 	inline constexpr std::size_t default_cache_slots = 6; // cache some free blocks for faster allocation
 	inline constexpr std::size_t default_min_slot_size = 1 << 15; // 32K as default_min_pool_size
 	inline constexpr std::size_t default_max_slot_size = 1 << 20; // 1M as default_min_block_size
 	inline constexpr std::size_t default_max_cache_size = default_cache_slots * default_max_slot_size;
+	inline constexpr std::size_t default_large_cache_slots = 8; // blocks bigger than max slot size are cached with exact size
+	inline constexpr std::size_t default_large_cache_size = 0; // opt-in: decay runs only on large alloc/free so cached blocks can stay mapped while idle
 
 
 	using void_node_traits_t = trb::tree_node_packed_traits_t<void>;
@@ -82,6 +131,19 @@ namespace cuw::mem {
 	struct addr_index_tag_t;
 	using addr_index_t = void_node_t<>;
 
+	// address index with O(1) access to neighbours, used where blocks are walked in address order
+	using linked_addr_index_t = trb::tree_node_linked_t<void_node_traits_t>;
+
+	// address indices of compact descriptors, nodes are linked relatively to the base of the metadata region (2^region_bits)
+	template<std::size_t region_bits>
+	using compact_node_traits_t = trb::tree_node_compact_traits_t<void, region_bits>;
+
+	template<std::size_t region_bits>
+	using compact_addr_index_t = trb::tree_node_compact_t<compact_node_traits_t<region_bits>>;
+
+	template<std::size_t region_bits>
+	using compact_linked_addr_index_t = trb::tree_node_compact_linked_t<compact_node_traits_t<region_bits>>;
+
 	struct size_index_tag_t;
 	using size_index_t = void_node_t<>;
 
@@ -90,11 +152,32 @@ namespace cuw::mem {
 	template<class type_t>
 	inline constexpr bool do_fits_block = (sizeof(type_t) == block_size);
 
+	template<class type_t>
+	inline constexpr bool do_fits_compact_block = (sizeof(type_t) == compact_block_size);
+
 	enum class block_type_t : attrs_t {
 		Pool = 0, // pool of chunks
 		Raw, // raw allocation: this is just continious block of memory
 	};
 
+	// system call queued by the page allocator so it can be executed outside of a lock
+	// Decommit, Uncommit: range is unavailable until the call is finished
+	// Map, Commit: size is lowered to min_size if size cannot be obtained, ptr is the result of Map
+	enum class sysmem_op_type_t : int {
+		Decommit,
+		Uncommit,
+		Map,
+		Commit,
+	};
+
+	struct sysmem_op_t {
+		sysmem_op_type_t type{};
+		void* ptr{};
+		std::size_t size{};
+		std::size_t min_size{};
+		bool done{}; // set when the call is executed
+	};
+
 	inline constexpr attrs_t chunk_size_empty = ~0;
 	inline constexpr attrs_t min_alloc_size = 2;  
 	inline constexpr attrs_t default_total_raw_bins = 24;
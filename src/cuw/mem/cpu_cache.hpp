@@ -0,0 +1,124 @@
+#pragma once
+
+#include "core.hpp"
+
+#include <atomic>
+#include <thread>
+
+namespace cuw::mem {
+	// chunks cached by one CPU, LIFO stack per pool
+	// spin lock guards only the stacks: chunks are swapped in & out under it, refill & flush are called without it
+	// so the lock is never held across the lock of the allocator, it is contended only if a thread migrates in between
+	// refill_func(index, ptrs, count) returns how many chunks were allocated, flush_func(index, ptrs, count) frees chunks
+	template<std::size_t cache_depth, std::size_t pool_count>
+	class cpu_cache_t {
+	public:
+		static constexpr std::size_t depth = cache_depth;
+		static constexpr std::size_t batch_size = depth / 2; // chunks are refilled & flushed in half of the depth
+
+		static_assert(batch_size != 0);
+
+	private:
+		struct stack_t {
+			std::size_t count{};
+			void* ptrs[depth];
+		};
+
+		void lock() {
+			while (flag.test_and_set(std::memory_order_acquire)) {
+				std::this_thread::yield();
+			}
+		}
+
+		void unlock() {
+			flag.clear(std::memory_order_release);
+		}
+
+	public:
+		// empty stack is refilled, chunks that do not fit anymore (stack was refilled by another thread meanwhile) are flushed
+		// returns nullptr if nothing could be allocated
+		template<class refill_func_t, class flush_func_t>
+		[[nodiscard]] void* pop(std::size_t index, refill_func_t&& refill_func, flush_func_t&& flush_func) {
+			assert(index < pool_count);
+
+			lock();
+			if (stack_t& stack = stacks[index]; stack.count != 0) {
+				void* ptr = stack.ptrs[--stack.count];
+				unlock();
+				return ptr;
+			}
+			unlock();
+
+			void* ptrs[batch_size];
+			std::size_t count = refill_func(index, ptrs, batch_size);
+			if (count-- == 0) {
+				return nullptr;
+			}
+
+			lock();
+			stack_t& stack = stacks[index];
+			std::size_t moved = std::min(count, depth - stack.count);
+			std::copy(ptrs, ptrs + moved, stack.ptrs + stack.count);
+			stack.count += moved;
+			unlock();
+
+			if (moved != count) {
+				flush_func(index, ptrs + moved, count - moved);
+			} return ptrs[count];
+		}
+
+		// full stack is flushed down to half of its depth, the oldest chunks are returned first
+		template<class flush_func_t>
+		void push(std::size_t index, void* ptr, flush_func_t&& flush_func) {
+			assert(index < pool_count);
+
+			void* ptrs[batch_size];
+			std::size_t count = 0;
+
+			lock();
+			stack_t& stack = stacks[index];
+			if (stack.count == depth) {
+				count = batch_size;
+				std::copy(stack.ptrs, stack.ptrs + count, ptrs);
+				std::copy(stack.ptrs + count, stack.ptrs + depth, stack.ptrs);
+				stack.count -= count;
+			}
+			stack.ptrs[stack.count++] = ptr;
+			unlock();
+
+			if (count != 0) {
+				flush_func(index, ptrs, count);
+			}
+		}
+
+		// all stacks are emptied
+		template<class flush_func_t>
+		void flush(flush_func_t&& flush_func) {
+			void* ptrs[depth];
+			for (std::size_t index = 0; index < pool_count; index++) {
+				lock();
+				stack_t& stack = stacks[index];
+				std::size_t count = std::exchange(stack.count, 0);
+				std::copy(stack.ptrs, stack.ptrs + count, ptrs);
+				unlock();
+
+				if (count != 0) {
+					flush_func(index, ptrs, count);
+				}
+			}
+		}
+
+		std::size_t get_count(std::size_t index) {
+			assert(index < pool_count);
+
+			lock();
+			std::size_t count = stacks[index].count;
+			unlock();
+			return count;
+		}
+
+	private:
+		std::atomic_flag flag{};
+		stack_t stacks[pool_count];
+	};
+}
@@ -4,33 +4,359 @@
 #include "sys_alloc.hpp"
 #include "page_alloc.hpp"
 #include "pool_alloc.hpp"
+#include "cpu_cache.hpp"
 #include "cached_alloc.hpp"
+#include "tlsf_page_alloc.hpp"
 
 #include <mutex>
+#include <atomic>
+#include <thread>
+#include <system_error>
+#include <condition_variable>
 
 namespace cuw::mem {
-	using basic_allocator_t = pool_alloc_t<page_alloc_t<sys_alloc_t<config_traits_t>>>;
+	using sys_allocator_t = sys_alloc_t<config_traits_t>;
+	using basic_allocator_t = pool_alloc_t<page_alloc_backend_t<sys_allocator_t>>;
 
+	// system calls are kept out of the critical section: unmaps, decommits & heap uncommits are queued & executed
+	// after the lock is released, regions & heap commits needed for growth are obtained the same way & allocation is retried,
+	// direct blocks are mapped between two short critical sections
+	// small pool chunks go through per-CPU caches that are refilled & flushed in batches,
+	// free() without a size finds the pool of a chunk in the page map of the pool allocator
 	class allocator_t {
+	private:
+		// queued system calls are taken while the lock is still held, results are handed back under the lock again
+		class lock_guard_t {
+		public:
+			lock_guard_t(allocator_t& _owner) : owner{_owner} {
+				owner.lock.lock();
+			}
+
+			~lock_guard_t() {
+				(void)unlock();
+			}
+
+			// returns true if memory was obtained for an allocation that failed so it can be retried
+			bool unlock() {
+				bool retry = false;
+				while (locked) {
+					std::size_t unmap_count = owner.allocator.take_unmaps(ranges);
+					std::size_t op_count = owner.allocator.take_sysmem_ops(ops);
+					sys_allocator_t::map_params_t params = owner.allocator.get_map_params();
+					owner.lock.unlock();
+
+					sys_allocator_t::unmap(ranges, unmap_count);
+					if (op_count == 0) {
+						locked = false;
+						break;
+					}
+
+					sys_allocator_t::execute(ops, op_count, params);
+					owner.lock.lock();
+					retry |= owner.allocator.finish_sysmem_ops(ops, op_count); // can queue more calls
+				}
+				return retry;
+			}
+
+		private:
+			allocator_t& owner;
+			sysmem_range_t ranges[sys_allocator_t::sysmem_queue_size];
+			sysmem_op_t ops[sys_allocator_t::sysmem_queue_size];
+			bool locked{true};
+		};
+
+		// allocation that failed because memory had to be obtained outside of the lock is retried
+		template<class func_t>
+		auto locked_alloc(func_t func) {
+			while (true) {
+				lock_guard_t lock_guard{*this};
+				auto result = func();
+				if (result || !lock_guard.unlock()) {
+					return result;
+				}
+			}
+		}
+
+		// pointers freed by a designated thread, batches are taken from the fixed set so the queue is bounded
+		struct free_batch_t {
+			free_batch_t* next{};
+			std::size_t count{};
+			void* ptrs[default_free_batch_size];
+		};
+
+		// state of the calling thread, batch that is not full yet is handed over when the thread exits
+		// memory of the batch is already released if the thread exits after the allocator was destroyed
+		struct deferred_free_t {
+			~deferred_free_t() {
+				if (batch && !destroyed.load(std::memory_order_acquire)) {
+					allocator_t::get().submit_batch(batch);
+				}
+			}
+
+			free_batch_t* batch{};
+			bool enabled{};
+		};
+
+		static thread_local deferred_free_t deferred_free;
+		static constinit inline std::atomic<bool> destroyed{}; // trivially destructible so it can be checked after destruction
+
+		static constexpr std::size_t cpu_cache_pools = std::min<std::size_t>(
+			std::countr_zero(default_cpu_cache_chunk_size) - basic_allocator_t::alloc_min_chunk_size_log2 + 1,
+			basic_allocator_t::alloc_max_chunk_size_log2 - basic_allocator_t::alloc_min_chunk_size_log2 + 1);
+
+		using cpu_cache_t = mem::cpu_cache_t<default_cpu_cache_depth, cpu_cache_pools>;
+
+		allocator_t() {
+			allocator.set_deferred_unmap(true);
+			allocator.set_deferred_sysmem_ops(true);
+			init_cpu_caches();
+		}
+
+		// queued batches are reclaimed before the thread stops
+		~allocator_t() {
+			{
+				std::unique_lock reclaim_guard{reclaim_lock};
+				reclaim_stop = true;
+			}
+			reclaim_cv.notify_one();
+			if (reclaimer.joinable()) {
+				reclaimer.join();
+			}
+			destroyed.store(true, std::memory_order_release);
+		}
+
 	public:
 		static allocator_t& get() {
 			static allocator_t allocator;
 			return allocator;
 		}
 
+	private:
+		// mapping settings are copied first, block is published after it was mapped
+		void* malloc_direct(std::size_t size, std::size_t alignment, std::size_t direct_size) {
+			sys_allocator_t::map_params_t params{};
+			{
+				lock_guard_t lock_guard{*this};
+				params = allocator.get_map_params();
+			}
+
+			void* data = sys_allocator_t::map(direct_size, params);
+			if (!data) {
+				return nullptr;
+			}
+
+			{
+				lock_guard_t lock_guard{*this};
+				if (void* ptr = allocator.adopt_direct(data, size, alignment)) {
+					return ptr;
+				}
+			}
+
+			sysmem_range_t range{data, direct_size};
+			sys_allocator_t::unmap(&range, 1);
+			return nullptr;
+		}
+
+	private:
+		// per-CPU caches are not used if CPU the thread is running on cannot be determined
+		void init_cpu_caches() {
+			auto [count, count_status] = get_cpu_count();
+			auto [cpu, cpu_status] = get_current_cpu();
+			if (count_status != 0 || cpu_status != 0) {
+				return;
+			}
+
+			std::size_t size = align_value(count * sizeof(cpu_cache_t), allocator.get_page_size());
+			if (void* memory = sys_allocator_t::map(size, {})) {
+				cpu_caches = new (memory) cpu_cache_t[count];
+				cpu_count = count;
+			}
+		}
+
+		// returns nullptr if chunks of the pool are not cached
+		cpu_cache_t* get_cpu_cache(std::size_t index) {
+			if (!cpu_caches || index >= cpu_cache_pools) {
+				return nullptr;
+			}
+
+			auto [cpu, status] = get_current_cpu();
+			if (status != 0) {
+				return nullptr;
+			} return &cpu_caches[(std::size_t)cpu % cpu_count];
+		}
+
+		std::size_t refill_cpu_cache(std::size_t index, void** ptrs, std::size_t count) {
+			return locked_alloc([&] () { return allocator.malloc_bulk(index, ptrs, count); });
+		}
+
+		void flush_cpu_cache(std::size_t index, void* const* ptrs, std::size_t count) {
+			lock_guard_t lock_guard{*this};
+			if (!allocator.free_bulk(index, ptrs, count)) {
+				std::abort();
+			}
+		}
+
+		void flush_cpu_caches() {
+			for (std::size_t cpu = 0; cpu < cpu_count; cpu++) {
+				cpu_caches[cpu].flush([&] (std::size_t pool_index, void* const* ptrs, std::size_t count) {
+					flush_cpu_cache(pool_index, ptrs, count);
+				});
+			}
+		}
+
+		void* malloc_pool(std::size_t size, std::size_t alignment) {
+			std::size_t index = allocator.get_pool_index(size, alignment);
+			if (cpu_cache_t* cache = get_cpu_cache(index)) {
+				return cache->pop(index,
+					[&] (std::size_t pool_index, void** ptrs, std::size_t count) { return refill_cpu_cache(pool_index, ptrs, count); },
+					[&] (std::size_t pool_index, void* const* ptrs, std::size_t count) { flush_cpu_cache(pool_index, ptrs, count); });
+			} return nullptr;
+		}
+
+		// returns false if chunk is not cached
+		bool free_pool(void* ptr, std::size_t index) {
+			if (cpu_cache_t* cache = get_cpu_cache(index)) {
+				cache->push(index, ptr, [&] (std::size_t pool_index, void* const* ptrs, std::size_t count) {
+					flush_cpu_cache(pool_index, ptrs, count);
+				});
+				return true;
+			} return false;
+		}
+
+	private:
+		// whole batch is freed under one lock acquisition
+		void free_batch(free_batch_t* batch) {
+			lock_guard_t lock_guard{*this};
+			for (std::size_t i = 0; i < batch->count; i++) {
+				if (!allocator.free(batch->ptrs[i])) {
+					std::abort();
+				}
+			}
+			batch->count = 0;
+		}
+
+		// reclaimer is started once outside of reclaim_lock, returns false if it cannot be started
+		bool start_reclaimer() {
+			std::call_once(reclaimer_started, [&] () {
+				try {
+					reclaimer = std::thread([&] () { reclaim(); });
+				} catch (const std::system_error&) {} // deferred free degrades to synchronous frees
+			});
+			return reclaimer.joinable();
+		}
+
+		// returns nullptr if all batches are in use, the reclaimer is not running or it is stopped
+		free_batch_t* acquire_batch() {
+			bool started = start_reclaimer();
+			std::unique_lock reclaim_guard{reclaim_lock};
+			if (!started || reclaim_stop) {
+				direct_frees++;
+				return nullptr;
+			} if (free_batch_t* batch = free_batches) {
+				free_batches = batch->next;
+				return batch;
+			} if (used_batches != default_free_batch_count) {
+				return &batches[used_batches++];
+			}
+			direct_frees++; // caller frees the pointer itself
+			return nullptr;
+		}
+
+		// batch is freed by the caller once the reclaimer is stopped
+		void submit_batch(free_batch_t* batch) {
+			std::unique_lock reclaim_guard{reclaim_lock};
+			if (reclaim_stop) {
+				std::size_t count = batch->count;
+				reclaim_guard.unlock();
+				free_batch(batch);
+				reclaim_guard.lock();
+				direct_frees += count;
+
+				batch->next = free_batches;
+				free_batches = batch;
+				return;
+			}
+
+			deferred_frees += batch->count;
+			batch->next = nullptr;
+			if (ready_tail) {
+				ready_tail->next = batch;
+			} else {
+				ready_head = batch;
+			}
+			ready_tail = batch;
+			reclaim_guard.unlock();
+			reclaim_cv.notify_one();
+		}
+
+		// background thread: batches are freed in submission order
+		void reclaim() {
+			std::unique_lock reclaim_guard{reclaim_lock};
+			while (true) {
+				reclaim_cv.wait(reclaim_guard, [&] () { return ready_head || reclaim_stop; });
+				free_batch_t* batch = ready_head;
+				if (!batch) {
+					return;
+				} if (!(ready_head = batch->next)) {
+					ready_tail = nullptr;
+				}
+
+				std::size_t count = batch->count;
+				reclaim_guard.unlock();
+				free_batch(batch);
+				reclaim_guard.lock();
+				reclaimed_frees += count;
+
+				batch->next = free_batches;
+				free_batches = batch;
+			}
+		}
+
+		// backpressure: when all batches are queued the thread frees memory itself
+		void free_deferred(void* ptr) {
+			deferred_free_t& state = deferred_free;
+			if (!state.batch && !(state.batch = acquire_batch())) {
+				lock_guard_t lock_guard{*this};
+				if (!allocator.free(ptr)) {
+					std::abort();
+				} return;
+			}
+
+			state.batch->ptrs[state.batch->count++] = ptr;
+			if (state.batch->count == default_free_batch_size) {
+				submit_batch(std::exchange(state.batch, nullptr));
+			}
+		}
+
+	public:
 		// standart API
 		void* malloc(std::size_t size) {
-			std::unique_lock lock_guard{lock};
-			return allocator.malloc(size);
+			if (std::size_t direct_size = allocator.get_direct_size(size, 0)) {
+				return malloc_direct(size, 0, direct_size);
+			} if (void* ptr = malloc_pool(size, 0)) {
+				return ptr;
+			}
+			return locked_alloc([&] () { return allocator.malloc(size); });
 		}
 
+		// memory is freed first when the new size is zero so only the new allocation is retried
 		void* realloc(void* ptr, std::size_t new_size) {
-			std::unique_lock lock_guard{lock};
-			return allocator.realloc(ptr, new_size);
+			if (ptr && new_size == 0) {
+				free(ptr);
+				return malloc(0);
+			}
+			return locked_alloc([&] () { return allocator.realloc(ptr, new_size); });
 		}
 
 		void free(void* ptr) {
-			std::unique_lock lock_guard{lock};
+			if (ptr && deferred_free.enabled) {
+				free_deferred(ptr);
+				return;
+			} if (ptr && free_pool(ptr, allocator.find_pool_index(ptr))) {
+				return;
+			}
+
+			lock_guard_t lock_guard{*this};
 			if (!allocator.free(ptr)) {
 				std::abort();
 			}
@@ -38,27 +364,112 @@ namespace cuw::mem {
 
 		// extension API
 		void* malloc(std::size_t size, std::size_t alignment, flags_t flags) {
-			std::unique_lock lock_guard{lock};
-			return allocator.malloc(size, alignment, flags);
+			if (std::size_t direct_size = allocator.get_direct_size(size, alignment)) {
+				return malloc_direct(size, alignment, direct_size);
+			} if (void* ptr = malloc_pool(size, alignment)) {
+				return ptr;
+			}
+			return locked_alloc([&] () { return allocator.malloc(size, alignment, flags); });
 		}
 
+		// memory is freed first when one of the sizes is zero so only the new allocation is retried
 		void* realloc(void* ptr, std::size_t old_size, std::size_t new_size, std::size_t alignment, flags_t flags) {
-			std::unique_lock lock_guard{lock};
-			return allocator.realloc(ptr, old_size, new_size, alignment, flags);
+			if (ptr && (old_size == 0) != (new_size == 0)) {
+				free(ptr, old_size, alignment, flags);
+				return malloc(new_size, alignment, flags);
+			}
+			return locked_alloc([&] () { return allocator.realloc(ptr, old_size, new_size, alignment, flags); });
 		}
 
 		void free(void* ptr, std::size_t size, std::size_t alignment, flags_t flags) {
-			std::unique_lock lock_guard{lock};
+			if (ptr && free_pool(ptr, allocator.get_pool_index(size, alignment))) {
+				return;
+			}
+
+			lock_guard_t lock_guard{*this};
 			if (!allocator.free(ptr, size, alignment, flags)) {
 				std::abort();
 			}
 		}
 
+		// runtime settings
+		void set_huge_page_mode(huge_page_mode_t mode) {
+			lock_guard_t lock_guard{*this};
+			allocator.set_huge_page_mode(mode);
+		}
+
+		// page backend can have no decay, generic lambda keeps the check dependent so the call is discarded then
+		void set_decay_time(std::int64_t time_ms) {
+			[&] (auto& backend) {
+				if constexpr(requires { backend.set_decay_time(time_ms); }) {
+					lock_guard_t lock_guard{*this};
+					backend.set_decay_time(time_ms);
+				}
+			}(allocator);
+		}
+
+		void set_prefault_mode(bool mode) {
+			lock_guard_t lock_guard{*this};
+			allocator.set_prefault_mode(mode);
+		}
+
+		bool reserve(std::size_t size) {
+			return locked_alloc([&] () { return allocator.reserve(size); });
+		}
+
+		std::size_t trim(std::size_t keep_size) {
+			flush_cpu_caches();
+			lock_guard_t lock_guard{*this};
+			return allocator.trim(keep_size);
+		}
+
+		// buffered pointers of the calling thread are handed over when the mode is disabled
+		void set_deferred_free(bool mode) {
+			deferred_free_t& state = deferred_free;
+			state.enabled = mode;
+			if (!mode && state.batch) {
+				submit_batch(std::exchange(state.batch, nullptr));
+			}
+		}
+
+		// diagnostics
+		stats_t get_stats() {
+			stats_t stats{};
+			{
+				lock_guard_t lock_guard{*this};
+				stats.sysmem_size = allocator.get_sysmem_size();
+			}
+			std::unique_lock reclaim_guard{reclaim_lock};
+			stats.deferred_frees = deferred_frees;
+			stats.reclaimed_frees = reclaimed_frees;
+			stats.direct_frees = direct_frees;
+			return stats;
+		}
+
 	private:
 		std::mutex lock{};
 		basic_allocator_t allocator{};
+
+		std::mutex reclaim_lock{};
+		std::condition_variable reclaim_cv{};
+		std::once_flag reclaimer_started{};
+		std::thread reclaimer{};
+		bool reclaim_stop{};
+		free_batch_t* ready_head{};
+		free_batch_t* ready_tail{};
+		free_batch_t* free_batches{};
+		std::size_t used_batches{};
+		free_batch_t batches[default_free_batch_count];
+		std::size_t deferred_frees{};
+		std::size_t reclaimed_frees{};
+		std::size_t direct_frees{};
+
+		cpu_cache_t* cpu_caches{};
+		std::size_t cpu_count{};
 	};
 
+	thread_local allocator_t::deferred_free_t allocator_t::deferred_free{};
+
 
 	// standart API
 	void* malloc(std::size_t size) {
@@ -85,4 +496,34 @@ namespace cuw::mem {
 	void free_ext(void* ptr, std::size_t size, std::size_t alignment, flags_t flags) {
 		return allocator_t::get().free(ptr, size, alignment, flags);
 	}
+
+	// runtime settings
+	void set_huge_page_mode(huge_page_mode_t mode) {
+		allocator_t::get().set_huge_page_mode(mode);
+	}
+
+	void set_decay_time(std::int64_t time_ms) {
+		allocator_t::get().set_decay_time(time_ms);
+	}
+
+	void set_prefault_mode(bool mode) {
+		allocator_t::get().set_prefault_mode(mode);
+	}
+
+	bool reserve(std::size_t size) {
+		return allocator_t::get().reserve(size);
+	}
+
+	std::size_t trim(std::size_t keep_size) {
+		return allocator_t::get().trim(keep_size);
+	}
+
+	void set_deferred_free(bool mode) {
+		allocator_t::get().set_deferred_free(mode);
+	}
+
+	// diagnostics
+	stats_t get_stats() {
+		return allocator_t::get().get_stats();
+	}
 }
\ No newline at end of file
@@ -14,4 +14,31 @@ namespace cuw::mem {
 	CUW_EXPORT void* malloc_ext(std::size_t size, std::size_t alignment = 0, flags_t flags = 0);
 	CUW_EXPORT void* realloc_ext(void* ptr, std::size_t old_size, std::size_t new_size, std::size_t alignment = 0, flags_t flags = 0);
 	CUW_EXPORT void free_ext(void* ptr, std::size_t size, std::size_t alignment = 0, flags_t flags = 0);
+
+	// runtime settings
+	CUW_EXPORT void set_huge_page_mode(huge_page_mode_t mode);
+	// < 0 - dirty memory is never decommitted, 0 - immediately, > 0 - gradually during the given time
+	CUW_EXPORT void set_decay_time(std::int64_t time_ms);
+	// new system memory is populated with physical pages right away so it doesn't page fault on first use
+	CUW_EXPORT void set_prefault_mode(bool mode);
+
+	// warmup: maps & prefaults at least size bytes that stay available for allocations, false on failure
+	CUW_EXPORT bool reserve(std::size_t size);
+
+	// returns cached & free memory to the system keeping up to keep_size bytes, returns how many bytes were released
+	CUW_EXPORT std::size_t trim(std::size_t keep_size = 0);
+
+	// free() of the calling thread only buffers the pointer, memory is freed in batches by the background thread
+	// disabling the mode hands the buffered pointers over, extension API frees are never deferred
+	CUW_EXPORT void set_deferred_free(bool mode);
+
+	// diagnostics
+	struct stats_t {
+		std::size_t sysmem_size{}; // memory of page runs obtained from the system
+		std::size_t deferred_frees{}; // pointers handed over to the background thread in deferred free mode
+		std::size_t reclaimed_frees{}; // handed over pointers that were freed already
+		std::size_t direct_frees{}; // pointers freed by the calling thread in deferred free mode because all batches were in use
+	};
+
+	CUW_EXPORT stats_t get_stats();
 }
\ No newline at end of file
@@ -5,16 +5,60 @@
 #include <cuw/utils/utils.hpp>
 
 namespace cuw::mem {
+	// None: regular pages
+	// Transparent: region is aligned by huge page size and advised to be backed by transparent huge pages
+	// HugeTLB: region is allocated from the explicit huge page pool, falls back to Transparent on failure
+	enum class huge_page_mode_t : int {
+		None,
+		Transparent,
+		HugeTLB,
+	};
+
 	struct sysmem_info_t {
 		int page_size{-1};
+		std::size_t huge_page_size{}; // 0 if huge pages are not supported
 	};
 
 	// 0 - success, -1 - failure
 	value_status_t<sysmem_info_t, int> get_sysmem_info();
 
+	// number of CPUs configured in the system
+	// 0 - success, -1 - failure
+	value_status_t<int, int> get_cpu_count();
+
+	// CPU the calling thread is running on, thread can migrate right after the call
+	// on Linux it is read from the rseq area registered by the C library (or vDSO), no system call is made
+	// 0 - success, -1 - failure
+	value_status_t<int, int> get_current_cpu();
+
 	// 0 - success, -1 - failure
 	value_status_t<void*, int> allocate_sysmem(std::size_t size);
 
+	// alignment must be a power of two and a multiple of the page size
+	// huge pages are used only if size is a multiple of the alignment
+	// 0 - success, -1 - failure
+	value_status_t<void*, int> allocate_sysmem_aligned(std::size_t size, std::size_t alignment, huge_page_mode_t mode);
+
 	// 0 - success, -1 - failure
 	int deallocate_sysmem(void* ptr, std::size_t size);
+
+	// reserves address space only, range must be committed before use and is released with deallocate_sysmem
+	// 0 - success, -1 - failure
+	value_status_t<void*, int> reserve_sysmem(std::size_t size, std::size_t alignment);
+
+	// makes part of the reserved range accessible, physical pages are allocated on first touch
+	// 0 - success, -1 - failure
+	int commit_sysmem(void* ptr, std::size_t size, huge_page_mode_t mode);
+
+	// returns committed part of the reserved range back to the reserved state, physical pages are released
+	// 0 - success, -1 - failure
+	int uncommit_sysmem(void* ptr, std::size_t size);
+
+	// physical pages are released lazily, range stays mapped and reads as zeroes or old data until written
+	// 0 - success, -1 - failure
+	int decommit_sysmem(void* ptr, std::size_t size);
+
+	// physical pages are allocated in advance so first access doesn't page fault, range must be accessible
+	// 0 - success, -1 - failure
+	int prefault_sysmem(void* ptr, std::size_t size);
 }
\ No newline at end of file
@@ -0,0 +1,242 @@
+#pragma once
+
+#include "core.hpp"
+#include "alloc_tag.hpp"
+
+namespace cuw::mem {
+	// dedicated contiguous range of address space for metadata (descriptor block pools)
+	// descriptors are packed densely so lookups touch fewer pages, range is reserved once and committed in big steps
+	// all chunks have the same size, freed chunks are reused through the intrusive free list of runs
+	// trim() uncommits the free tail & decommits free runs except the first page that keeps the list entry
+	// alloc_t must provide reserve(size, alignment), commit(ptr, size), uncommit(ptr, size) & deallocate(ptr, size)
+	class meta_region_t {
+	private:
+		// run of count contiguous free chunks, clean - pages after the first one were decommitted
+		struct free_chunk_t {
+			free_chunk_t* next{};
+			std::size_t count{};
+			bool clean{};
+
+			char* get_end(std::size_t chunk_size) const {
+				return (char*)this + count * chunk_size;
+			}
+		};
+
+	public:
+		meta_region_t() = default;
+
+		meta_region_t(const meta_region_t&) = delete;
+		meta_region_t& operator = (const meta_region_t&) = delete;
+
+		// alignment of the reserved range, commit size should be its multiple
+		// page size is the granularity of trim, chunk size must be its multiple
+		// base alignment: reserved range is additionally aligned by it (e.g. by the region size so its base is found by a mask)
+		void init(std::size_t _chunk_size, std::size_t _reserve_size, std::size_t _commit_size, std::size_t _alignment, std::size_t _page_size, huge_page_mode_t _mode,
+			std::size_t _base_alignment = 0) {
+			assert(_commit_size >= _chunk_size);
+			assert(is_aligned(_chunk_size, _page_size));
+			chunk_size = _chunk_size;
+			reserve_size = align_value(_reserve_size, _commit_size);
+			commit_size = _commit_size;
+			alignment = _alignment;
+			base_alignment = std::max(_alignment, _base_alignment);
+			page_size = _page_size;
+			mode = _mode;
+		}
+
+	private:
+		template<class alloc_t>
+		bool try_reserve(alloc_t& alloc) {
+			if (start) {
+				return true;
+			} if (reserve_failed || reserve_size == 0) {
+				return false;
+			}
+
+			start = (char*)alloc.reserve(reserve_size, base_alignment);
+			if (!start) {
+				reserve_failed = true;
+				return false;
+			}
+			top = start;
+			cursor = start;
+			end = start + reserve_size;
+			return true;
+		}
+
+		template<class alloc_t>
+		bool try_commit(alloc_t& alloc) {
+			std::size_t size = std::min<std::size_t>(commit_size, end - top);
+			if (size < chunk_size) {
+				return false;
+			}
+
+			bool committed = false;
+			if constexpr(has_huge_pages_v<alloc_t>) {
+				committed = alloc.commit(top, size, mode);
+			} else {
+				committed = alloc.commit(top, size);
+			} if (!committed) {
+				return false;
+			}
+			top += size;
+			return true;
+		}
+
+	public:
+		// returns nullptr if chunk is too big, region cannot be reserved or it is exhausted
+		template<class alloc_t>
+		[[nodiscard]] void* allocate(alloc_t& alloc, std::size_t size) {
+			if (size > chunk_size || !try_reserve(alloc)) {
+				return nullptr;
+			}
+
+			if (free_chunk_t* chunk = free_chunks) {
+				if (chunk->count > 1) {
+					free_chunks = new ((char*)chunk + chunk_size) free_chunk_t{chunk->next, chunk->count - 1, chunk->clean};
+				} else {
+					free_chunks = chunk->next;
+				}
+				return chunk;
+			}
+
+			if (cursor + chunk_size > top && !try_commit(alloc)) {
+				return nullptr;
+			}
+			void* chunk = cursor;
+			cursor += chunk_size;
+			return chunk;
+		}
+
+		// returns false if memory doesn't belong to the region
+		bool deallocate(void* ptr) {
+			if (!contains(ptr)) {
+				return false;
+			}
+			free_chunks = new (ptr) free_chunk_t{free_chunks, 1, false};
+			return true;
+		}
+
+	private:
+		// merge sort of the free list by address
+		static free_chunk_t* sort_chunks(free_chunk_t* list) {
+			if (!list || !list->next) {
+				return list;
+			}
+
+			free_chunk_t* slow = list;
+			for (free_chunk_t* fast = list->next; fast && fast->next; fast = fast->next->next) {
+				slow = slow->next;
+			}
+			free_chunk_t* second = std::exchange(slow->next, nullptr);
+
+			free_chunk_t* first = sort_chunks(list);
+			second = sort_chunks(second);
+
+			free_chunk_t head{};
+			free_chunk_t* tail = &head;
+			while (first && second) {
+				free_chunk_t*& min = (std::uintptr_t)first < (std::uintptr_t)second ? first : second;
+				tail->next = min;
+				tail = min;
+				min = min->next;
+			}
+			tail->next = first ? first : second;
+			return head.next;
+		}
+
+	public:
+		// free runs are coalesced, free tail is uncommitted, rest of the runs is decommitted (first page is kept)
+		// returns how many bytes were released
+		template<class alloc_t>
+		std::size_t trim(alloc_t& alloc) {
+			if (!start) {
+				return 0;
+			}
+
+			free_chunk_t* sorted = sort_chunks(std::exchange(free_chunks, nullptr));
+			free_chunk_t* last = nullptr;
+			for (free_chunk_t* run = sorted, *next = nullptr; run; run = next) {
+				next = run->next;
+				if (last && last->get_end(chunk_size) == (char*)run) {
+					last->count += run->count;
+					last->clean = last->clean && run->clean;
+					last->next = nullptr;
+				} else {
+					run->next = nullptr;
+					if (last) {
+						last->next = run;
+					} else {
+						free_chunks = run;
+					}
+					last = run;
+				}
+			}
+
+			if (last && last->get_end(chunk_size) == cursor) {
+				cursor = (char*)last;
+				free_chunk_t** link = &free_chunks;
+				while (*link != last) {
+					link = &(*link)->next;
+				}
+				*link = nullptr;
+			}
+
+			std::size_t released = 0;
+			if (char* new_top = start + align_value((std::size_t)(cursor - start), alignment); new_top < top) {
+				alloc.uncommit(new_top, top - new_top);
+				released += top - new_top;
+				top = new_top;
+			} if constexpr(has_decommit_v<alloc_t>) {
+				for (free_chunk_t* run = free_chunks; run; run = run->next) {
+					if (!run->clean && run->count * chunk_size > page_size) {
+						alloc.decommit((char*)run + page_size, run->count * chunk_size - page_size);
+						released += run->count * chunk_size - page_size;
+					}
+					run->clean = true;
+				}
+			}
+			return released;
+		}
+
+		template<class alloc_t>
+		void release(alloc_t& alloc) {
+			if (start) {
+				alloc.deallocate(start, reserve_size);
+			}
+			start = nullptr;
+			top = nullptr;
+			cursor = nullptr;
+			end = nullptr;
+			free_chunks = nullptr;
+		}
+
+		bool contains(void* ptr) const {
+			return start <= (char*)ptr && (char*)ptr < end;
+		}
+
+		std::size_t get_committed_size() const {
+			return top - start;
+		}
+
+		std::size_t get_chunk_size() const {
+			return chunk_size;
+		}
+
+	private:
+		char* start{};
+		char* top{}; // end of the committed part
+		char* cursor{}; // end of the used part
+		char* end{};
+		free_chunk_t* free_chunks{};
+
+		std::size_t chunk_size{};
+		std::size_t reserve_size{};
+		std::size_t commit_size{};
+		std::size_t alignment{};
+		std::size_t base_alignment{};
+		std::size_t page_size{};
+		huge_page_mode_t mode{};
+		bool reserve_failed{};
+	};
+}
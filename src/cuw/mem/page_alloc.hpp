@@ -4,16 +4,17 @@
 #include "mem_api.hpp"
 #include "alloc_tag.hpp"
 #include "block_pool.hpp"
+#include "meta_region.hpp"
 #include "alloc_traits.hpp"
 
+#include <chrono>
+
 namespace cuw::mem {
-	// addr_index: store block in an address index so we can search it by address
-	// size_index: store block in a size index os we can search it by size
-	// offset(16): offset from prime block
-	// size(48): size of the block in bytes (page_size aligned)
-	// data: pointer to data
-	struct alignas(block_align) free_block_descr_t {
-		using fbd_t = free_block_descr_t;
+	// operations shared by both layouts of the free block descriptor, descr_t provides addr_index & accessors
+	template<class descr_t, class __addr_index_t>
+	struct free_block_descr_ops_t {
+		using fbd_t = descr_t;
+		using addr_index_t = __addr_index_t;
 
 		static bool overlaps(fbd_t* fbd, void* ptr, std::size_t size) {
 			auto l1 = (std::uintptr_t)fbd->get_start();
@@ -24,7 +25,7 @@ namespace cuw::mem {
 		}
 
 		static bool overlaps(fbd_t* fbd1, fbd_t* fbd2) {
-			return overlaps(fbd1, fbd2->get_start(), fbd2->size);
+			return overlaps(fbd1, fbd2->get_start(), fbd2->get_size());
 		}
 
 		static bool preceds(fbd_t* fbd1, fbd_t* fbd2) {
@@ -35,10 +36,6 @@ namespace cuw::mem {
 			return ptr ? base_to_obj(ptr, fbd_t, addr_index) : nullptr;
 		}
 
-		static fbd_t* size_index_to_descr(size_index_t* ptr) {
-			return ptr ? base_to_obj(ptr, fbd_t, size_index) : nullptr;
-		}
-
 		struct addr_index_search_t : trb::implicit_key_t<addr_index_t> {
 			bool compare(addr_index_t* node, void* start) const {
 				auto block_start = (std::uintptr_t)addr_index_to_descr(node)->get_start();
@@ -51,17 +48,26 @@ namespace cuw::mem {
 			}
 		};		
 
-		struct size_index_search_t : trb::implicit_key_t<size_index_t> {
-			// search first block with size greater than or equal to size
-			bool compare(size_index_t* node, std::size_t size) const {
-				return size_index_to_descr(node)->size < size;
-			}
-
-			bool compare(size_index_t* node1, size_index_t* node2) const {
-				return compare(node1, size_index_to_descr(node2)->size);
+		// maintains max_size of the subtree
+		struct addr_index_augment_t {
+			void update(addr_index_t* node) const {
+				fbd_t* fbd = addr_index_to_descr(node);
+				attrs_t max_size = fbd->get_size();
+				if (node->left) {
+					max_size = std::max(max_size, addr_index_to_descr(node->left)->get_max_size());
+				} if (node->right) {
+					max_size = std::max(max_size, addr_index_to_descr(node->right)->get_max_size());
+				} fbd->set_max_size(max_size);
 			}
 		};
 
+		// lowest by address block with size greater than or equal to size
+		static fbd_t* find_first_fit(addr_index_t* root, std::size_t size) {
+			return addr_index_to_descr(bst::find_first(root,
+				[&] (addr_index_t* node) { return addr_index_to_descr(node)->get_max_size() >= size; },
+				[&] (addr_index_t* node) { return addr_index_to_descr(node)->get_size() >= size; }));
+		}
+
 		// for reversed search
 		struct previous_block_search_t : trb::implicit_key_t<addr_index_t> {
 			bool compare(addr_index_t* node, void* ptr) const {
@@ -70,7 +76,16 @@ namespace cuw::mem {
 				return block_end > ptr_value;
 			}
 		};
+	};
 
+	// addr_index: store block in an address index so we can search it by address
+	// max_size: max size of the blocks in the subtree of addr_index (augmented data), lets us search it by size
+	// dirty_size: upper bound of bytes that were freed but not decommitted yet, 0 - block is clean
+	// dirty_epoch: decay epoch of the oldest dirty memory of the block
+	// offset(16): offset from prime block
+	// size(48): size of the block in bytes (page_size aligned)
+	// data: pointer to data
+	struct alignas(block_align) free_block_descr_t : free_block_descr_ops_t<free_block_descr_t, addr_index_t> {
 		std::size_t get_size() const {
 			return size;
 		}
@@ -83,6 +98,35 @@ namespace cuw::mem {
 			return (char*)data + size;
 		}
 
+		void set_block(void* _data, std::size_t _size) {
+			data = _data;
+			size = _size;
+		}
+
+		attrs_t get_max_size() const {
+			return max_size;
+		}
+
+		void set_max_size(attrs_t value) {
+			max_size = value;
+		}
+
+		attrs_t get_dirty_size() const {
+			return dirty_size;
+		}
+
+		void set_dirty_size(attrs_t value) {
+			dirty_size = value;
+		}
+
+		std::uint16_t get_dirty_epoch() const {
+			return dirty_epoch;
+		}
+
+		void set_dirty_epoch(std::uint16_t value) {
+			dirty_epoch = value;
+		}
+
 		void extend_right(std::size_t amount) {
 			size += amount;
 		}
@@ -102,15 +146,116 @@ namespace cuw::mem {
 		}
 
 		addr_index_t addr_index;
-		size_index_t size_index;
+		attrs_t max_size{};
+		attrs_t dirty_size:48 {}, dirty_epoch:16 {};
 		attrs_t offset:16, size:48;
 		void* data;
 	};
 
 	static_assert(do_fits_block<free_block_descr_t>);
 
-	struct alignas(block_align) sysmem_descr_t {
-		using smd_t = sysmem_descr_t;
+	// compact values are kept in compact_unit_size units: 32 low bits & high bits up to max_alloc_bits
+	inline constexpr std::size_t compact_hi_bits = max_alloc_bits - compact_unit_bits - 32;
+
+	inline attrs_t unpack_compact(std::uint32_t lo, attrs_t hi) {
+		return (hi << 32 | lo) << compact_unit_bits;
+	}
+
+	// 32-byte layout of the free block descriptor, links are relative to the base of the metadata region (2^region_bits)
+	// so it is allocated only from the region, block is described in compact units (sizes & addresses are 4K aligned)
+	// pool offset is not stored, it is computed from the address of the descriptor (compact_descr_entry_t)
+	template<std::size_t region_bits>
+	struct alignas(compact_block_size) compact_free_block_descr_t
+		: free_block_descr_ops_t<compact_free_block_descr_t<region_bits>, compact_addr_index_t<region_bits>> {
+		using addr_index_t = compact_addr_index_t<region_bits>;
+
+		std::size_t get_size() const {
+			return unpack_compact(size_lo, size_hi);
+		}
+
+		void* get_start() const {
+			return (void*)unpack_compact(data_lo, data_hi);
+		}
+
+		void* get_end() const {
+			return (char*)get_start() + get_size();
+		}
+
+		void set_start(void* _data) {
+			attrs_t value = (attrs_t)_data >> compact_unit_bits;
+			assert(is_aligned(_data, compact_unit_size) && (value >> (32 + compact_hi_bits)) == 0);
+			data_lo = (std::uint32_t)value;
+			data_hi = value >> 32;
+		}
+
+		void set_size(std::size_t _size) {
+			attrs_t value = _size >> compact_unit_bits;
+			assert(is_aligned(_size, compact_unit_size) && (value >> (32 + compact_hi_bits)) == 0);
+			size_lo = (std::uint32_t)value;
+			size_hi = value >> 32;
+		}
+
+		void set_block(void* _data, std::size_t _size) {
+			set_start(_data);
+			set_size(_size);
+		}
+
+		attrs_t get_max_size() const {
+			return unpack_compact(max_size_lo, max_size_hi);
+		}
+
+		void set_max_size(attrs_t _max_size) {
+			attrs_t value = _max_size >> compact_unit_bits;
+			max_size_lo = (std::uint32_t)value;
+			max_size_hi = value >> 32;
+		}
+
+		attrs_t get_dirty_size() const {
+			return unpack_compact(dirty_size_lo, dirty_size_hi);
+		}
+
+		void set_dirty_size(attrs_t _dirty_size) {
+			attrs_t value = _dirty_size >> compact_unit_bits;
+			assert(is_aligned(_dirty_size, compact_unit_size));
+			dirty_size_lo = (std::uint32_t)value;
+			dirty_size_hi = value >> 32;
+		}
+
+		std::uint16_t get_dirty_epoch() const {
+			return dirty_epoch;
+		}
+
+		void set_dirty_epoch(std::uint16_t value) {
+			dirty_epoch = value;
+		}
+
+		void extend_right(std::size_t amount) {
+			set_size(get_size() + amount);
+		}
+
+		void extend_left(std::size_t amount) {
+			set_block((char*)get_start() - amount, get_size() + amount);
+		}
+
+		void shrink_left(std::size_t amount) {
+			set_block((char*)get_start() + amount, get_size() - amount);
+		}
+
+		void shrink_right(std::size_t amount) {
+			set_size(get_size() - amount);
+		}
+
+		addr_index_t addr_index;
+		std::uint32_t data_lo{}, size_lo{}, max_size_lo{}, dirty_size_lo{};
+		std::uint32_t data_hi:compact_hi_bits {}, size_hi:compact_hi_bits {}, max_size_hi:compact_hi_bits {}, dirty_size_hi:compact_hi_bits {};
+		std::uint32_t dirty_epoch:16 {};
+	};
+
+	// operations shared by both layouts of the sysmem descriptor, descr_t provides addr_index & accessors
+	template<class descr_t, class __addr_index_t>
+	struct sysmem_descr_ops_t {
+		using smd_t = descr_t;
+		using addr_index_t = __addr_index_t;
 
 		static smd_t* addr_index_to_descr(addr_index_t* ptr) {
 			return ptr ? base_to_obj(ptr, smd_t, addr_index) : nullptr;
@@ -136,7 +281,9 @@ namespace cuw::mem {
 				return ptr_value >= block_end;
 			}
 		};
+	};
 
+	struct alignas(block_align) sysmem_descr_t : sysmem_descr_ops_t<sysmem_descr_t, linked_addr_index_t> {
 		std::size_t get_size() const {
 			return size;
 		}
@@ -149,6 +296,11 @@ namespace cuw::mem {
 			return (char*)data + size;
 		}
 
+		void set_block(void* _data, std::size_t _size) {
+			data = _data;
+			size = _size;
+		}
+
 		addr_index_t addr_index;
 		attrs_t offset:16, size:48;
 		void* data;
@@ -156,6 +308,40 @@ namespace cuw::mem {
 
 	static_assert(do_fits_block<sysmem_descr_t>);
 
+	// 32-byte layout of the sysmem descriptor, the same constraints as of compact_free_block_descr_t
+	template<std::size_t region_bits>
+	struct alignas(compact_block_size) compact_sysmem_descr_t
+		: sysmem_descr_ops_t<compact_sysmem_descr_t<region_bits>, compact_linked_addr_index_t<region_bits>> {
+		using addr_index_t = compact_linked_addr_index_t<region_bits>;
+
+		std::size_t get_size() const {
+			return unpack_compact(size_lo, size_hi);
+		}
+
+		void* get_start() const {
+			return (void*)unpack_compact(data_lo, data_hi);
+		}
+
+		void* get_end() const {
+			return (char*)get_start() + get_size();
+		}
+
+		void set_block(void* _data, std::size_t _size) {
+			attrs_t data_value = (attrs_t)_data >> compact_unit_bits;
+			attrs_t size_value = _size >> compact_unit_bits;
+			assert(is_aligned(_data, compact_unit_size) && (data_value >> (32 + compact_hi_bits)) == 0);
+			assert(is_aligned(_size, compact_unit_size) && (size_value >> (32 + compact_hi_bits)) == 0);
+			data_lo = (std::uint32_t)data_value;
+			data_hi = data_value >> 32;
+			size_lo = (std::uint32_t)size_value;
+			size_hi = size_value >> 32;
+		}
+
+		addr_index_t addr_index;
+		std::uint32_t data_lo{}, size_lo{};
+		std::uint32_t data_hi:compact_hi_bits {}, size_hi:compact_hi_bits {}, reserved:(32 - 2 * compact_hi_bits) {};
+	};
+
 	template<class descr_t>
 	class descr_entry_t : public block_pool_entry_t {
 	public:
@@ -179,23 +365,73 @@ namespace cuw::mem {
 	using free_block_descr_entry_t = descr_entry_t<free_block_descr_t>;
 	using sysmem_descr_entry_t = descr_entry_t<sysmem_descr_t>;
 
+	// pools of compact descriptors are aligned by their size (all pools have the same size)
+	// so offset of the descriptor in the pool is computed from its address
+	template<class descr_t>
+	class compact_descr_entry_t : public basic_block_pool_entry_t<compact_block_size> {
+	public:
+		using bp_t = block_pool_t;
+		using base_t = basic_block_pool_entry_t<compact_block_size>;
+
+		static_assert(do_fits_compact_block<descr_t>);
+
+		bp_t* create_pool(void* mem, std::size_t size) {
+			assert(is_alignment(size) && is_aligned(mem, size));
+			assert(pool_size == 0 || pool_size == size);
+			pool_size = size;
+			return base_t::create_pool(mem, size);
+		}
+
+		descr_t* acquire(void* data, std::size_t size) {
+			if (auto [ptr, offset] = base_t::acquire(); ptr) {
+				descr_t* descr = new (ptr) descr_t{};
+				descr->set_block(data, size);
+				return descr;
+			}
+			return nullptr;
+		}
+
+		bp_t* release(descr_t* descr, block_pool_release_mode_t mode) {
+			attrs_t offset = (((std::uintptr_t)descr & (pool_size - 1)) - block_size) / compact_block_size;
+			return base_t::release(descr, offset, mode);
+		}
+
+	private:
+		std::size_t pool_size{};
+	};
+
 	// all allocations will be multiple of page_size
 	// size is now size in bytes
 	// size cannot be less than page_size or block_size
-	// O(12 * log(n) + walk) complexity at its finest on deallocation
+	// free blocks are stored in a single address-ordered tree augmented with max size of the subtree
+	// allocation is address-ordered first fit: O(log(n))
+	// O(6 * log(n) + walk) complexity at its finest on deallocation
 	template<class basic_alloc_t>
 	class page_alloc_t : public basic_alloc_t {
 	public:
 		using this_t = page_alloc_t;
 		using base_t = basic_alloc_t;
 		using bp_t = block_pool_t;
-		using fbd_t = free_block_descr_t;
-		using smd_t = sysmem_descr_t;
-		using fbd_entry_t = free_block_descr_entry_t;
-		using smd_entry_t = sysmem_descr_entry_t;
 
 		static_assert(has_sysmem_alloc_tag_v<base_t>);
 
+		// descriptors take 32-byte slots of the metadata region if block addresses & sizes fit compact units
+		// and the region fits 32-bit links, otherwise (no region) 64-byte descriptors are used
+		static constexpr bool use_compact_descr = base_t::use_compact_descr && base_t::use_meta_region && has_reserve_v<base_t>
+			&& base_t::alloc_page_size >= compact_unit_size && base_t::alloc_meta_reserve_size != 0
+			&& std::max(base_t::alloc_meta_reserve_size, base_t::alloc_meta_commit_size) <= ((std::size_t)1 << 32);
+
+		// region is reserved with the size of 2^meta_region_bits & aligned by it so links find its base by a mask
+		static constexpr std::size_t meta_region_bits = use_compact_descr
+			? std::countr_zero(std::bit_ceil(std::max(base_t::alloc_meta_reserve_size, base_t::alloc_meta_commit_size))) : 0;
+
+		using fbd_t = std::conditional_t<use_compact_descr, compact_free_block_descr_t<meta_region_bits>, free_block_descr_t>;
+		using smd_t = std::conditional_t<use_compact_descr, compact_sysmem_descr_t<meta_region_bits>, sysmem_descr_t>;
+		using fbd_entry_t = std::conditional_t<use_compact_descr, compact_descr_entry_t<fbd_t>, free_block_descr_entry_t>;
+		using smd_entry_t = std::conditional_t<use_compact_descr, compact_descr_entry_t<smd_t>, sysmem_descr_entry_t>;
+		using fbd_index_t = typename fbd_t::addr_index_t;
+		using smd_index_t = typename smd_t::addr_index_t;
+
 		template<class ... args_t>
 		page_alloc_t(args_t&& ... args) : base_t(std::forward<args_t>(args)...) {
 			if constexpr(base_t::use_resolved_page_size) {
@@ -209,7 +445,15 @@ namespace cuw::mem {
 			}
 			block_pool_size = align_value(base_t::alloc_block_pool_size, page_size);
 			sysmem_pool_size = align_value(base_t::alloc_sysmem_pool_size, page_size);
+			if constexpr(use_compact_descr) { // pools of compact descriptors are aligned by their size
+				assert(is_aligned(page_size, compact_unit_size));
+				block_pool_size = std::bit_ceil(std::max(block_pool_size, sysmem_pool_size));
+				sysmem_pool_size = block_pool_size;
+			}
 			min_block_size = align_value(base_t::alloc_min_block_size, page_size);
+			max_block_size = align_value(base_t::alloc_max_block_size, page_size);
+			decommit_threshold = align_value(base_t::alloc_decommit_threshold, page_size);
+			init_meta_region();
 		}
 
 		page_alloc_t(const page_alloc_t&) = delete;
@@ -225,22 +469,111 @@ namespace cuw::mem {
 		// mostly for debugging purposes
 		void release_mem() {
 			fbd_addr = nullptr;
-			fbd_size = nullptr;
 			fbd_entry.release_all([&] (void* block, std::size_t size) {
-				base_t::deallocate(block, size);
+				deallocate_meta(block, size);
 				return true;
 			});
 
-			bst::traverse_inorder(smd_addr, [&] (addr_index_t* node) {
+			bst::destroy(smd_addr, [&] (smd_index_t* node) {
 				smd_t* smd = smd_t::addr_index_to_descr(node);
 				base_t::deallocate(smd->get_start(), smd->get_size());
 			});
 			
 			smd_addr = nullptr;
 			smd_entry.release_all([&] (void* block, std::size_t size) {
-				base_t::deallocate(block, size);
+				deallocate_meta(block, size);
 				return true;
 			});
+			meta_region.release((base_t&)*this);
+
+			if (spare_region) {
+				base_t::deallocate(spare_region, spare_region_size);
+			}
+			spare_region = nullptr;
+			spare_region_size = 0;
+			sysmem_op_count = 0; // queued ops refer to released memory
+
+			if (heap_start) {
+				base_t::deallocate(heap_start, (char*)heap_end - (char*)heap_start);
+			}
+			heap_start = nullptr;
+			heap_top = nullptr;
+			heap_spare_end = nullptr;
+			heap_end = nullptr;
+			heap_op_pending = false;
+			sysmem_size = 0;
+			used_size = 0;
+			retained_size = 0;
+			std::fill(std::begin(quick_lists), std::end(quick_lists), quick_list_t{});
+			quick_list_size = 0;
+			total_dirty_size = 0;
+			decay_last_dirty_size = 0;
+		}
+
+	private:
+		// chunk fits any descriptor block pool, pool_alloc_t uses the same block pool size
+		void init_meta_region() {
+			if constexpr(use_compact_descr) {
+				std::size_t reserve_size = (std::size_t)1 << meta_region_bits;
+				std::size_t commit_size = align_value(base_t::alloc_meta_commit_size, page_size);
+				std::size_t alignment = base_t::alloc_meta_huge_page_mode != huge_page_mode_t::None ? commit_size : page_size;
+				assert(std::max(commit_size, block_pool_size) <= reserve_size);
+				meta_region.init(block_pool_size, reserve_size, std::max(commit_size, block_pool_size), alignment, page_size, base_t::alloc_meta_huge_page_mode,
+					reserve_size);
+			} else if constexpr(base_t::use_meta_region && has_reserve_v<base_t>) {
+				std::size_t commit_size = align_value(base_t::alloc_meta_commit_size, page_size);
+				std::size_t alignment = base_t::alloc_meta_huge_page_mode != huge_page_mode_t::None ? commit_size : page_size;
+				std::size_t chunk_size = std::max(block_pool_size, sysmem_pool_size);
+				meta_region.init(chunk_size, base_t::alloc_meta_reserve_size, std::max(commit_size, chunk_size), alignment, page_size, base_t::alloc_meta_huge_page_mode);
+			}
+		}
+
+		// compact descriptors must stay in the metadata region so their pools have no fallback
+		[[nodiscard]] void* allocate_descr_pool(std::size_t size) {
+			if constexpr(use_compact_descr) {
+				return meta_region.allocate((base_t&)*this, size);
+			} else {
+				return allocate_meta(size);
+			}
+		}
+
+	public:
+		// descriptor block pools are allocated from the metadata region, regular system memory is used as a fallback
+		[[nodiscard]] void* allocate_meta(std::size_t size) {
+			if constexpr(base_t::use_meta_region && has_reserve_v<base_t>) {
+				if (void* pool = meta_region.allocate((base_t&)*this, size)) {
+					return pool;
+				}
+			} return base_t::allocate(size);
+		}
+
+		// returns how many bytes were returned to the system, metadata chunks are kept for reuse
+		std::size_t deallocate_meta(void* ptr, std::size_t size) {
+			if (meta_region.deallocate(ptr)) {
+				return 0;
+			}
+			base_t::deallocate(ptr, size);
+			return size;
+		}
+
+		// huge allocations get their own mapping from the system allocator, page runs & indices are never touched
+		[[nodiscard]] void* allocate_direct(std::size_t size) {
+			return base_t::allocate(align_value(size, page_size));
+		}
+
+		void deallocate_direct(void* ptr, std::size_t size) {
+			base_t::deallocate(ptr, align_value(size, page_size));
+		}
+
+		bool is_meta_ptr(void* ptr) const {
+			return meta_region.contains(ptr);
+		}
+
+		// free chunks of the metadata region are uncommitted or decommitted, returns how many bytes were released
+		std::size_t trim_meta() {
+			if constexpr(base_t::use_meta_region && has_reserve_v<base_t>) {
+				return meta_region.trim((base_t&)*this);
+			} return 0;
 		}
 
 	private:
@@ -250,7 +583,7 @@ namespace cuw::mem {
 			}
 
 			std::size_t pool_size = sysmem_pool_size;
-			void* pool_data = base_t::allocate(pool_size);
+			void* pool_data = allocate_descr_pool(pool_size);
 			if (!pool_data) {
 				return nullptr;
 			}
@@ -261,7 +594,7 @@ namespace cuw::mem {
 		void free_smd(smd_t* smd, block_pool_release_mode_t mode = block_pool_release_mode_t::ReinsertFree) {
 			if (bp_t* bp = smd_entry.release(smd, mode)) {
 				smd_entry.finish_release(bp, [&] (void* data, std::size_t size) {
-					base_t::deallocate(data, size);
+					deallocate_meta(data, size);
 				});
 			}
 		}
@@ -275,22 +608,228 @@ namespace cuw::mem {
 				return nullptr;
 			}
 
-			smd->data = base_t::allocate(size);
-			if (!smd->data) {
+			smd->set_block(base_t::allocate(size), size);
+			if (!smd->get_start()) {
 				free_smd(smd);
 				return nullptr;
 			}
 
-			smd_addr = trb::insert_lb(smd_addr, &smd->addr_index, smd_t::addr_index_search_t{});
+			smd_addr = trb::insert_lb(smd_addr, &smd->addr_index, typename smd_t::addr_index_search_t{});
+			sysmem_size += size;
+			return smd;
+		}
+
+		// memory was mapped outside of a lock (deferred mode)
+		[[nodiscard]] smd_t* adopt_memory(void* data, std::size_t size) {
+			smd_t* smd = alloc_smd(data, size);
+			if (!smd) {
+				return nullptr;
+			}
+
+			smd_addr = trb::insert_lb(smd_addr, &smd->addr_index, typename smd_t::addr_index_search_t{});
+			sysmem_size += size;
 			return smd;
 		}
 
 		void free_memory(smd_t* smd) {
-			base_t::deallocate(smd->data, smd->size);
+			sysmem_size -= smd->get_size();
+			base_t::deallocate(smd->get_start(), smd->get_size());
 			smd_addr = trb::remove(smd_addr, &smd->addr_index);
 			free_smd(smd);
 		}
 
+	private:
+		static constexpr std::size_t sysmem_queue_size = base_t::alloc_sysmem_queue_size;
+
+		bool can_queue_sysmem_op() const {
+			return deferred_sysmem_ops && sysmem_op_count != sysmem_queue_size;
+		}
+
+		// returns false if the call must be made right away (deferred mode is off or the queue is full)
+		bool queue_sysmem_op(const sysmem_op_t& op) {
+			if (!can_queue_sysmem_op()) {
+				return false;
+			}
+			sysmem_ops[sysmem_op_count++] = op;
+			return true;
+		}
+
+		// ops that were not taken when deferred mode is turned off
+		void execute_sysmem_op(sysmem_op_t& op) {
+			switch (op.type) {
+				case sysmem_op_type_t::Decommit: {
+					if constexpr(has_decommit_v<base_t>) {
+						base_t::decommit(op.ptr, op.size);
+						op.done = true;
+					} break;
+				}
+
+				case sysmem_op_type_t::Uncommit: {
+					if constexpr(has_reserve_v<base_t>) {
+						base_t::uncommit(op.ptr, op.size);
+						op.done = true;
+					} break;
+				}
+
+				case sysmem_op_type_t::Map: {
+					if (!(op.ptr = base_t::allocate(op.size)) && op.min_size != op.size) {
+						op.size = op.min_size;
+						op.ptr = base_t::allocate(op.size);
+					} op.done = op.ptr != nullptr;
+					break;
+				}
+
+				case sysmem_op_type_t::Commit: {
+					if constexpr(has_reserve_v<base_t>) {
+						if (!(op.done = base_t::commit(op.ptr, op.size)) && op.min_size != op.size) {
+							op.size = op.min_size;
+							op.done = base_t::commit(op.ptr, op.size);
+						}
+					} break;
+				}
+			}
+		}
+
+		// spare memory that was prepared outside of a lock but was not used yet, returns how many bytes were released
+		std::size_t release_spare() {
+			std::size_t released = spare_region_size;
+			if (spare_region) {
+				base_t::deallocate(spare_region, spare_region_size);
+				spare_region = nullptr;
+				spare_region_size = 0;
+			} if constexpr(base_t::use_heap_reservation && has_reserve_v<base_t>) {
+				std::size_t spare_size = (char*)heap_spare_end - (char*)heap_top;
+				if (spare_size != 0 && !heap_op_pending) {
+					released += spare_size;
+					if (queue_sysmem_op({.type = sysmem_op_type_t::Uncommit, .ptr = heap_top, .size = spare_size})) {
+						heap_op_pending = true;
+					} else {
+						base_t::uncommit(heap_top, spare_size);
+						heap_spare_end = heap_top;
+					}
+				}
+			} return released;
+		}
+
+	private:
+		// heap: one contiguous range of reserved address space, [heap_start, heap_top) is committed
+		// memory from the heap is never unmapped so it has no smds, free runs are only decommitted
+		bool is_heap_ptr(void* ptr) const {
+			return (std::uintptr_t)heap_start <= (std::uintptr_t)ptr && (std::uintptr_t)ptr < (std::uintptr_t)heap_end;
+		}
+
+		bool reserve_heap() {
+			if (heap_start) {
+				return true;
+			} if (heap_reserve_failed) {
+				return false;
+			}
+
+			std::size_t granularity = get_region_granularity();
+			std::size_t reserve_size = align_value(base_t::alloc_heap_reserve_size, granularity);
+			if (void* ptr = base_t::reserve(reserve_size, granularity)) {
+				heap_start = ptr;
+				heap_top = ptr;
+				heap_spare_end = ptr;
+				heap_end = advance_ptr(ptr, reserve_size);
+				return true;
+			}
+			heap_reserve_failed = true; // do not retry, fall back to separate regions
+			return false;
+		}
+
+		// heap cannot be extended while its commit or uncommit is queued or executed outside of a lock
+		bool can_extend_heap(std::size_t size) {
+			if constexpr(base_t::use_heap_reservation && has_reserve_v<base_t>) {
+				return reserve_heap() && !heap_op_pending && !heap_commit_failed && (std::size_t)((char*)heap_end - (char*)heap_top) >= size;
+			} else {
+				return false;
+			}
+		}
+
+		// spare part of the heap (committed outside of a lock) is used first, returns nullptr if the heap is exhausted
+		[[nodiscard]] void* extend_heap(std::size_t size) {
+			if constexpr(base_t::use_heap_reservation && has_reserve_v<base_t>) {
+				if (!can_extend_heap(size)) {
+					return nullptr;
+				}
+
+				void* end = advance_ptr(heap_top, size);
+				if ((std::uintptr_t)end > (std::uintptr_t)heap_spare_end) {
+					if (!base_t::commit(heap_spare_end, (char*)end - (char*)heap_spare_end)) {
+						return nullptr;
+					} heap_spare_end = end;
+				}
+
+				void* ptr = heap_top;
+				heap_top = end;
+				sysmem_size += size;
+				return ptr;
+			} else {
+				return nullptr;
+			}
+		}
+
+		// shrink policy: trailing free run of the heap is uncommitted
+		// one growth step (as if heap was extended right after shrink) is kept committed so we do not thrash
+		// returns the block (it is never removed)
+		fbd_t* try_shrink_heap(fbd_t* fbd) {
+			if constexpr(base_t::use_heap_reservation && has_reserve_v<base_t>) {
+				if (!fbd || fbd->get_end() != heap_top || heap_op_pending) {
+					return fbd;
+				}
+
+				std::size_t granularity = get_region_granularity();
+				std::size_t keep_size = align_value(std::clamp(sysmem_size - fbd->get_size(), min_block_size, max_block_size), granularity);
+				if (sysmem_size - fbd->get_size() + keep_size < retained_size) {
+					keep_size = align_value(retained_size - (sysmem_size - fbd->get_size()), granularity); // reserved memory stays committed
+				}
+				if (fbd->get_size() <= keep_size) {
+					return fbd;
+				}
+
+				void* heap_part = (std::uintptr_t)fbd->get_start() < (std::uintptr_t)heap_start ? heap_start : fbd->get_start();
+				std::size_t excess = std::min<std::size_t>(fbd->get_size() - keep_size, (char*)heap_top - (char*)heap_part);
+				excess &= ~(granularity - 1);
+				if (excess == 0) {
+					return fbd;
+				}
+
+				// deferred mode: spare part of the heap is uncommitted too, heap_top is lowered when the call is finished
+				void* ptr = shrink_fbd_right(fbd, excess);
+				if (queue_sysmem_op({.type = sysmem_op_type_t::Uncommit, .ptr = ptr, .size = (std::size_t)((char*)heap_spare_end - (char*)ptr)})) {
+					heap_op_pending = true;
+					return fbd;
+				}
+				base_t::uncommit(ptr, (char*)heap_spare_end - (char*)ptr);
+				heap_top = ptr;
+				heap_spare_end = ptr;
+				sysmem_size -= excess;
+			}
+			return fbd;
+		}
+
+		// growth policy: new region is as big as everything that is already allocated (heap doubles)
+		// clamped by [min_block_size, max_block_size]
+		std::size_t get_grow_size(std::size_t size) const {
+			std::size_t grow_size = std::clamp(sysmem_size, min_block_size, max_block_size);
+			return align_value(std::max(size, grow_size), get_region_granularity());
+		}
+
+		// retention policy (hysteresis): fully free region is unmapped only if at least one growth step of free memory
+		// remains without it, so a workload oscillating around a region boundary does not map & unmap it repeatedly
+		// reserved memory is never unmapped, trim() ignores retention
+		bool can_release_region(std::size_t region_size, bool retain) const {
+			if (sysmem_size - region_size < retained_size) {
+				return false;
+			} if constexpr(base_t::use_region_retention) {
+				if (retain) {
+					std::size_t free_size = sysmem_size - used_size - region_size;
+					return free_size >= std::clamp(sysmem_size - region_size, min_block_size, max_block_size);
+				}
+			} return true;
+		}
+
 	private:
 		[[nodiscard]] fbd_t* alloc_fbd(void* data, std::size_t size) {
 			if (fbd_t* fbd = fbd_entry.acquire(data, size)) {
@@ -298,7 +837,7 @@ namespace cuw::mem {
 			}
 			
 			std::size_t pool_size = block_pool_size;
-			void* pool_data = base_t::allocate(pool_size);
+			void* pool_data = allocate_descr_pool(pool_size);
 			if (pool_data) {
 				fbd_entry.create_pool(pool_data, pool_size);
 				return fbd_entry.acquire(data, size);
@@ -310,23 +849,43 @@ namespace cuw::mem {
 		void free_fbd(fbd_t* fbd, block_pool_release_mode_t mode = block_pool_release_mode_t::ReinsertFree) {
 			if (bp_t* bp = fbd_entry.release(fbd, mode)) {
 				fbd_entry.finish_release(bp, [&] (void* ptr, std::size_t size) {
-					base_t::deallocate(ptr, size);
+					deallocate_meta(ptr, size);
 				});
 			}
 		}
 
+	private:
+		void insert_fbd(fbd_t* fbd) {
+			fbd_addr = trb::insert_lb(fbd_addr, &fbd->addr_index, typename fbd_t::addr_index_search_t{}, typename fbd_t::addr_index_augment_t{});
+		}
+
+		void insert_fbd_hint(fbd_t* fbd, fbd_t* hint) {
+			fbd_addr = trb::insert_lb_hint(fbd_addr, &fbd->addr_index, hint ? &hint->addr_index : nullptr,
+				typename fbd_t::addr_index_search_t{}, typename fbd_t::addr_index_augment_t{});
+		}
+
+		void remove_fbd(fbd_t* fbd) {
+			fbd_addr = trb::remove(fbd_addr, &fbd->addr_index, typename fbd_t::addr_index_augment_t{});
+		}
+
+		// size of the block was changed in-place
+		void update_fbd(fbd_t* fbd) {
+			bst::propagate(&fbd->addr_index, typename fbd_t::addr_index_augment_t{});
+		}
+
 	private:
 		[[nodiscard]] void* shrink_fbd_left(fbd_t* fbd, std::size_t size) {
 			assert(size);
-			assert(fbd->size >= size);
+			assert(fbd->get_size() >= size);
 
 			void* ptr = fbd->get_start();
-			fbd_size = trb::remove(fbd_size, &fbd->size_index);
-			if (fbd->size != size) { // update block size by reinserting it into the free list
+			if (fbd->get_size() != size) { // block keeps its position in the index, only its size is updated
 				fbd->shrink_left(size);
-				fbd_size = trb::insert_lb(fbd_size, &fbd->size_index, fbd_t::size_index_search_t{});
+				set_dirty_size(fbd, std::min<attrs_t>(fbd->get_dirty_size(), fbd->get_size()));
+				update_fbd(fbd);
 			} else { // size will be zero, completely remove it from the free list
-				fbd_addr = trb::remove(fbd_addr, &fbd->addr_index);
+				set_dirty_size(fbd, 0);
+				remove_fbd(fbd);
 				free_fbd(fbd);
 			}
 
@@ -335,15 +894,16 @@ namespace cuw::mem {
 
 		[[nodiscard]] void* shrink_fbd_right(fbd_t* fbd, std::size_t size) {
 			assert(size);
-			assert(fbd->size >= size);
+			assert(fbd->get_size() >= size);
 
-			void* ptr = advance_ptr(fbd->get_start(), fbd->size - size);
-			fbd_size = trb::remove(fbd_size, &fbd->size_index);
-			if (fbd->size != size) { // update block size by reinserting it into the free list
+			void* ptr = advance_ptr(fbd->get_start(), fbd->get_size() - size);
+			if (fbd->get_size() != size) { // block keeps its position in the index, only its size is updated
 				fbd->shrink_right(size);
-				fbd_size = trb::insert_lb(fbd_size, &fbd->size_index, fbd_t::size_index_search_t{});
+				set_dirty_size(fbd, std::min<attrs_t>(fbd->get_dirty_size(), fbd->get_size()));
+				update_fbd(fbd);
 			} else { // size will be zero, completely remove it from the free list
-				fbd_addr = trb::remove(fbd_addr, &fbd->addr_index);
+				set_dirty_size(fbd, 0);
+				remove_fbd(fbd);
 				free_fbd(fbd);
 			}
 
@@ -376,13 +936,13 @@ namespace cuw::mem {
 			// 1) lb != nullptr => ins_pos != nullptr (we aditionally find predecessor, ins_pos is successor => we're good)
 			// 2) lb == nullptr, ins_pos can be nullptr (tree is empty) or not (we find successor)
 			// 3) that's it, no more cases
-			auto [lb_node, ins_pos_node] = bst::search_insert_lb(fbd_addr, ptr, fbd_t::addr_index_search_t{});
+			auto [lb_node, ins_pos_node] = bst::search_insert_lb(fbd_addr, ptr, typename fbd_t::addr_index_search_t{});
 
 			fbd_t* ins_pos = fbd_t::addr_index_to_descr(ins_pos_node);
 			fbd_t* right = fbd_t::addr_index_to_descr(lb_node);
 
 			fbd_t* left;
-			addr_index_t* left_node;
+			fbd_index_t* left_node;
 			if (!lb_node || lb_node != ins_pos_node) {
 				left_node = ins_pos_node;
 			} else {
@@ -390,7 +950,8 @@ namespace cuw::mem {
 			}
 			left = fbd_t::addr_index_to_descr(left_node);
 
-			fbd_t dummy = { .size = size, .data = ptr };
+			fbd_t dummy{};
+			dummy.set_block(ptr, size);
 			if (left && fbd_t::overlaps(&dummy, left) || right && fbd_t::overlaps(&dummy, right)) {
 				std::abort(); // most probably double free
 			}
@@ -405,7 +966,7 @@ namespace cuw::mem {
 		//
 		// if we dont require an fbd allocation(is_dummy can be true):
 		// coalesced_info_t info = ...;
-		// fbd_t dummy = {.size = size, .data = data};
+		// fbd_t dummy{}; dummy.set_block(data, size);
 		// insert_free_block(info, &dummy)
 		//
 		// if we require an fbd allocation(is_dummy must be false):
@@ -414,26 +975,26 @@ namespace cuw::mem {
 		// insert_free_block(info, block)
 		//
 		// block must not be in index before function call
-		// O(3 * log(n)) at worst
-		// returns coalesced block, block is already in the addr index but not in the size index so insert it into the size index when required
+		// O(2 * log(n)) at worst
+		// returns coalesced block, block is already in the addr index and its augmented data is up to date
 		fbd_t* coalesce_free_block(const coalesce_info_t& info, fbd_t* block, bool is_dummy) {
 			fbd_t* coalesced_block = block;
 			if (info.consumes_left) {
-				// block coalesces with the left block so we remove left block from the size index but keep in the addr index
-				fbd_size = trb::remove(fbd_size, &info.left->size_index);
-				info.left->extend_right(coalesced_block->size);
+				// block coalesces with the left block so we extend left block in-place
+				info.left->extend_right(coalesced_block->get_size());
+				merge_dirty(info.left, coalesced_block);
 				if (!is_dummy) {
 					free_fbd(coalesced_block);
 				} coalesced_block = info.left;
 			}
 			
 			if (info.consumes_right) {
-				// block coalesces with the right block so we remove right block from the size index but keep in the addr index
-				fbd_size = trb::remove(fbd_size, &info.right->size_index);
-				info.right->extend_left(coalesced_block->size);
+				// block coalesces with the right block so we extend right block in-place
+				info.right->extend_left(coalesced_block->get_size());
+				merge_dirty(info.right, coalesced_block);
 				if (info.consumes_left) {
-					// is already coalesced with the left block then remove right block from the addr index
-					fbd_addr = trb::remove(fbd_addr, &coalesced_block->addr_index);
+					// is already coalesced with the left block then remove left block from the addr index
+					remove_fbd(coalesced_block);
 					free_fbd(coalesced_block);
 				}
 				coalesced_block = info.right;
@@ -443,16 +1004,36 @@ namespace cuw::mem {
 				// block must not be dummy, block is not in addr index, insert
 				// block does not coalesce with any of the blocks so we must insert in into the addr index
 				assert(!is_dummy);
-				fbd_addr = trb::insert_lb_hint(fbd_addr, &coalesced_block->addr_index, &info.ins_pos->addr_index, fbd_t::addr_index_search_t{});
+				insert_fbd_hint(coalesced_block, info.ins_pos);
+			} else {
+				update_fbd(coalesced_block);
 			}
 
 			return coalesced_block;
 		}
 
-		void walk_free_smds(fbd_t* coalesced_block, void* ptr_hint) {
+		// merged dirty memory keeps the oldest epoch so it decays as if the blocks were not merged
+		void merge_dirty(fbd_t* into, const fbd_t* from) const {
+			if (from->get_dirty_size() && (!into->get_dirty_size() || get_age(from) > get_age(into))) {
+				into->set_dirty_epoch(from->get_dirty_epoch());
+			}
+			into->set_dirty_size(into->get_dirty_size() + from->get_dirty_size());
+		}
+
+		using free_parts_t = std::tuple<fbd_t*, fbd_t*>;
+
+		// returns blocks that remained after free smds were cut out
+		free_parts_t walk_free_smds(fbd_t* coalesced_block, void* ptr_hint, bool retain = true) {
+			// heap has no smds but the block can span regions adjacent to the heap (below & above it)
+			// so the walk starts from the smd containing the start of the block
+			bool in_heap = is_heap_ptr(ptr_hint);
+			if (in_heap) {
+				ptr_hint = coalesced_block->get_start();
+			}
+
 			// it always falls into the appropriate smd according to our algorithm
-			smd_t* curr_smd = smd_t::addr_index_to_descr(bst::lower_bound(smd_addr, ptr_hint, smd_t::containing_block_search_t{}));
-			if (!curr_smd || (std::uintptr_t)ptr_hint < (std::uintptr_t)curr_smd->get_start()) {
+			smd_t* curr_smd = smd_t::addr_index_to_descr(bst::lower_bound(smd_addr, ptr_hint, typename smd_t::containing_block_search_t{}));
+			if (!in_heap && (!curr_smd || (std::uintptr_t)ptr_hint < (std::uintptr_t)curr_smd->get_start())) {
 				std::abort(); // no containing sysmem region
 			}
 
@@ -468,7 +1049,7 @@ namespace cuw::mem {
 				auto overlap_end = std::min(coalesced_block_end, curr_smd_end);
 
 				smd_t* next_smd = smd_t::addr_index_to_descr(bst::successor(&curr_smd->addr_index)); // curr_smd can be freed so we get it beforehand
-				if (overlap_start == curr_smd_start && overlap_end == curr_smd_end) {
+				if (overlap_start == curr_smd_start && overlap_end == curr_smd_end && can_release_region(curr_smd->get_size(), retain)) {
 					cut_start = std::min(cut_start, overlap_start);
 					cut_end = std::max(cut_end, overlap_end);
 					free_memory(curr_smd);
@@ -478,60 +1059,222 @@ namespace cuw::mem {
 			}
 
 			if (cut_start >= cut_end) {
-				// no parts at all, inserting into the size index
-				fbd_size = trb::insert_lb(fbd_size, &coalesced_block->size_index, fbd_t::size_index_search_t{});
-				return;
+				// no parts at all, block stays as is
+				return {coalesced_block, nullptr};
 			}
+			return cut_free_block(coalesced_block, cut_start, cut_end);
+		}
 
+		// [cut_start, cut_end) is removed from the block, returns blocks that remained
+		// second_part: descriptor allocated beforehand for [cut_end, block end) if the cut splits the block
+		free_parts_t cut_free_block(fbd_t* coalesced_block, std::uintptr_t cut_start, std::uintptr_t cut_end, fbd_t* second_part = nullptr) {
+			auto coalesced_block_start = (std::uintptr_t)coalesced_block->get_start();
+			auto coalesced_block_end = (std::uintptr_t)coalesced_block->get_end();
+			attrs_t dirty_size = coalesced_block->get_dirty_size();
 			if (cut_start != coalesced_block_start) {
 				// shrinking block so it has the same size as the first part
 				coalesced_block->shrink_right(coalesced_block_end - cut_start);
-				fbd_size = trb::insert_lb(fbd_size, &coalesced_block->size_index, fbd_t::size_index_search_t{}); // block already in the size index
+				set_dirty_size(coalesced_block, std::min<attrs_t>(dirty_size, coalesced_block->get_size()));
+				update_fbd(coalesced_block);
 
 				if (cut_end != coalesced_block_end) {
-					// inserting the second part both into the size index and the addr index
-					if (fbd_t* fbd = alloc_fbd((void*)cut_end, coalesced_block_end - cut_end)) {
-						fbd_addr = trb::insert_lb(fbd_addr, &fbd->addr_index, fbd_t::addr_index_search_t{});
-						fbd_size = trb::insert_lb(fbd_size, &fbd->size_index, fbd_t::size_index_search_t{});
+					// inserting the second part into the addr index
+					if (fbd_t* fbd = second_part ? second_part : alloc_fbd((void*)cut_end, coalesced_block_end - cut_end)) {
+						set_dirty_size(fbd, std::min<attrs_t>(dirty_size, fbd->get_size()));
+						fbd->set_dirty_epoch(coalesced_block->get_dirty_epoch());
+						insert_fbd(fbd);
+						return {coalesced_block, fbd};
 					} else {
 						std::abort(); // we cannot allocate a fbd
 					}
 				}
+				return {coalesced_block, nullptr};
 			} else if (cut_end != coalesced_block_end) {
-				// first part is missing, inserting the second part
+				// first part is missing, keeping the second part
 				coalesced_block->shrink_left(cut_end - coalesced_block_start);
-				fbd_size = trb::insert_lb(fbd_size, &coalesced_block->size_index, fbd_t::size_index_search_t{});
+				set_dirty_size(coalesced_block, std::min<attrs_t>(dirty_size, coalesced_block->get_size()));
+				update_fbd(coalesced_block);
+				return {coalesced_block, nullptr};
 			} else {
 				// cut whole block => no parts, completely remove block from the index
-				fbd_addr = trb::remove(fbd_addr, &coalesced_block->addr_index);
+				set_dirty_size(coalesced_block, 0);
+				remove_fbd(coalesced_block);
 				free_fbd(coalesced_block);
+				return {nullptr, nullptr};
+			}
+		}
+
+		// block keeps its dirty memory, total amount of dirty memory is updated
+		void set_dirty_size(fbd_t* fbd, attrs_t dirty_size) {
+			total_dirty_size = total_dirty_size - fbd->get_dirty_size() + dirty_size;
+			fbd->set_dirty_size(dirty_size);
+		}
+
+		// range is shrinked to the region granularity so huge pages are not split, edges can remain dirty
+		// returns how many bytes were decommitted
+		// deferred mode: decommitted range is cut out of the block until the call is finished,
+		// call is executed right away if the block would be split & descriptor of the second part cannot be allocated
+		std::size_t decommit_free_block(fbd_t* fbd, std::uintptr_t dirty_start, std::uintptr_t dirty_end) {
+			if constexpr(has_decommit_v<base_t>) {
+				std::size_t granularity = get_region_granularity();
+				auto block_start = (std::uintptr_t)fbd->get_start();
+				auto block_end = (std::uintptr_t)fbd->get_end();
+				auto start = align_value(std::max(dirty_start, block_start), granularity);
+				auto end = std::min(dirty_end, block_end) & ~(std::uintptr_t)(granularity - 1);
+				set_dirty_size(fbd, 0);
+				if (start >= end) {
+					return 0;
+				}
+
+				fbd_t* second_part = nullptr;
+				bool splits = start != block_start && end != block_end;
+				if (can_queue_sysmem_op() && splits) {
+					second_part = alloc_fbd((void*)end, block_end - end);
+				} if ((!splits || second_part) && queue_sysmem_op({.type = sysmem_op_type_t::Decommit, .ptr = (void*)start, .size = end - start})) {
+					(void)cut_free_block(fbd, start, end, second_part);
+					return end - start;
+				} if (second_part) {
+					free_fbd(second_part);
+				}
+				base_t::decommit((void*)start, end - start);
+				return end - start;
+			} return 0;
+		}
+
+		// immediate decommit (decay time is zero): dirty part of the block is decommitted if enough dirty memory was accumulated
+		void try_decommit_free_block(fbd_t* fbd, std::uintptr_t dirty_start, std::uintptr_t dirty_end) {
+			if (!fbd || decay_time_ms != 0 || fbd->get_dirty_size() < decommit_threshold) {
+				return;
 			}
+			decommit_free_block(fbd, dirty_start, dirty_end);
 		}
 
-		// O(12 * log(n) + walk), (insert_lb counts as 2 operations)
-		void insert_free_block(void* ptr, std::size_t size) {
+	private:
+		static constexpr std::size_t decay_steps = decay_epoch_count;
+		static constexpr std::uint64_t decay_scale = (std::uint64_t)1 << 16;
+
+		// fraction of memory (scaled by decay_scale) that can remain dirty after age epochs: 1 - smoothstep((age + 1) / steps)
+		static constexpr std::uint64_t decay_fraction(std::size_t age) {
+			double x = (double)(age + 1) / decay_steps;
+			return (std::uint64_t)((1.0 - x * x * (3.0 - 2.0 * x)) * decay_scale);
+		}
+
+		static std::uint64_t get_time_ms() {
+			auto now = std::chrono::steady_clock::now().time_since_epoch();
+			return std::chrono::duration_cast<std::chrono::milliseconds>(now).count();
+		}
+
+		std::size_t get_age(const fbd_t* fbd) const {
+			attrs_t age = (attrs_t)(std::uint16_t)(decay_epoch - fbd->get_dirty_epoch());
+			return std::min<attrs_t>(age, decay_steps);
+		}
+
+		// advances decay epochs, newly accumulated dirty memory goes into the backlog
+		// returns false if epoch was not changed
+		bool advance_decay(std::uint64_t now_ms) {
+			std::uint64_t epoch_ms = std::max<std::uint64_t>(decay_time_ms / decay_steps, 1);
+			if (now_ms < decay_last_ms + epoch_ms) {
+				return false;
+			}
+
+			std::uint64_t epochs = (now_ms - decay_last_ms) / epoch_ms;
+			decay_last_ms += epochs * epoch_ms;
+			for (std::uint64_t i = 0; i < std::min<std::uint64_t>(epochs, decay_steps); i++) {
+				std::copy_backward(std::begin(decay_backlog), std::end(decay_backlog) - 1, std::end(decay_backlog));
+				decay_backlog[0] = 0;
+			}
+			decay_epoch = (std::uint16_t)(decay_epoch + epochs);
+			decay_backlog[std::min<std::uint64_t>(epochs, decay_steps) - 1] += total_dirty_size > decay_last_dirty_size ? total_dirty_size - decay_last_dirty_size : 0;
+			return true;
+		}
+
+		std::size_t get_decay_limit() const {
+			std::uint64_t limit = 0;
+			for (std::size_t age = 0; age < decay_steps; age++) {
+				limit += decay_backlog[age] / decay_scale * decay_fraction(age) + decay_backlog[age] % decay_scale * decay_fraction(age) / decay_scale;
+			}
+			return limit;
+		}
+
+		// decommits the oldest dirty blocks until amount of dirty memory fits the limit
+		void purge_dirty(std::size_t limit) {
+			if (total_dirty_size <= limit) {
+				return;
+			}
+
+			std::size_t dirty_by_age[decay_steps + 1] = {};
+			bst::traverse_inorder(fbd_addr, [&] (fbd_index_t* node) {
+				fbd_t* fbd = fbd_t::addr_index_to_descr(node);
+				dirty_by_age[get_age(fbd)] += fbd->get_dirty_size();
+			});
+
+			// blocks are decommitted as a whole so age group is skipped if it overshoots the limit too much
+			std::size_t min_age = decay_steps + 1;
+			for (std::size_t remaining = total_dirty_size; min_age > 0 && remaining > limit; min_age--) {
+				if (dirty_by_age[min_age - 1] > 2 * (remaining - limit)) {
+					break;
+				} remaining -= dirty_by_age[min_age - 1];
+			}
+
+			// blocks can be cut while decommitted so the index is walked by address
+			for (void* cursor = nullptr; fbd_index_t* node = bst::lower_bound(fbd_addr, cursor, typename fbd_t::addr_index_search_t{}); ) {
+				fbd_t* fbd = fbd_t::addr_index_to_descr(node);
+				cursor = fbd->get_end();
+				if (fbd->get_dirty_size() && get_age(fbd) >= min_age) {
+					decommit_free_block(fbd, (std::uintptr_t)fbd->get_start(), (std::uintptr_t)fbd->get_end());
+				}
+			}
+		}
+
+		void tick_decay() {
+			if (decay_time_ms > 0 && ++decay_ticks == decay_tick_count) {
+				decay_ticks = 0;
+				purge_decayed(get_time_ms());
+			}
+		}
+
+		// O(6 * log(n) + walk), (insert_lb counts as 2 operations)
+		// dirty: memory was touched (freed by user), false for freshly mapped memory
+		void insert_free_block(void* ptr, std::size_t size, bool dirty = true) {
 			fbd_t* coalesced_block = nullptr;
 			coalesce_info_t info = get_coalesce_info(ptr, size);
+
+			// dirty memory is contiguous: dirty neighbours (conservatively as a whole) and the freed block
+			auto dirty_start = (std::uintptr_t)(info.consumes_left && info.left->get_dirty_size() ? info.left->get_start() : ptr);
+			auto dirty_end = (std::uintptr_t)(info.consumes_right && info.right->get_dirty_size() ? info.right->get_end() : advance_ptr(ptr, size));
+
+			attrs_t dirty_size = dirty ? size : 0;
+			total_dirty_size += dirty_size;
 			if (info.requires_fbd_alloc()) {
 				fbd_t* fbd = alloc_fbd(ptr, size);
 				if (!fbd) {
 					std::abort();
 				}
+				fbd->set_dirty_size(dirty_size);
+				fbd->set_dirty_epoch(decay_epoch);
 				coalesced_block = coalesce_free_block(info, fbd, false);
 			} else {
-				fbd_t dummy{ .size = size, .data = ptr };
+				fbd_t dummy{};
+				dummy.set_block(ptr, size);
+				dummy.set_dirty_size(dirty_size);
+				dummy.set_dirty_epoch(decay_epoch);
 				coalesced_block = coalesce_free_block(info, &dummy, true);
 			}
 
 			// EHEHE! DIRTY OPTIMIZATION HACK!
-			if constexpr(base_t::use_dirty_optimization_hacks) {
-				// only insert block into the size index (not inserted after coalesce_free_block)
-				// it becomes little bit cheaper but we no longer free virtual memory
-				// can be fixed be manually doing it but for now there is no such function
-				fbd_size = trb::insert_lb(fbd_size, &coalesced_block->size_index, fbd_t::size_index_search_t{});
+			// skip walk: it becomes little bit cheaper but we no longer free virtual memory (only decommit it)
+			// can be fixed be manually doing it but for now there is no such function
+			if constexpr(!base_t::use_dirty_optimization_hacks) {
+				// process free smds & decommit what is remaining
+				auto [first, second] = walk_free_smds(coalesced_block, ptr);
+				try_decommit_free_block(try_shrink_heap(first), dirty_start, dirty_end);
+				try_decommit_free_block(try_shrink_heap(second), dirty_start, dirty_end);
 			} else {
-				// process free smds & insert what is remaining into the size index
-				walk_free_smds(coalesced_block, ptr);
+				try_decommit_free_block(try_shrink_heap(coalesced_block), dirty_start, dirty_end);
+			}
+
+			if (dirty) {
+				tick_decay();
 			}
 		}
 
@@ -544,19 +1287,38 @@ namespace cuw::mem {
 		[[nodiscard]] void* try_alloc_from_existing(std::size_t size) {
 			assert(is_aligned(size, page_size));
 
-			if (addr_index_t* found = bst::lower_bound(fbd_size, size, fbd_t::size_index_search_t{})) {
-				return bite_free_block(fbd_t::size_index_to_descr(found), size);
+			if (fbd_t* found = fbd_t::find_first_fit(fbd_addr, size)) {
+				bool clean = found->get_dirty_size() < found->get_size(); // can contain decommitted pages
+				void* ptr = bite_free_block(found, size);
+				if (clean) {
+					try_prefault(ptr, size);
+				} return ptr;
 			}
 
 			return nullptr;
 		}
 
 		// always allocates fbd for the remaining memory as a simplification
+		// heap is extended first (if enabled), separate regions are used when it is exhausted
 		// as a fallback tries to allocate smaller memory region in case of failure
 		[[nodiscard]] void* try_alloc_by_extend(std::size_t size) {
 			assert(is_aligned(size, page_size));
 
-			std::size_t size_ext = std::max(size, min_block_size);
+			std::size_t size_ext = get_grow_size(size);
+			if (can_queue_sysmem_op()) {
+				return try_alloc_from_spare(size, size_ext);
+			}
+
+			std::size_t heap_size = size_ext;
+			void* heap_ptr = extend_heap(heap_size);
+			if (!heap_ptr && heap_size != size) {
+				heap_size = size;
+				heap_ptr = extend_heap(heap_size); // fallback
+			} if (heap_ptr) {
+				if (heap_size != size) {
+					insert_free_block(advance_ptr(heap_ptr, size), heap_size - size, false);
+				} return heap_ptr;
+			}
 
 			smd_t* smd = alloc_memory(size_ext); 
 			if (!smd) {
@@ -567,14 +1329,62 @@ namespace cuw::mem {
 				size_ext = size;
 			}
 
-			void* rest_ptr = (char*)smd->data + size;
+			void* rest_ptr = advance_ptr(smd->get_start(), size);
 			std::size_t rest_size = size_ext - size;
 			if (rest_size == 0) {
-				return smd->data;
+				return smd->get_start();
 			}
 
-			insert_free_block(rest_ptr, rest_size);
-			return smd->data;
+			insert_free_block(rest_ptr, rest_size, false);
+			return smd->get_start();
+		}
+
+		// deferred mode: memory is taken from the spare part of the heap or from the spare region, both are prepared
+		// outside of a lock, if they are too small Commit or Map is queued & allocation fails until the call is finished
+		[[nodiscard]] void* try_alloc_from_spare(std::size_t size, std::size_t size_ext) {
+			if (can_extend_heap(size)) {
+				std::size_t heap_size = std::min<std::size_t>(size_ext, (char*)heap_end - (char*)heap_top);
+				std::size_t spare_size = (char*)heap_spare_end - (char*)heap_top;
+				if (spare_size < size) {
+					heap_op_pending = true;
+					queue_sysmem_op({.type = sysmem_op_type_t::Commit, .ptr = heap_spare_end, .size = heap_size - spare_size, .min_size = size - spare_size});
+					return nullptr;
+				}
+
+				heap_size = std::min(heap_size, spare_size);
+				void* heap_ptr = extend_heap(heap_size);
+				if (heap_size != size) {
+					insert_free_block(advance_ptr(heap_ptr, size), heap_size - size, false);
+				} return heap_ptr;
+			}
+
+			if (spare_region_size < size) {
+				queue_map_op(size_ext, size);
+				return nullptr;
+			}
+
+			smd_t* smd = adopt_memory(spare_region, spare_region_size);
+			if (!smd) {
+				return nullptr;
+			}
+			spare_region = nullptr;
+			spare_region_size = 0;
+
+			if (smd->get_size() != size) {
+				insert_free_block(advance_ptr(smd->get_start(), size), smd->get_size() - size, false);
+			} return smd->get_start();
+		}
+
+		// one Map is queued per lock session, the biggest request wins
+		void queue_map_op(std::size_t size, std::size_t min_size) {
+			for (std::size_t i = 0; i < sysmem_op_count; i++) {
+				if (sysmem_op_t& op = sysmem_ops[i]; op.type == sysmem_op_type_t::Map) {
+					op.size = std::max(op.size, size);
+					op.min_size = std::max(op.min_size, min_size);
+					return;
+				}
+			}
+			queue_sysmem_op({.type = sysmem_op_type_t::Map, .size = size, .min_size = min_size});
 		}
 
 		[[nodiscard]] void* try_alloc_memory(std::size_t size) {
@@ -586,15 +1396,124 @@ namespace cuw::mem {
 			return try_alloc_by_extend(size);
 		}
 
+		// prefault mode: populates memory that could have been decommitted, fresh memory is populated by the base allocator
+		void try_prefault(void* ptr, std::size_t size) {
+			if constexpr(has_prefault_v<base_t>) {
+				if (base_t::get_prefault_mode()) {
+					base_t::prefault(ptr, size);
+				}
+			}
+		}
+
+	private:
+		static constexpr std::size_t quick_list_count = base_t::alloc_quick_list_pages;
+
+		// freed run is linked through its first bytes, it stays allocated from the point of view of the free block index
+		struct quick_block_t {
+			quick_block_t* next{};
+		};
+
+		struct quick_list_t {
+			quick_block_t* head{};
+			std::size_t count{};
+		};
+
+		// returns quick_list_count if run is empty or too big
+		std::size_t get_quick_list_index(std::size_t size) const {
+			std::size_t pages = size / page_size;
+			if (pages == 0 || pages > quick_list_count) {
+				return quick_list_count;
+			} return pages - 1;
+		}
+
+		// lazy coalescing: runs are inserted into the free block index all at once
+		void flush_quick_list(std::size_t index) {
+			std::size_t size = (index + 1) * page_size;
+			quick_list_t& list = quick_lists[index];
+			while (quick_block_t* block = list.head) {
+				list.head = block->next;
+				insert_free_block(block, size);
+			}
+			quick_list_size -= list.count * size;
+			list.count = 0;
+		}
+
+		void flush_quick_lists() {
+			for (std::size_t index = 0; index < quick_list_count && quick_list_size != 0; index++) {
+				flush_quick_list(index);
+			}
+		}
+
+		[[nodiscard]] void* pop_quick_block(std::size_t size) {
+			std::size_t index = get_quick_list_index(size);
+			if (index == quick_list_count || !quick_lists[index].head) {
+				return nullptr;
+			}
+
+			quick_list_t& list = quick_lists[index];
+			quick_block_t* block = list.head;
+			list.head = block->next;
+			--list.count;
+			quick_list_size -= size;
+			return block;
+		}
+
+		// returns false if run is too big
+		bool push_quick_block(void* ptr, std::size_t size) {
+			std::size_t index = get_quick_list_index(size);
+			if (index == quick_list_count || size > base_t::alloc_max_quick_list_size) {
+				return false;
+			}
+
+			if (quick_lists[index].count == base_t::alloc_quick_list_depth) {
+				flush_quick_list(index);
+			} if (quick_list_size + size > base_t::alloc_max_quick_list_size) {
+				flush_quick_lists();
+			}
+
+			quick_list_t& list = quick_lists[index];
+			list.head = new (ptr) quick_block_t{list.head};
+			++list.count;
+			quick_list_size += size;
+			return true;
+		}
+
 	public:
 		[[nodiscard]] void* allocate(std::size_t size) {
-			return try_alloc_memory(align_value(size, page_size));
+			size = align_value(size, page_size);
+			void* ptr = pop_quick_block(size);
+			if (!ptr) {
+				ptr = try_alloc_memory(size);
+			} if (ptr) {
+				used_size += size;
+			}
+			return ptr;
 		}
 
 		// when we deallocate we check if we require fbd for that as in the case of heavy fragmentation so we don't waste
 		// unneccessary fbds for that
+		// runs of up to alloc_quick_list_pages pages are kept in exact-size quick lists first
 		void deallocate(void* ptr, std::size_t size) {
-			insert_free_block(ptr, align_value(size, page_size));
+			size = align_value(size, page_size);
+			used_size -= size;
+			if (!push_quick_block(ptr, size)) {
+				insert_free_block(ptr, size);
+			}
+		}
+
+		// pre-maps & prefaults at least size bytes of free memory so the first allocations don't page fault
+		// reserved memory is never unmapped and is not purged by decay until it is allocated & freed again
+		[[nodiscard]] bool reserve(std::size_t size) {
+			size = align_value(size, page_size);
+			void* ptr = try_alloc_memory(size);
+			if (!ptr) {
+				return false;
+			} if constexpr(has_prefault_v<base_t>) {
+				base_t::prefault(ptr, size);
+			}
+			retained_size += size;
+			insert_free_block(ptr, size, false);
+			return true;
 		}
 
 		[[nodiscard]] void* reallocate(void* old_ptr, std::size_t old_size, std::size_t new_size) {
@@ -608,18 +1527,20 @@ namespace cuw::mem {
 			if (new_size_aligned < old_size_aligned) {
 				void* old_ptr_end = (char*)old_ptr + new_size_aligned;
 				std::size_t delta = old_size_aligned - new_size_aligned;
+				used_size -= delta;
 				insert_free_block(old_ptr_end, delta);
 				return old_ptr;
 			}
 
 			// new_size_aligned > old_size_aligned
 			// check if there is a block adjacent to right of the allocation
-			if (addr_index_t* found = bst::lower_bound(fbd_addr, old_ptr, fbd_t::addr_index_search_t{})) {
+			if (fbd_index_t* found = bst::lower_bound(fbd_addr, old_ptr, typename fbd_t::addr_index_search_t{})) {
 				fbd_t* block = fbd_t::addr_index_to_descr(found);
 				void* old_ptr_end = (char*)old_ptr + old_size_aligned;
 				std::size_t delta = new_size_aligned - old_size_aligned;
-				if (old_ptr_end == block->get_start() && block->size >= delta) {
-					void* dummy = bite_free_block(block, delta); // next allocated block is neighbour to us
+				if (old_ptr_end == block->get_start() && block->get_size() >= delta) {
+					(void)bite_free_block(block, delta); // next allocated block is neighbour to us
+					used_size += delta;
 					return old_ptr;
 				}
 			}
@@ -634,11 +1555,92 @@ namespace cuw::mem {
 		}
 
 	public:
-		// mostly for debugging purpose
-		auto get_size_index() const {
-			return bst::tree_wrapper_t{fbd_size};
+		// deferred mode: system calls made on behalf of allocations & frees (except unmaps of the base allocator)
+		// are queued, caller takes them under a lock, executes them without it & hands results back under the lock
+		// decommitted & uncommitted ranges are cut out of the free block index until then, allocation that needs
+		// a new region or a heap commit fails & queues Map or Commit, obtained memory is kept as a spare for the next try
+		// queued ops are executed right away when the mode is turned off
+		void set_deferred_sysmem_ops(bool mode) {
+			deferred_sysmem_ops = mode;
+			if (!mode) {
+				sysmem_op_t ops[sysmem_queue_size];
+				std::size_t count = take_sysmem_ops(ops);
+				for (std::size_t i = 0; i < count; i++) {
+					execute_sysmem_op(ops[i]);
+				}
+				(void)finish_sysmem_ops(ops, count);
+			}
+		}
+
+		bool get_deferred_sysmem_ops() const {
+			return deferred_sysmem_ops;
 		}
 
+		// ops must fit sysmem_queue_size entries, returns count of ops
+		std::size_t take_sysmem_ops(sysmem_op_t* ops) {
+			std::copy(sysmem_ops, sysmem_ops + sysmem_op_count, ops);
+			return std::exchange(sysmem_op_count, 0);
+		}
+
+		// returns true if memory was obtained (or heap fell back to regions) so failed allocation can be retried
+		[[nodiscard]] bool finish_sysmem_ops(const sysmem_op_t* ops, std::size_t count) {
+			bool retry = false;
+			for (std::size_t i = 0; i < count; i++) {
+				const sysmem_op_t& op = ops[i];
+				switch (op.type) {
+					case sysmem_op_type_t::Decommit: {
+						insert_free_block(op.ptr, op.size, !op.done);
+						break;
+					}
+
+					case sysmem_op_type_t::Uncommit: {
+						// free run is returned while heap_op_pending is still set so it is not shrinked again
+						std::size_t size = (char*)heap_top - (char*)op.ptr;
+						if (op.done) {
+							heap_top = op.ptr;
+							heap_spare_end = op.ptr;
+							sysmem_size -= size;
+						} else if (size != 0) {
+							insert_free_block(op.ptr, size);
+						}
+						heap_op_pending = false;
+						break;
+					}
+
+					// the bigger region is kept as the spare
+					case sysmem_op_type_t::Map: {
+						if (!op.done) {
+							break;
+						} if (spare_region_size < op.size) {
+							if (spare_region) {
+								base_t::deallocate(spare_region, spare_region_size);
+							}
+							spare_region = op.ptr;
+							spare_region_size = op.size;
+						} else {
+							base_t::deallocate(op.ptr, op.size);
+						}
+						retry = true;
+						break;
+					}
+
+					// heap falls back to regions if it cannot be committed
+					case sysmem_op_type_t::Commit: {
+						if (op.done) {
+							heap_spare_end = advance_ptr(op.ptr, op.size);
+						} else {
+							heap_commit_failed = true;
+						}
+						heap_op_pending = false;
+						retry = true;
+						break;
+					}
+				}
+			}
+			return retry;
+		}
+
+	public:
 		// mostly for debugging purpose
 		auto get_addr_index() const {
 			return bst::tree_wrapper_t{fbd_addr};
@@ -652,6 +1654,13 @@ namespace cuw::mem {
 			return page_size;
 		}
 
+		// regions are multiple of the huge page size (when huge pages are used) so huge pages are never split
+		std::size_t get_region_granularity() const {
+			if constexpr(has_huge_pages_v<base_t>) {
+				return std::max(page_size, base_t::get_huge_page_size());
+			} return page_size;
+		}
+
 		std::size_t get_block_pool_size() const {
 			return block_pool_size;
 		}
@@ -660,21 +1669,151 @@ namespace cuw::mem {
 			return min_block_size;
 		}
 
+		std::size_t get_max_block_size() const {
+			return max_block_size;
+		}
+
+		// memory mapped in regions and committed in the heap
+		std::size_t get_sysmem_size() const {
+			return sysmem_size;
+		}
+
 		std::size_t get_sysmem_pool_size() const {
 			return sysmem_pool_size;
 		}
 
+		// memory that is kept mapped because of reserve()
+		std::size_t get_retained_size() const {
+			return retained_size;
+		}
+
+		// freed runs kept in quick lists, they are not in the free block index until flushed
+		std::size_t get_quick_list_size() const {
+			return quick_list_size;
+		}
+
+		std::size_t get_decommit_threshold() const {
+			return decommit_threshold;
+		}
+
+		// committed part of the heap, 0 if heap reservation is not used
+		std::size_t get_heap_size() const {
+			return (char*)heap_top - (char*)heap_start;
+		}
+
+		std::size_t get_dirty_size() const {
+			return total_dirty_size;
+		}
+
+	public:
+		// decay: dirty memory is decommitted gradually during decay time after it was freed
+		// < 0 - never decommit, 0 - decommit immediately (block must accumulate decommit_threshold of dirty memory)
+		void set_decay_time(std::int64_t time_ms) {
+			decay_time_ms = time_ms;
+			decay_last_ms = get_time_ms();
+			decay_last_dirty_size = total_dirty_size;
+			std::fill(std::begin(decay_backlog), std::end(decay_backlog), 0);
+			if (decay_time_ms == 0) {
+				purge_dirty(0);
+			}
+		}
+
+		std::int64_t get_decay_time() const {
+			return decay_time_ms;
+		}
+
+		// called periodically on deallocation but can be called manually
+		void purge_decayed(std::uint64_t now_ms) {
+			if (decay_time_ms <= 0 || !advance_decay(now_ms)) {
+				return;
+			}
+			purge_dirty(get_decay_limit());
+			decay_last_dirty_size = total_dirty_size;
+		}
+
+		void purge_decayed() {
+			purge_decayed(get_time_ms());
+		}
+
+		// returns free memory to the system: fully free regions are unmapped, the heap is shrinked,
+		// dirty runs are decommitted (up to keep_size of dirty memory is kept), empty descriptor pools are released
+		// & free metadata is decommitted
+		// reserved memory is kept only up to keep_size, returns how many bytes were released
+		std::size_t trim(std::size_t keep_size = 0) {
+			flush_quick_lists();
+			retained_size = std::min(retained_size, keep_size);
+
+			std::size_t sysmem_size_before = sysmem_size;
+			std::size_t decommitted = 0;
+			std::size_t keep_dirty = keep_size;
+			for (void* cursor = nullptr; fbd_index_t* node = bst::lower_bound(fbd_addr, cursor, typename fbd_t::addr_index_search_t{}); ) {
+				fbd_t* fbd = fbd_t::addr_index_to_descr(node);
+				cursor = fbd->get_end(); // both parts lie before the end of the block
+
+				auto [first, second] = walk_free_smds(fbd, fbd->get_start(), false);
+				for (fbd_t* part : {try_shrink_heap(first), try_shrink_heap(second)}) {
+					if (!part || part->get_dirty_size() == 0) {
+						continue;
+					} if (part->get_dirty_size() <= keep_dirty) {
+						keep_dirty -= part->get_dirty_size();
+						continue;
+					}
+					decommitted += decommit_free_block(part, (std::uintptr_t)part->get_start(), (std::uintptr_t)part->get_end());
+				}
+			}
+
+			std::size_t released_pools = 0;
+			auto release_pool = [&] (void* data, std::size_t size) {
+				released_pools += deallocate_meta(data, size);
+			};
+			fbd_entry.release_empty(release_pool);
+			smd_entry.release_empty(release_pool);
+			return sysmem_size_before - sysmem_size + decommitted + released_pools + release_spare() + trim_meta();
+		}
+
 	private:
 		fbd_entry_t fbd_entry{};
-		addr_index_t* fbd_addr{}; // free blocks stored by address
-		size_index_t* fbd_size{}; // free blocks stored by size
+		fbd_index_t* fbd_addr{}; // free blocks stored by address, augmented with max size
 
 		smd_entry_t smd_entry{};
-		addr_index_t* smd_addr{}; // system memory blocks stored by address
+		smd_index_t* smd_addr{}; // system memory blocks stored by address, linked so walks are O(1) per step
 
 		std::size_t page_size{};
 		std::size_t block_pool_size{};
 		std::size_t sysmem_pool_size{};
 		std::size_t min_block_size{};
+		std::size_t max_block_size{};
+		std::size_t decommit_threshold{};
+		std::size_t sysmem_size{};
+
+		std::size_t used_size{};
+		std::size_t retained_size{};
+
+		quick_list_t quick_lists[std::max<std::size_t>(quick_list_count, 1)] = {};
+		std::size_t quick_list_size{};
+
+		meta_region_t meta_region{};
+
+		std::size_t total_dirty_size{};
+		std::int64_t decay_time_ms{base_t::alloc_decay_time_ms};
+		std::uint64_t decay_last_ms{get_time_ms()};
+		std::size_t decay_last_dirty_size{};
+		std::size_t decay_backlog[decay_steps] = {}; // dirty memory accumulated during each of the last epochs, [0] - the newest
+		std::uint16_t decay_epoch{};
+		std::size_t decay_ticks{};
+
+		void* heap_start{};
+		void* heap_top{};
+		void* heap_spare_end{}; // [heap_top, heap_spare_end) was committed outside of a lock & is not used yet
+		void* heap_end{};
+		bool heap_reserve_failed{};
+		bool heap_commit_failed{};
+		bool heap_op_pending{}; // heap commit or uncommit is queued or executed outside of a lock
+
+		sysmem_op_t sysmem_ops[sysmem_queue_size] = {};
+		std::size_t sysmem_op_count{};
+		bool deferred_sysmem_ops{};
+		void* spare_region{}; // region mapped outside of a lock that is not used yet
+		std::size_t spare_region_size{};
 	};
 }
\ No newline at end of file
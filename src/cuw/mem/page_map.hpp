@@ -0,0 +1,166 @@
+#pragma once
+
+#include "core.hpp"
+
+#include <atomic>
+
+namespace cuw::mem {
+	// maps pages to small values (0 - no value) & can be read without a lock
+	// values are changed under the lock of the owner, reader looks up only pages that cannot be changed concurrently
+	// (e.g. page of a chunk that is not freed yet), values of unknown pages & pages out of the address range are 0
+	// radix tree of 4K nodes: inner nodes of 512 children & leaves of 4096 values, nodes are freed only by release()
+	// alloc_t must provide allocate(size) & deallocate(ptr, size)
+	class page_map_t {
+	public:
+		using value_t = std::uint8_t;
+
+		static constexpr std::size_t node_size = 1 << 12;
+
+	private:
+		using inner_t = std::atomic<void*>;
+		using leaf_t = std::atomic<value_t>;
+
+		static constexpr std::size_t inner_bits = 9;
+		static constexpr std::size_t leaf_bits = 12;
+		static constexpr std::uintptr_t inner_mask = ((std::uintptr_t)1 << inner_bits) - 1;
+		static constexpr std::uintptr_t leaf_mask = ((std::uintptr_t)1 << leaf_bits) - 1;
+
+		static_assert((sizeof(inner_t) << inner_bits) == node_size);
+		static_assert((sizeof(leaf_t) << leaf_bits) == node_size);
+
+	public:
+		page_map_t() = default;
+
+		page_map_t(const page_map_t&) = delete;
+		page_map_t& operator = (const page_map_t&) = delete;
+
+		// must be called before the first reserve()
+		void init(std::size_t page_size) {
+			assert(!root.load(std::memory_order_relaxed));
+			page_size_log2 = value_to_log2(page_size);
+			assert(max_alloc_bits > page_size_log2 + leaf_bits);
+			levels = (max_alloc_bits - page_size_log2 - leaf_bits + inner_bits - 1) / inner_bits;
+		}
+
+	private:
+		std::uintptr_t get_key(const void* ptr) const {
+			return (std::uintptr_t)ptr >> page_size_log2;
+		}
+
+		// level 0 is the leaf
+		std::uintptr_t get_child(std::uintptr_t key, std::size_t level) const {
+			return (key >> (leaf_bits + inner_bits * (level - 1))) & inner_mask;
+		}
+
+		bool is_in_range(const void* ptr, std::size_t size) const {
+			return ((std::uintptr_t)ptr >> max_alloc_bits) == 0 && (((std::uintptr_t)ptr + size - 1) >> max_alloc_bits) == 0;
+		}
+
+		// returns nullptr if there is no leaf for the key
+		leaf_t* find_leaf(std::uintptr_t key) const {
+			void* node = root.load(std::memory_order_acquire);
+			for (std::size_t level = levels; node && level != 0; level--) {
+				node = ((inner_t*)node)[get_child(key, level)].load(std::memory_order_acquire);
+			} return (leaf_t*)node;
+		}
+
+		// returns nullptr if a node cannot be allocated
+		template<class alloc_t>
+		leaf_t* fetch_leaf(alloc_t& alloc, std::uintptr_t key) {
+			inner_t* slot = &root;
+			for (std::size_t level = levels; ; level--) {
+				void* node = slot->load(std::memory_order_relaxed);
+				if (!node) {
+					if (!(node = alloc.allocate(node_size))) {
+						return nullptr;
+					} if (level != 0) {
+						for (std::size_t i = 0; i <= inner_mask; i++) {
+							new ((inner_t*)node + i) inner_t{nullptr};
+						}
+					} else {
+						for (std::size_t i = 0; i <= leaf_mask; i++) {
+							new ((leaf_t*)node + i) leaf_t{0};
+						}
+					}
+					slot->store(node, std::memory_order_release); // node is published initialized
+				} if (level == 0) {
+					return (leaf_t*)node;
+				}
+				slot = (inner_t*)node + get_child(key, level);
+			}
+		}
+
+		template<class alloc_t>
+		void release_node(alloc_t& alloc, void* node, std::size_t level) {
+			if (level != 0) {
+				for (std::size_t i = 0; i <= inner_mask; i++) {
+					if (void* child = ((inner_t*)node)[i].load(std::memory_order_relaxed)) {
+						release_node(alloc, child, level - 1);
+					}
+				}
+			}
+			alloc.deallocate(node, node_size);
+		}
+
+	public:
+		// nodes for pages of [ptr, ptr + size) are allocated, returns false on failure
+		template<class alloc_t>
+		[[nodiscard]] bool reserve(alloc_t& alloc, void* ptr, std::size_t size) {
+			assert(size != 0);
+			if (!is_in_range(ptr, size)) {
+				return false;
+			}
+
+			std::uintptr_t first = get_key(ptr);
+			std::uintptr_t last = get_key((char*)ptr + size - 1);
+			for (std::uintptr_t key = first & ~leaf_mask; key <= last; key += leaf_mask + 1) {
+				if (!fetch_leaf(alloc, key)) {
+					return false;
+				}
+			} return true;
+		}
+
+		// pages without nodes are skipped so a range that was never reserved can be reset
+		void assign(void* ptr, std::size_t size, value_t value) {
+			assert(size != 0);
+			if (!is_in_range(ptr, size)) {
+				return;
+			}
+
+			std::uintptr_t first = get_key(ptr);
+			std::uintptr_t last = get_key((char*)ptr + size - 1);
+			for (std::uintptr_t key = first; key <= last; key = (key | leaf_mask) + 1) {
+				if (leaf_t* leaf = find_leaf(key)) {
+					std::uintptr_t leaf_last = std::min(key | leaf_mask, last);
+					for (std::uintptr_t page = key; page <= leaf_last; page++) {
+						leaf[page & leaf_mask].store(value, std::memory_order_relaxed);
+					}
+				}
+			}
+		}
+
+		value_t get(const void* ptr) const {
+			if (!is_in_range(ptr, 1)) {
+				return 0;
+			}
+
+			std::uintptr_t key = get_key(ptr);
+			if (leaf_t* leaf = find_leaf(key)) {
+				return leaf[key & leaf_mask].load(std::memory_order_relaxed);
+			} return 0;
+		}
+
+		// there must be no readers
+		template<class alloc_t>
+		void release(alloc_t& alloc) {
+			if (void* node = root.exchange(nullptr, std::memory_order_relaxed)) {
+				release_node(alloc, node, levels);
+			}
+		}
+
+	private:
+		inner_t root{};
+		std::size_t page_size_log2{};
+		std::size_t levels{};
+	};
+}
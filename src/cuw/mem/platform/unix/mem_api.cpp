@@ -1,15 +1,83 @@
 #include "../../mem_api.hpp"
 
+#include <fcntl.h>
+#include <sched.h>
 #include <unistd.h>
 #include <sys/mman.h>
 
+#include <cstdint>
+#include <cstdlib>
+
 namespace cuw::mem {
+	namespace {
+		constexpr std::size_t fallback_huge_page_size = (std::size_t)1 << 21; // 2M, x86-64 & aarch64 with 4K pages
+
+		std::size_t read_huge_page_size() {
+			int fd = open("/sys/kernel/mm/transparent_hugepage/hpage_pmd_size", O_RDONLY);
+			if (fd == -1) {
+				return fallback_huge_page_size;
+			}
+
+			char buffer[32] = {};
+			ssize_t count = read(fd, buffer, sizeof(buffer) - 1);
+			close(fd);
+			if (count <= 0) {
+				return fallback_huge_page_size;
+			}
+
+			std::size_t size = std::strtoull(buffer, nullptr, 10);
+			if (size == 0 || (size & (size - 1)) != 0) {
+				return fallback_huge_page_size;
+			} return size;
+		}
+
+		// over-reserve and trim the head and the tail so the region starts at aligned address
+		void* map_aligned(std::size_t size, std::size_t alignment, int prot = PROT_READ | PROT_WRITE, int flags = 0) {
+			std::size_t reserve_size = size + alignment;
+			void* memory = mmap(nullptr, reserve_size, prot, MAP_PRIVATE | MAP_ANONYMOUS | flags, -1, 0);
+			if (memory == MAP_FAILED) {
+				return nullptr;
+			}
+
+			auto start = (std::uintptr_t)memory;
+			auto aligned = (start + alignment - 1) & ~(std::uintptr_t)(alignment - 1);
+			std::size_t head = aligned - start;
+			std::size_t tail = reserve_size - head - size;
+			if (head != 0) {
+				munmap(memory, head);
+			} if (tail != 0) {
+				munmap((void*)(aligned + size), tail);
+			}
+			return (void*)aligned;
+		}
+	}
+
 	value_status_t<sysmem_info_t, int> get_sysmem_info() {
 		int page_size = sysconf(_SC_PAGE_SIZE);
 		if (page_size == -1) {
 			return {{}, -1};
 		}
-		return {{ .page_size = page_size }, 0};
+		return {{ .page_size = page_size, .huge_page_size = read_huge_page_size() }, 0};
+	}
+
+	value_status_t<int, int> get_cpu_count() {
+		long count = sysconf(_SC_NPROCESSORS_CONF);
+		if (count <= 0) {
+			return {0, -1};
+		}
+		return {(int)count, 0};
+	}
+
+	value_status_t<int, int> get_current_cpu() {
+#if defined(__linux__)
+		int cpu = sched_getcpu();
+		if (cpu < 0) {
+			return {0, -1};
+		}
+		return {cpu, 0};
+#else
+		return {0, -1};
+#endif
 	}
 
 	value_status_t<void*, int> allocate_sysmem(std::size_t size) {
@@ -20,7 +88,88 @@ namespace cuw::mem {
 		return {nullptr, -1};
 	}
 
+	value_status_t<void*, int> allocate_sysmem_aligned(std::size_t size, std::size_t alignment, huge_page_mode_t mode) {
+		bool use_huge_pages = mode != huge_page_mode_t::None && (size & (alignment - 1)) == 0;
+
+#ifdef MAP_HUGETLB
+		// hugetlb mappings are aligned by the huge page size by the kernel, fails if the pool is exhausted
+		if (use_huge_pages && mode == huge_page_mode_t::HugeTLB) {
+			void* memory = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+			if (memory != MAP_FAILED) {
+				if (((std::uintptr_t)memory & (alignment - 1)) == 0) {
+					return {memory, 0};
+				} munmap(memory, size);
+			}
+		}
+#endif
+
+		void* memory = map_aligned(size, alignment);
+		if (!memory) {
+			return {nullptr, -1};
+		}
+
+#ifdef MADV_HUGEPAGE
+		if (use_huge_pages) {
+			madvise(memory, size, MADV_HUGEPAGE); // only a hint, failure is not an error
+		}
+#endif
+		return {memory, 0};
+	}
+
 	int deallocate_sysmem(void* ptr, std::size_t size) {
 		return munmap(ptr, size);
 	}
+
+	value_status_t<void*, int> reserve_sysmem(std::size_t size, std::size_t alignment) {
+		if (void* memory = map_aligned(size, alignment, PROT_NONE, MAP_NORESERVE)) {
+			return {memory, 0};
+		}
+		return {nullptr, -1};
+	}
+
+	int commit_sysmem(void* ptr, std::size_t size, huge_page_mode_t mode) {
+		if (mprotect(ptr, size, PROT_READ | PROT_WRITE)) {
+			return -1;
+		}
+
+#ifdef MADV_HUGEPAGE
+		if (mode != huge_page_mode_t::None) {
+			madvise(ptr, size, MADV_HUGEPAGE); // hugetlb cannot be applied to an existing mapping
+		}
+#endif
+		return 0;
+	}
+
+	int uncommit_sysmem(void* ptr, std::size_t size) {
+		// fresh mapping atomically replaces the old one and drops its pages
+		void* memory = mmap(ptr, size, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE | MAP_FIXED, -1, 0);
+		return memory != MAP_FAILED ? 0 : -1;
+	}
+
+	int decommit_sysmem(void* ptr, std::size_t size) {
+#ifdef MADV_FREE
+		if (madvise(ptr, size, MADV_FREE) == 0) {
+			return 0;
+		}
+#endif
+		return madvise(ptr, size, MADV_DONTNEED); // fallback: older kernels or hugetlb mappings
+	}
+
+	int prefault_sysmem(void* ptr, std::size_t size) {
+#ifdef MADV_POPULATE_WRITE
+		if (madvise(ptr, size, MADV_POPULATE_WRITE) == 0) {
+			return 0;
+		}
+#endif
+		// fallback: kernels older than 5.14, touch every page (memory is private & anonymous so contents are kept)
+		long page_size = sysconf(_SC_PAGE_SIZE);
+		if (page_size == -1) {
+			return -1;
+		}
+		for (std::size_t offset = 0; offset < size; offset += page_size) {
+			auto page = (volatile char*)ptr + offset;
+			*page = *page;
+		}
+		return 0;
+	}
 }
\ No newline at end of file
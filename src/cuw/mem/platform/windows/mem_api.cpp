@@ -3,11 +3,43 @@
 #include <windows.h>
 #include <memoryapi.h>
 
+#include <cstdint>
+
 namespace cuw::mem {
+	namespace {
+		// reserve bigger region, release it and try to occupy aligned part of it, can race with other threads so we retry
+		void* alloc_aligned(std::size_t size, std::size_t alignment, DWORD type = MEM_COMMIT | MEM_RESERVE, DWORD protect = PAGE_READWRITE) {
+			for (int attempt = 0; attempt < 16; attempt++) {
+				void* reserved = VirtualAlloc(nullptr, size + alignment, MEM_RESERVE, PAGE_NOACCESS);
+				if (!reserved) {
+					return nullptr;
+				}
+				VirtualFree(reserved, 0, MEM_RELEASE);
+
+				auto aligned = ((std::uintptr_t)reserved + alignment - 1) & ~(std::uintptr_t)(alignment - 1);
+				if (void* ptr = VirtualAlloc((void*)aligned, size, type, protect)) {
+					return ptr;
+				}
+			}
+			return nullptr;
+		}
+	}
+
 	value_status_t<sysmem_info_t, int> get_sysmem_info() {
 		SYSTEM_INFO info{};
 		GetNativeSystemInfo(&info);
-		return {{(int)info.dwPageSize}, 0};
+		return {{(int)info.dwPageSize, (std::size_t)GetLargePageMinimum()}, 0};
+	}
+
+	// processor groups are not taken into account, numbers can repeat on systems with more than 64 CPUs
+	value_status_t<int, int> get_cpu_count() {
+		SYSTEM_INFO info{};
+		GetNativeSystemInfo(&info);
+		return {(int)info.dwNumberOfProcessors, 0};
+	}
+
+	value_status_t<int, int> get_current_cpu() {
+		return {(int)GetCurrentProcessorNumber(), 0};
 	}
 
 	value_status_t<void*, int> allocate_sysmem(std::size_t size) {
@@ -17,8 +49,54 @@ namespace cuw::mem {
 		return {nullptr, -1};
 	}
 
+	// there are no transparent huge pages, large pages require SeLockMemoryPrivilege
+	value_status_t<void*, int> allocate_sysmem_aligned(std::size_t size, std::size_t alignment, huge_page_mode_t mode) {
+		if (mode == huge_page_mode_t::HugeTLB && (size & (alignment - 1)) == 0) {
+			if (std::size_t large_page = GetLargePageMinimum(); large_page != 0 && (size & (large_page - 1)) == 0) {
+				if (void* ptr = VirtualAlloc(nullptr, size, MEM_COMMIT | MEM_RESERVE | MEM_LARGE_PAGES, PAGE_READWRITE)) {
+					return {ptr, 0};
+				}
+			}
+		}
+
+		if (void* ptr = alloc_aligned(size, alignment)) {
+			return {ptr, 0};
+		}
+		return {nullptr, -1};
+	}
+
 	int deallocate_sysmem(void* ptr, std::size_t size) {
 		VirtualFree(ptr, 0, MEM_RELEASE);
 		return 0;
 	}
+
+	value_status_t<void*, int> reserve_sysmem(std::size_t size, std::size_t alignment) {
+		if (void* ptr = alloc_aligned(size, alignment, MEM_RESERVE, PAGE_NOACCESS)) {
+			return {ptr, 0};
+		}
+		return {nullptr, -1};
+	}
+
+	int commit_sysmem(void* ptr, std::size_t size, huge_page_mode_t mode) {
+		return VirtualAlloc(ptr, size, MEM_COMMIT, PAGE_READWRITE) ? 0 : -1;
+	}
+
+	int uncommit_sysmem(void* ptr, std::size_t size) {
+		return VirtualFree(ptr, size, MEM_DECOMMIT) ? 0 : -1;
+	}
+
+	int decommit_sysmem(void* ptr, std::size_t size) {
+		return VirtualAlloc(ptr, size, MEM_RESET, PAGE_READWRITE) ? 0 : -1;
+	}
+
+	// PrefetchVirtualMemory doesn't populate private memory so every page is touched
+	int prefault_sysmem(void* ptr, std::size_t size) {
+		SYSTEM_INFO info{};
+		GetNativeSystemInfo(&info);
+		for (std::size_t offset = 0; offset < size; offset += info.dwPageSize) {
+			auto page = (volatile char*)ptr + offset;
+			*page = *page;
+		}
+		return 0;
+	}
 }
\ No newline at end of file
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "core.hpp"
+#include "page_map.hpp"
 #include "alloc_tag.hpp"
 #include "block_pool.hpp"
 #include "alloc_traits.hpp"
@@ -11,7 +12,7 @@ namespace cuw::mem {
 	using alloc_descr_entry_t = block_pool_entry_t;
 
 	namespace impl {
-		// TODO : make use of allocate_ext
+		// allocate_ext(size, Any) can return more memory than requested (whole cached slot)
 		template<class basic_alloc_t, bool use_alloc_cache>
 		class pool_alloc_adapter_t;
 
@@ -81,6 +82,14 @@ namespace cuw::mem {
 				});
 			}
 
+			// returns get_count() if size is too big
+			std::size_t find_index(attrs_t size) const {
+				auto it = std::lower_bound(std::begin(pools), std::end(pools), size, [&] (auto& pool, auto& value) {
+					return pool.get_chunk_size() < value;
+				});
+				return it - std::begin(pools);
+			}
+
 			// void func(void* block, std::size_t offset, void* data, std::size_t size)
 			template<class func_t>
 			void release_all(func_t func) {
@@ -163,7 +172,7 @@ namespace cuw::mem {
 		using ad_t = alloc_descr_t;
 		using ad_state_t = alloc_descr_state_t;
 		using ad_entry_t = alloc_descr_entry_t;
-		using ad_addr_cache_t = alloc_descr_addr_cache_t;
+		using ad_addr_cache_t = std::conditional_t<base_t::use_btree_addr_index, alloc_descr_btree_addr_cache_t, alloc_descr_addr_cache_t>;
 
 		static_assert(has_sysmem_alloc_tag_v<base_t>);
 
@@ -186,6 +195,11 @@ namespace cuw::mem {
 			, raw_bins{get_max_pool_chunk_size()} {
 			min_pool_alignment = std::min<std::size_t>(base_t::get_page_size(), value_to_pow2(base_t::alloc_min_chunk_size_log2));
 			max_pool_alignment = std::min<std::size_t>(base_t::get_page_size(), value_to_pow2(base_t::alloc_max_chunk_size_log2));
+			if constexpr(base_t::use_btree_addr_index) {
+				addr_cache.set_chunk_size(base_t::alloc_block_pool_size);
+			} if constexpr(base_t::use_page_map) {
+				page_map.init(base_t::get_page_size());
+			}
 		}
 
 		~pool_alloc_t() {
@@ -201,23 +215,41 @@ namespace cuw::mem {
 	public: // for debug
 		void release_mem() {
 			auto release_func = [&] (void* block, attrs_t offset, void* data, attrs_t size) {
-				base_t::deallocate(data, size); // we can leak descrs here as all blocks will be freed anyways
+				free_data(data, size); // we can leak descrs here as all blocks will be freed anyways
 				return true;			
 			};
 
 			pools.release_all(release_func);
 			raw_bins.release_all(release_func);
 			ad_entry.release_all([&] (void* data, std::size_t size) {
-				base_t::deallocate(data, size);
+				free_meta(data, size);
 				return true;
 			});
 
-			addr_cache.reset();
+			meta_alloc_t meta_alloc{*this};
+			addr_cache.release(meta_alloc);
+			page_map.release(meta_alloc);
+		}
+
+		std::size_t get_descr_capacity() const {
+			return ad_entry.get_total_capacity();
+		}
+
+	public:
+		// returns free memory to the system, up to keep_size bytes of free memory can be kept, returns how many bytes were released
+		std::size_t trim(std::size_t keep_size = 0) {
+			std::size_t released = compact_descrs();
+			ad_entry.release_empty([&] (void* data, std::size_t size) {
+				released += free_meta(data, size);
+			});
+			if constexpr(has_trim_v<base_t>) {
+				released += base_t::trim(keep_size);
+			} return released;
 		}
 
 	private:
 		// returns non-zero on success, returns 0 on failure
-		std::size_t adjust_alignment(std::size_t value, std::size_t max_alignment) {
+		std::size_t adjust_alignment(std::size_t value, std::size_t max_alignment) const {
 			if (value == 0) {
 				value = base_t::alloc_basic_alignment;
 			}
@@ -233,11 +265,11 @@ namespace cuw::mem {
 			return 0;
 		}
 
-		std::size_t adjust_raw_alignment(std::size_t value) {
+		std::size_t adjust_raw_alignment(std::size_t value) const {
 			return adjust_alignment(value, base_t::get_page_size());
 		}
 
-		std::size_t adjust_pool_alignment(std::size_t value) {
+		std::size_t adjust_pool_alignment(std::size_t value) const {
 			return adjust_alignment(value, max_pool_alignment);
 		}
 
@@ -246,6 +278,80 @@ namespace cuw::mem {
 		}
 
 	private:
+		// descriptor pools are placed into the metadata region of the page allocator if it has one
+		[[nodiscard]] void* alloc_meta(std::size_t size) {
+			if constexpr(has_meta_alloc_v<base_t>) {
+				return base_t::allocate_meta(size);
+			} return base_t::allocate(size);
+		}
+
+		// returns how many bytes were returned to the system
+		std::size_t free_meta(void* ptr, std::size_t size) {
+			if constexpr(has_meta_alloc_v<base_t>) {
+				return base_t::deallocate_meta(ptr, size);
+			}
+			base_t::deallocate(ptr, size);
+			return size;
+		}
+
+		// huge raw blocks are mapped directly bypassing page runs, descriptor size tells how the block was obtained
+		bool is_direct(std::size_t size) const {
+			if constexpr(has_direct_alloc_v<base_t> && base_t::alloc_direct_threshold != 0) {
+				return size >= base_t::alloc_direct_threshold;
+			} return false;
+		}
+
+		[[nodiscard]] void* alloc_data(std::size_t size) {
+			if constexpr(has_direct_alloc_v<base_t>) {
+				if (is_direct(size)) {
+					return base_t::allocate_direct(size);
+				}
+			} return base_t::allocate(size);
+		}
+
+		void free_data(void* ptr, std::size_t size) {
+			if constexpr(has_direct_alloc_v<base_t>) {
+				if (is_direct(size)) {
+					base_t::deallocate_direct(ptr, size);
+					return;
+				}
+			} base_t::deallocate(ptr, size);
+		}
+
+		// block is copied if it moves between direct mapping & page runs
+		[[nodiscard]] void* realloc_data(void* old_ptr, std::size_t old_size, std::size_t new_size) {
+			if (!is_direct(old_size) && !is_direct(new_size)) {
+				return base_t::reallocate(old_ptr, old_size, new_size);
+			}
+
+			void* new_ptr = alloc_data(new_size);
+			if (!new_ptr) {
+				return nullptr;
+			}
+			std::memcpy(new_ptr, old_ptr, std::min(old_size, new_size));
+			free_data(old_ptr, old_size);
+			return new_ptr;
+		}
+
+		// index nodes (if index needs any) are allocated as metadata
+		struct meta_alloc_t {
+			void* allocate(std::size_t size) {
+				return alloc.alloc_meta(size);
+			}
+
+			void deallocate(void* ptr, std::size_t size) {
+				alloc.free_meta(ptr, size);
+			}
+
+			pool_alloc_t& alloc;
+		};
+
+		// must be called before an insertion into the index
+		[[nodiscard]] bool reserve_index() {
+			meta_alloc_t meta_alloc{*this};
+			return addr_cache.reserve(meta_alloc);
+		}
+
 		// returns (memory for block description, offset from primary block)
 		[[nodiscard]] block_info_t alloc_descr() {
 			if (auto [ptr, offset] = ad_entry.acquire(); ptr) {
@@ -253,7 +359,7 @@ namespace cuw::mem {
 			}
 
 			std::size_t pool_size = base_t::alloc_block_pool_size;
-			if (void* pool_mem = base_t::allocate(pool_size)) {
+			if (void* pool_mem = alloc_meta(pool_size)) {
 				ad_entry.create_pool(pool_mem, pool_size);
 				return ad_entry.acquire();
 			}
@@ -261,35 +367,73 @@ namespace cuw::mem {
 			return {nullptr, block_pool_head_empty};
 		}
 
-		// index & cache data is invalidated
-		[[nodiscard]] ad_t* realloc_descr(ad_t* descr) {
+		// moves descriptor into another block, list & index links and cached pointers of entry are patched
+		// old block is released without reinsertion of its pool, returns nullptr if there is no free block
+		template<class entry_t>
+		[[nodiscard]] ad_t* realloc_descr(entry_t& entry, ad_t* descr) {
 			assert(descr);
 
-			ad_state_t old_state = descr->get_state();
-			ad_entry.release(descr, descr->get_offset(), block_pool_release_mode_t::NoReinsertFree);
-
 			auto [new_block, new_offset] = ad_entry.acquire();
+			if (!new_block) {
+				return nullptr;
+			}
 
-			assert(new_block);
-
-			ad_t* new_descr = (ad_t*)new_block;
-			new_descr->set_state(old_state);
+			ad_t* new_descr = new (new_block) ad_t{*descr};
 			new_descr->set_offset(new_offset);
+			entry.relocate(descr, new_descr);
+			addr_cache.relocate(descr, new_descr);
+			ad_entry.release(descr, descr->get_offset(), block_pool_release_mode_t::NoReinsertFree);
 			return new_descr;
 		}
 
+		// descriptors of sparse descriptor pools are moved into denser ones so emptied pools can be released
+		// returns how many bytes were returned to the system
+		std::size_t compact_descrs() {
+			bp_t* isolated[max_compact_pools];
+			std::size_t isolated_count = ad_entry.isolate_sparse(isolated, max_compact_pools, descr_pool_sparse_ratio);
+			if (isolated_count == 0) {
+				return 0;
+			}
+
+			std::sort(isolated, isolated + isolated_count);
+			auto evacuate = [&] (auto& entry) {
+				entry.traverse([&] (ad_t* descr) {
+					bp_t* bp = bp_t::primary_block(descr, descr->get_offset());
+					if (std::binary_search(isolated, isolated + isolated_count, bp)) {
+						[[maybe_unused]] ad_t* relocated = realloc_descr(entry, descr);
+						assert(relocated); // isolated pools fit into the rest of the pools
+					}
+				});
+			};
+
+			for (auto& pool : pools) {
+				evacuate(pool);
+			} for (auto& bin : raw_bins) {
+				evacuate(bin);
+			}
+
+			std::size_t released = 0;
+			ad_entry.release_isolated(isolated, isolated_count, [&] (void* data, std::size_t size) {
+				released += free_meta(data, size);
+			});
+			return released;
+		}
+
 		// deallocates description, does not free associated memory
 		void free_descr(void* descr, attrs_t offset, block_pool_release_mode_t mode = block_pool_release_mode_t::ReinsertFree) {
 			if (bp_t* released = ad_entry.release(descr, offset, mode)) {
 				ad_entry.finish_release(released, [&] (void* data, std::size_t size) {
-					base_t::deallocate(data, size);
-					return true;
+					free_meta(data, size);
 				});
 			}
 		}
 
 	private:
 		ad_t* create_pool(pool_t& pool) {
+			if (!reserve_index()) {
+				return nullptr;
+			}
+
 			auto [ad, offset] = alloc_descr();
 			if (!ad) {
 				return nullptr;
@@ -300,27 +444,48 @@ namespace cuw::mem {
 			attrs_t pool_size = value_to_pow2(power);
 			attrs_t pool_capacity = std::clamp(pool_size >> chunk_size_log2, min_pool_chunks, max_pool_chunks);
 			pool_size = align_value<attrs_t>(pool_capacity << chunk_size_log2, base_t::get_page_size());
-			pool_capacity = std::clamp(pool_size >> chunk_size_log2, min_pool_chunks, max_pool_chunks);
 
-			void* pool_data = base_t::allocate(pool_size);
+			// bigger cached slot is taken as a whole so it is not split, pool cannot have more than max_pool_chunks
+			auto [pool_data, slot_size] = base_t::allocate_ext(pool_size, cached_alloc_flags_t::Any);
 			if (!pool_data) {
 				free_descr(ad, offset);
 				return nullptr;
 			}
+
+			attrs_t max_pool_size = align_value<attrs_t>(max_pool_chunks << chunk_size_log2, base_t::get_page_size());
+			pool_size = std::min<attrs_t>(slot_size, std::max(pool_size, max_pool_size));
+			if (pool_size != slot_size) {
+				base_t::deallocate(advance_ptr(pool_data, pool_size), slot_size - pool_size);
+			}
+			pool_capacity = std::clamp(pool_size >> chunk_size_log2, min_pool_chunks, max_pool_chunks);
 			
 			ad_t* pool_ad = pool.create(ad, offset, pool_size, pool_capacity, pool_data);
 			if (pool_ad) {
 				addr_cache.insert(pool_ad);
+				map_pool(pool_ad);
 			}
 
 			return pool_ad;
 		}
 
+		// pool pages are marked with index + 1, pool is still usable if nodes of the map cannot be allocated
+		void map_pool(ad_t* ad) {
+			if constexpr(base_t::use_page_map) {
+				meta_alloc_t meta_alloc{*this};
+				if (page_map.reserve(meta_alloc, ad->get_data(), ad->get_size())) {
+					page_map.assign(ad->get_data(), ad->get_size(), (page_map_t::value_t)(ad->get_chunk_size() - base_t::alloc_min_chunk_size_log2 + 1));
+				}
+			}
+		}
+
 		template<class entry_t>
 		void finish_release(entry_t& entry, ad_t* ad) {
+			if constexpr(base_t::use_page_map && std::is_same_v<entry_t, pool_t>) {
+				page_map.assign(ad->get_data(), ad->get_size(), 0);
+			}
 			addr_cache.erase(ad);
 			entry.finish_release(ad);
-			base_t::deallocate(ad->get_data(), ad->get_size());
+			free_data(ad->get_data(), ad->get_size());
 			free_descr(ad, ad->get_offset());
 		}
 
@@ -347,8 +512,8 @@ namespace cuw::mem {
 			return false;
 		}
 
-		bool free_pool(pool_t& pool, void* ptr, ad_t* ad) {
-			if (auto [ad, ptr_released] = pool.release(ptr, ad); ptr_released) {
+		bool free_pool(pool_t& pool, void* ptr, ad_t* descr) {
+			if (auto [ad, ptr_released] = pool.release(ptr, descr); ptr_released) {
 				if (ad) {
 					finish_release(pool, ad);
 				}
@@ -358,13 +523,17 @@ namespace cuw::mem {
 		}
 
 		[[nodiscard]] void* alloc_raw(raw_bin_t& bin, std::size_t size, std::size_t alignment) {
+			if (!reserve_index()) {
+				return nullptr;
+			}
+
 			auto [ad_mem, offset] = alloc_descr();
 			if (!ad_mem) {
 				return nullptr;
 			}
 
 			std::size_t size_aligned = align_value(size, alignment);
-			void* data = base_t::allocate(size_aligned);
+			void* data = alloc_data(size_aligned);
 			if (!data) {
 				free_descr(ad_mem, offset);
 				return nullptr;
@@ -426,19 +595,26 @@ namespace cuw::mem {
 			auto old_bin = raw_bins.find(old_size_aligned);
 			auto new_bin = raw_bins.find(new_size_aligned);
 
+			if (!reserve_index()) {
+				return nullptr;
+			}
+
 			ad_t* extracted = extract_raw(*old_bin, old_ptr);
 			if (!extracted || alignment != extracted->get_alignment()) {
 				return nullptr; // very bad
 			}
 
-			void* new_memory = base_t::reallocate(extracted->get_data(), old_size_aligned, new_size_aligned);
+			void* new_memory = realloc_data(extracted->get_data(), old_size_aligned, new_size_aligned);
 			if (!new_memory) {
 				put_back_raw(*old_bin, extracted);
 				return nullptr;
 			}
 
+			// block can be moved so it is reinserted into the index
+			addr_cache.erase(extracted);
 			extracted->set_data(new_memory);
 			extracted->set_size(new_size_aligned);
+			addr_cache.insert(extracted);
 			put_back_raw(*new_bin, extracted);
 			return new_memory;
 		}
@@ -708,11 +884,97 @@ namespace cuw::mem {
 			return free42(ptr, size, alignment);
 		}	
 
+	public: // bulk operations on a single pool for front-end caches, index is resolved once per batch
+		std::size_t get_pool_count() const {
+			return pools.get_count();
+		}
+
+		// returns get_pool_count() if allocation is not served by pools
+		// depends only on settings fixed at construction so it can be called without a lock
+		std::size_t get_pool_index(std::size_t size, std::size_t alignment) const {
+			if (size == 0) {
+				return pools.get_count();
+			} if (std::size_t pool_alignment = adjust_pool_alignment(alignment)) {
+				return pools.find_index(align_value(size, pool_alignment));
+			} return pools.get_count();
+		}
+
+		// returns get_pool_count() if ptr is not a pool chunk or pools are not tracked by the page map
+		// can be called without a lock for a chunk that is not freed concurrently
+		std::size_t find_pool_index(void* ptr) const {
+			if constexpr(base_t::use_page_map) {
+				if (page_map_t::value_t value = page_map.get(ptr)) {
+					return value - 1;
+				}
+			} return pools.get_count();
+		}
+
+		std::size_t get_pool_chunk_size(std::size_t index) {
+			return pools.get(index).get_chunk_size();
+		}
+
+		// returns how many chunks were allocated, can be less than count if memory is exhausted
+		std::size_t malloc_bulk(std::size_t index, void** ptrs, std::size_t count) {
+			pool_t& pool = pools.get(index);
+			for (std::size_t i = 0; i < count; i++) {
+				if (!(ptrs[i] = alloc_pool(pool))) {
+					return i;
+				}
+			} return count;
+		}
+
+		// returns false if any chunk does not belong to the pool
+		bool free_bulk(std::size_t index, void* const* ptrs, std::size_t count) {
+			pool_t& pool = pools.get(index);
+			bool freed = true;
+			for (std::size_t i = 0; i < count; i++) {
+				freed &= free_pool(pool, ptrs[i]);
+			} return freed;
+		}
+
+	public: // two-phase direct allocation so the block can be mapped outside of a lock
+		// returns how many bytes must be mapped for the allocation or zero if it is not direct
+		// depends only on settings fixed at construction so it can be called without a lock
+		std::size_t get_direct_size(std::size_t size, std::size_t alignment) const {
+			if constexpr(has_direct_alloc_v<base_t>) {
+				if (std::size_t raw_alignment = adjust_raw_alignment(alignment)) {
+					if (std::size_t size_aligned = align_value(size, raw_alignment); is_direct(size_aligned)) {
+						return align_value(size_aligned, base_t::get_page_size());
+					}
+				}
+			} return 0;
+		}
+
+		// data of get_direct_size(size, alignment) bytes mapped by the caller becomes owned by the allocator
+		// returns nullptr if it could not be registered, the caller unmaps data then
+		[[nodiscard]] void* adopt_direct(void* data, std::size_t size, std::size_t alignment) {
+			assert(data);
+			assert(get_direct_size(size, alignment) != 0);
+
+			std::size_t raw_alignment = adjust_raw_alignment(alignment);
+			std::size_t size_aligned = align_value(size, raw_alignment);
+			if (!reserve_index()) {
+				return nullptr;
+			}
+
+			auto [ad_mem, offset] = alloc_descr();
+			if (!ad_mem) {
+				return nullptr;
+			}
+
+			ad_t* ad = raw_bins.find(size_aligned)->create(ad_mem, offset, size_aligned, raw_alignment, data);
+			if (ad) {
+				addr_cache.insert(ad);
+			}
+			return data;
+		}
+
 	private:
 		ad_entry_t ad_entry{};
 		ad_addr_cache_t addr_cache{}; // common addr cache for all allocations
 		pools_t pools{};
 		raw_bins_t raw_bins{};
+		page_map_t page_map{}; // pool index of pages, read without a lock
 		std::size_t min_pool_alignment{};
 		std::size_t max_pool_alignment{};
 	};
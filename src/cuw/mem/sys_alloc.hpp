@@ -3,34 +3,171 @@
 #include "core.hpp"
 #include "mem_api.hpp"
 #include "alloc_tag.hpp"
+#include "alloc_traits.hpp"
 
 namespace cuw::mem {
+	struct sysmem_range_t {
+		void* ptr{};
+		std::size_t size{};
+	};
+
 	template<class __traits_t>
 	class sys_alloc_t : public __traits_t {
 	public:
 		using tag_t = sysmem_alloc_tag_t;
 		using traits_t = __traits_t;
 
-		sys_alloc_t() = default;
+		sys_alloc_t() {
+			if constexpr(!impl::use_resolved_page_size_v<traits_t>) {
+				if (auto [info, status] = get_sysmem_info(); status == 0 && info.huge_page_size != 0) {
+					huge_page_size = info.huge_page_size;
+				}
+			}
+		}
+
 		sys_alloc_t(sys_alloc_t&&) noexcept = delete;
 		sys_alloc_t(const sys_alloc_t&) = delete; 
 
+		~sys_alloc_t() {
+			unmap(unmap_queue, std::exchange(unmap_count, 0));
+		}
+
 		sys_alloc_t& operator = (sys_alloc_t&&) noexcept = delete;
 		sys_alloc_t& operator = (const sys_alloc_t&) = delete; 
 
 		void adopt(sys_alloc_t&) {}
 
-		[[nodiscard]] void* allocate(std::size_t size) {
+		static constexpr std::size_t sysmem_queue_size = impl::alloc_sysmem_queue_size_v<traits_t>;
+
+		// settings of new mappings, can be copied under a lock so memory is mapped without it
+		struct map_params_t {
+			huge_page_mode_t huge_page_mode{};
+			std::size_t huge_page_size{};
+			bool prefault_mode{};
+		};
+
+		// regions that are multiple of the huge page size are aligned by it so they can be backed by huge pages
+		// in prefault mode regions are populated before they are returned
+		[[nodiscard]] static void* map(std::size_t size, const map_params_t& params) {
 			assert(size != 0);
-			auto [ptr, _] = allocate_sysmem(size);
+			void* ptr = nullptr;
+			if (params.huge_page_mode != huge_page_mode_t::None && is_aligned(size, params.huge_page_size)) {
+				ptr = allocate_sysmem_aligned(size, params.huge_page_size, params.huge_page_mode).value;
+			} else {
+				ptr = allocate_sysmem(size).value;
+			} if (ptr && params.prefault_mode) {
+				prefault_sysmem(ptr, size);
+			}
 			return ptr;
 		}
 
+		static void unmap(const sysmem_range_t* ranges, std::size_t count) {
+			for (std::size_t i = 0; i < count; i++) {
+				deallocate_sysmem(ranges[i].ptr, ranges[i].size);
+			}
+		}
+
+		// ops taken from the page allocator, results are handed back to it under a lock
+		static void execute(sysmem_op_t* ops, std::size_t count, const map_params_t& params) {
+			for (std::size_t i = 0; i < count; i++) {
+				sysmem_op_t& op = ops[i];
+				switch (op.type) {
+					case sysmem_op_type_t::Decommit: {
+						op.done = decommit_sysmem(op.ptr, op.size) == 0;
+						break;
+					}
+
+					case sysmem_op_type_t::Uncommit: {
+						op.done = uncommit_sysmem(op.ptr, op.size) == 0;
+						break;
+					}
+
+					case sysmem_op_type_t::Map: {
+						if (!(op.ptr = map(op.size, params)) && op.min_size != op.size) {
+							op.size = op.min_size;
+							op.ptr = map(op.size, params);
+						} op.done = op.ptr != nullptr;
+						break;
+					}
+
+					case sysmem_op_type_t::Commit: {
+						if (!(op.done = commit_sysmem(op.ptr, op.size, params.huge_page_mode) == 0) && op.min_size != op.size) {
+							op.size = op.min_size;
+							op.done = commit_sysmem(op.ptr, op.size, params.huge_page_mode) == 0;
+						} if (op.done && params.prefault_mode) {
+							prefault_sysmem(op.ptr, op.size);
+						}
+						break;
+					}
+				}
+			}
+		}
+
+		[[nodiscard]] void* allocate(std::size_t size) {
+			return map(size, get_map_params());
+		}
+
+		// deferred unmap mode: range is queued (unmapped immediately if the queue is full) until take_unmaps() is called
 		void deallocate(void* ptr, std::size_t size) {
 			assert(size != 0);
+			if (deferred_unmap && unmap_count != sysmem_queue_size) {
+				unmap_queue[unmap_count++] = {ptr, size};
+				return;
+			}
 			deallocate_sysmem(ptr, size);
 		}
 
+		// moves queued ranges into ranges (must fit sysmem_queue_size entries), caller unmaps them, returns count of ranges
+		std::size_t take_unmaps(sysmem_range_t* ranges) {
+			std::copy(unmap_queue, unmap_queue + unmap_count, ranges);
+			return std::exchange(unmap_count, 0);
+		}
+
+		// address space only, must be committed before use, released with deallocate
+		[[nodiscard]] void* reserve(std::size_t size, std::size_t alignment) {
+			assert(size != 0);
+			auto [ptr, _] = reserve_sysmem(size, alignment);
+			return ptr;
+		}
+
+		[[nodiscard]] bool commit(void* ptr, std::size_t size) {
+			assert(size != 0);
+			if (commit_sysmem(ptr, size, huge_page_mode)) {
+				return false;
+			} if (prefault_mode) {
+				prefault(ptr, size);
+			}
+			return true;
+		}
+
+		// explicit huge page mode, hugetlb cannot be applied to the reserved range so it is treated as transparent
+		[[nodiscard]] bool commit(void* ptr, std::size_t size, huge_page_mode_t mode) {
+			assert(size != 0);
+			if (commit_sysmem(ptr, size, mode)) {
+				return false;
+			} if (prefault_mode) {
+				prefault(ptr, size);
+			}
+			return true;
+		}
+
+		void uncommit(void* ptr, std::size_t size) {
+			assert(size != 0);
+			uncommit_sysmem(ptr, size);
+		}
+
+		// memory stays mapped, physical pages are released
+		void decommit(void* ptr, std::size_t size) {
+			assert(size != 0);
+			decommit_sysmem(ptr, size);
+		}
+
+		// failure is not an error, memory is faulted on first access then
+		void prefault(void* ptr, std::size_t size) {
+			assert(size != 0);
+			prefault_sysmem(ptr, size);
+		}
+
 		[[nodiscard]] void* reallocate(void* old_ptr, std::size_t old_size, std::size_t new_size) {
 			assert(old_size != 0);
 			assert(new_size != 0);
@@ -44,5 +181,54 @@ namespace cuw::mem {
 			
 			return nullptr;
 		}
+
+	public:
+		// runtime override of the traits option, affects only new allocations
+		void set_huge_page_mode(huge_page_mode_t mode) {
+			huge_page_mode = mode;
+		}
+
+		huge_page_mode_t get_huge_page_mode() const {
+			return huge_page_mode;
+		}
+
+		// runtime override of the traits option, affects only new allocations
+		void set_prefault_mode(bool mode) {
+			prefault_mode = mode;
+		}
+
+		bool get_prefault_mode() const {
+			return prefault_mode;
+		}
+
+		// 0 if huge pages are not used
+		std::size_t get_huge_page_size() const {
+			return huge_page_mode != huge_page_mode_t::None ? huge_page_size : 0;
+		}
+
+		map_params_t get_map_params() const {
+			return {huge_page_mode, huge_page_size, prefault_mode};
+		}
+
+		// unmaps are queued so they can be executed outside of a lock
+		void set_deferred_unmap(bool mode) {
+			deferred_unmap = mode;
+			if (!mode) {
+				unmap(unmap_queue, std::exchange(unmap_count, 0));
+			}
+		}
+
+		bool get_deferred_unmap() const {
+			return deferred_unmap;
+		}
+
+	private:
+		huge_page_mode_t huge_page_mode{impl::alloc_huge_page_mode_v<traits_t>};
+		std::size_t huge_page_size{impl::alloc_huge_page_size_v<traits_t>};
+		bool prefault_mode{impl::use_prefault_v<traits_t>};
+
+		sysmem_range_t unmap_queue[sysmem_queue_size] = {};
+		std::size_t unmap_count{};
+		bool deferred_unmap{};
 	};
 }
\ No newline at end of file
@@ -0,0 +1,925 @@
+#pragma once
+
+#include "core.hpp"
+#include "mem_api.hpp"
+#include "alloc_tag.hpp"
+#include "block_pool.hpp"
+#include "page_alloc.hpp"
+#include "meta_region.hpp"
+#include "alloc_traits.hpp"
+
+namespace cuw::mem {
+	// free run of pages stored in a segregated free list
+	// prev, next: free list links
+	// offset(16): offset from prime block
+	// size(48): size of the run in bytes (page_size aligned)
+	// data: pointer to data
+	struct alignas(block_align) tlsf_block_descr_t {
+		using tbd_t = tlsf_block_descr_t;
+
+		std::size_t get_size() const {
+			return size;
+		}
+
+		void* get_start() const {
+			return data;
+		}
+
+		void* get_end() const {
+			return (char*)data + size;
+		}
+
+		void extend_right(std::size_t amount) {
+			size += amount;
+		}
+
+		void extend_left(std::size_t amount) {
+			size += amount;
+			data = (char*)data - amount;
+		}
+
+		void shrink_left(std::size_t amount) {
+			size -= amount;
+			data = (char*)data + amount;
+		}
+
+		tbd_t* prev;
+		tbd_t* next;
+		attrs_t offset:16, size:48;
+		void* data;
+	};
+
+	static_assert(do_fits_block<tlsf_block_descr_t>);
+
+	using tlsf_block_descr_entry_t = descr_entry_t<tlsf_block_descr_t>;
+
+	enum class boundary_tag_t : std::uintptr_t {
+		Start = 1, // free run starts at the address
+		End = 2, // free run ends at the address
+		Region = 3, // system region starts at the address, value is region size
+	};
+
+	// open-addressing hash table (linear probing, backward shift deletion)
+	// key is page-aligned address combined with a tag so page_size must be at least 4
+	// memory is provided from outside
+	class boundary_tags_t {
+	public:
+		struct entry_t {
+			std::uintptr_t key;
+			std::uintptr_t value;
+		};
+
+		static std::uintptr_t make_key(void* addr, boundary_tag_t tag) {
+			assert(((std::uintptr_t)addr & 0x3) == 0);
+			return (std::uintptr_t)addr | (std::uintptr_t)tag;
+		}
+
+		static std::size_t get_storage_size(std::size_t capacity) {
+			return capacity * sizeof(entry_t);
+		}
+
+	private:
+		std::size_t get_slot(std::uintptr_t key) const {
+			return (std::size_t)((key * 0x9E3779B97F4A7C15ull) >> (64 - capacity_log2));
+		}
+
+		std::size_t next_slot(std::size_t slot) const {
+			return (slot + 1) & (capacity - 1);
+		}
+
+		entry_t* find_entry(std::uintptr_t key) const {
+			if (!capacity) {
+				return nullptr;
+			}
+
+			for (std::size_t slot = get_slot(key); entries[slot].key; slot = next_slot(slot)) {
+				if (entries[slot].key == key) {
+					return &entries[slot];
+				}
+			}
+			return nullptr;
+		}
+
+		void insert_entry(std::uintptr_t key, std::uintptr_t value) {
+			std::size_t slot = get_slot(key);
+			while (entries[slot].key) {
+				assert(entries[slot].key != key);
+				slot = next_slot(slot);
+			}
+			entries[slot] = {key, value};
+		}
+
+	public:
+		// table must be grown beforehand
+		void insert(void* addr, boundary_tag_t tag, std::uintptr_t value) {
+			assert(count < capacity / 2);
+			insert_entry(make_key(addr, tag), value);
+			++count;
+		}
+
+		std::uintptr_t find(void* addr, boundary_tag_t tag) const {
+			if (entry_t* entry = find_entry(make_key(addr, tag))) {
+				return entry->value;
+			} return 0;
+		}
+
+		void erase(void* addr, boundary_tag_t tag) {
+			entry_t* entry = find_entry(make_key(addr, tag));
+			assert(entry);
+
+			std::size_t hole = entry - entries;
+			for (std::size_t slot = next_slot(hole); entries[slot].key; slot = next_slot(slot)) {
+				// entry can be moved into the hole if its home slot is not in (hole, slot]
+				std::size_t home = get_slot(entries[slot].key);
+				if (((slot - home) & (capacity - 1)) >= ((slot - hole) & (capacity - 1))) {
+					entries[hole] = entries[slot];
+					hole = slot;
+				}
+			}
+			entries[hole] = {};
+			--count;
+		}
+
+		bool requires_grow(std::size_t to_insert) const {
+			return 2 * (count + to_insert) > capacity;
+		}
+
+		// capacity must be power of two, returns old storage (can be nullptr)
+		entry_t* rehash(void* storage, std::size_t new_capacity) {
+			assert(is_alignment(new_capacity));
+			assert(2 * count <= new_capacity);
+
+			entry_t* old_entries = std::exchange(entries, (entry_t*)storage);
+			std::size_t old_capacity = std::exchange(capacity, new_capacity);
+			capacity_log2 = std::countr_zero(new_capacity);
+			std::memset(entries, 0, get_storage_size(capacity));
+			for (std::size_t i = 0; i < old_capacity; i++) {
+				if (old_entries[i].key) {
+					insert_entry(old_entries[i].key, old_entries[i].value);
+				}
+			}
+			return old_entries;
+		}
+
+		// void func(void* addr, std::uintptr_t value)
+		template<class func_t>
+		void traverse(boundary_tag_t tag, func_t func) const {
+			for (std::size_t i = 0; i < capacity; i++) {
+				if (entries[i].key && (entries[i].key & 0x3) == (std::uintptr_t)tag) {
+					func((void*)(entries[i].key & ~(std::uintptr_t)0x3), entries[i].value);
+				}
+			}
+		}
+
+		void reset() {
+			entries = nullptr;
+			capacity = 0;
+			capacity_log2 = 0;
+			count = 0;
+		}
+
+		entry_t* get_storage() const {
+			return entries;
+		}
+
+		std::size_t get_capacity() const {
+			return capacity;
+		}
+
+		std::size_t get_count() const {
+			return count;
+		}
+
+	private:
+		entry_t* entries{};
+		std::size_t capacity{};
+		std::size_t capacity_log2{};
+		std::size_t count{};
+	};
+
+	// two-level segregated fit over page runs
+	// first level splits sizes (in pages) by powers of two, second level splits each power of two linearly
+	// sizes less than sl_count pages have their own exact classes
+	// neighbouring free runs are found through boundary tags, runs from different system regions are never coalesced
+	// O(1) on allocation & deallocation (amortized because of the tag table growth)
+	template<class basic_alloc_t>
+	class tlsf_page_alloc_t : public basic_alloc_t {
+	public:
+		using this_t = tlsf_page_alloc_t;
+		using base_t = basic_alloc_t;
+		using bp_t = block_pool_t;
+		using tbd_t = tlsf_block_descr_t;
+		using tbd_entry_t = tlsf_block_descr_entry_t;
+		using tags_t = boundary_tags_t;
+
+		static_assert(has_sysmem_alloc_tag_v<base_t>);
+
+		static constexpr attrs_t sl_log2 = tlsf_sl_log2;
+		static constexpr attrs_t sl_count = (attrs_t)1 << sl_log2;
+		static constexpr attrs_t fl_count = max_alloc_bits - sl_log2 + 1;
+
+		static_assert(sl_count <= 32);
+		static_assert(fl_count <= 64);
+
+		template<class ... args_t>
+		tlsf_page_alloc_t(args_t&& ... args) : base_t(std::forward<args_t>(args)...) {
+			if constexpr(base_t::use_resolved_page_size) {
+				page_size = base_t::alloc_page_size;
+			} else {
+				if (auto [info, status] = get_sysmem_info(); status == 0) {
+					page_size = info.page_size;
+				} else {
+					page_size = base_t::alloc_page_size;
+				}
+			}
+			assert(page_size >= 4);
+			page_size_log2 = value_to_log2(page_size);
+			block_pool_size = align_value(base_t::alloc_block_pool_size, page_size);
+			sysmem_pool_size = align_value(base_t::alloc_sysmem_pool_size, page_size);
+			min_block_size = align_value(base_t::alloc_min_block_size, page_size);
+			max_block_size = align_value(base_t::alloc_max_block_size, page_size);
+			init_meta_region();
+		}
+
+		tlsf_page_alloc_t(const tlsf_page_alloc_t&) = delete;
+		tlsf_page_alloc_t(tlsf_page_alloc_t&&) = delete;
+
+		~tlsf_page_alloc_t() {
+			release_mem();
+		}
+
+		tlsf_page_alloc_t& operator = (const tlsf_page_alloc_t&) = delete;
+		tlsf_page_alloc_t& operator = (tlsf_page_alloc_t&&) = delete;
+
+		// mostly for debugging purposes
+		void release_mem() {
+			tags.traverse(boundary_tag_t::Region, [&] (void* region, std::uintptr_t size) {
+				base_t::deallocate(region, size);
+			});
+
+			if (tags.get_storage()) {
+				base_t::deallocate(tags.get_storage(), tags_t::get_storage_size(tags.get_capacity()));
+			}
+			tags.reset();
+
+			tbd_entry.release_all([&] (void* block, std::size_t size) {
+				deallocate_meta(block, size);
+				return true;
+			});
+			meta_region.release((base_t&)*this);
+
+			if (spare_region) {
+				base_t::deallocate(spare_region, spare_region_size);
+			}
+			spare_region = nullptr;
+			spare_region_size = 0;
+			sysmem_op_count = 0; // queued ops refer to released memory
+
+			for (auto& fl_heads : heads) {
+				std::fill(std::begin(fl_heads), std::end(fl_heads), nullptr);
+			}
+			std::fill(std::begin(sl_map), std::end(sl_map), 0);
+			fl_map = 0;
+			sysmem_size = 0;
+			used_size = 0;
+			retained_size = 0;
+		}
+
+	private:
+		struct mapping_t {
+			attrs_t fl{};
+			attrs_t sl{};
+		};
+
+		static mapping_t mapping_insert(attrs_t pages) {
+			assert(pages != 0);
+			if (pages < sl_count) {
+				return {0, pages};
+			}
+
+			attrs_t log2 = std::bit_width(pages) - 1;
+			return {log2 - sl_log2 + 1, (pages >> (log2 - sl_log2)) ^ sl_count};
+		}
+
+		// rounds size up so any block from found class is big enough
+		static mapping_t mapping_search(attrs_t pages) {
+			assert(pages != 0);
+			if (pages >= sl_count) {
+				attrs_t log2 = std::bit_width(pages) - 1;
+				pages += ((attrs_t)1 << (log2 - sl_log2)) - 1;
+			}
+			return mapping_insert(pages);
+		}
+
+		tbd_t* find_suitable(mapping_t mapping) const {
+			auto [fl, sl] = mapping;
+			if (fl >= fl_count) {
+				return nullptr;
+			}
+
+			attrs_t sl_bits = sl_map[fl] & (~(attrs_t)0 << sl);
+			if (!sl_bits) {
+				attrs_t fl_bits = fl + 1 < fl_count ? fl_map & (~(attrs_t)0 << (fl + 1)) : 0;
+				if (!fl_bits) {
+					return nullptr;
+				}
+				fl = std::countr_zero(fl_bits);
+				sl_bits = sl_map[fl];
+			}
+			sl = std::countr_zero(sl_bits);
+			return heads[fl][sl];
+		}
+
+		attrs_t get_pages(std::size_t size) const {
+			return size >> page_size_log2;
+		}
+
+	private:
+		[[nodiscard]] bool reserve_tags(std::size_t to_insert) {
+			if (!tags.requires_grow(to_insert)) {
+				return true;
+			}
+
+			std::size_t new_capacity = std::max<std::size_t>(2 * tags.get_capacity(), block_pool_size / sizeof(tags_t::entry_t));
+			new_capacity = std::bit_ceil(std::max<std::size_t>(new_capacity, 2 * (tags.get_count() + to_insert)));
+
+			std::size_t storage_size = align_value(tags_t::get_storage_size(new_capacity), page_size);
+			void* storage = base_t::allocate(storage_size);
+			if (!storage) {
+				return false;
+			}
+
+			std::size_t old_capacity = tags.get_capacity();
+			if (tags_t::entry_t* old_storage = tags.rehash(storage, new_capacity)) {
+				base_t::deallocate(old_storage, align_value(tags_t::get_storage_size(old_capacity), page_size));
+			}
+			return true;
+		}
+
+		// same as in page_alloc_t
+		void init_meta_region() {
+			if constexpr(base_t::use_meta_region && has_reserve_v<base_t>) {
+				std::size_t commit_size = align_value(base_t::alloc_meta_commit_size, page_size);
+				std::size_t alignment = base_t::alloc_meta_huge_page_mode != huge_page_mode_t::None ? commit_size : page_size;
+				std::size_t chunk_size = std::max(block_pool_size, sysmem_pool_size);
+				meta_region.init(chunk_size, base_t::alloc_meta_reserve_size, std::max(commit_size, chunk_size), alignment, page_size, base_t::alloc_meta_huge_page_mode);
+			}
+		}
+
+	public:
+		[[nodiscard]] void* allocate_meta(std::size_t size) {
+			if constexpr(base_t::use_meta_region && has_reserve_v<base_t>) {
+				if (void* pool = meta_region.allocate((base_t&)*this, size)) {
+					return pool;
+				}
+			} return base_t::allocate(size);
+		}
+
+		std::size_t deallocate_meta(void* ptr, std::size_t size) {
+			if (meta_region.deallocate(ptr)) {
+				return 0;
+			}
+			base_t::deallocate(ptr, size);
+			return size;
+		}
+
+		// huge allocations get their own mapping from the system allocator, page runs & indices are never touched
+		[[nodiscard]] void* allocate_direct(std::size_t size) {
+			return base_t::allocate(align_value(size, page_size));
+		}
+
+		void deallocate_direct(void* ptr, std::size_t size) {
+			base_t::deallocate(ptr, align_value(size, page_size));
+		}
+
+		bool is_meta_ptr(void* ptr) const {
+			return meta_region.contains(ptr);
+		}
+
+		// free chunks of the metadata region are uncommitted or decommitted, returns how many bytes were released
+		std::size_t trim_meta() {
+			if constexpr(base_t::use_meta_region && has_reserve_v<base_t>) {
+				return meta_region.trim((base_t&)*this);
+			} return 0;
+		}
+
+	private:
+		[[nodiscard]] tbd_t* alloc_tbd(void* data, std::size_t size) {
+			if (tbd_t* tbd = tbd_entry.acquire(data, size)) {
+				return tbd;
+			}
+
+			std::size_t pool_size = block_pool_size;
+			void* pool_data = allocate_meta(pool_size);
+			if (pool_data) {
+				tbd_entry.create_pool(pool_data, pool_size);
+				return tbd_entry.acquire(data, size);
+			}
+
+			return nullptr;
+		}
+
+		void free_tbd(tbd_t* tbd) {
+			if (bp_t* bp = tbd_entry.release(tbd, block_pool_release_mode_t::ReinsertFree)) {
+				tbd_entry.finish_release(bp, [&] (void* ptr, std::size_t size) {
+					deallocate_meta(ptr, size);
+				});
+			}
+		}
+
+		// tags must be reserved beforehand
+		void insert_free_run(tbd_t* tbd) {
+			auto [fl, sl] = mapping_insert(get_pages(tbd->size));
+			tbd->prev = nullptr;
+			tbd->next = heads[fl][sl];
+			if (tbd->next) {
+				tbd->next->prev = tbd;
+			}
+			heads[fl][sl] = tbd;
+			fl_map |= (attrs_t)1 << fl;
+			sl_map[fl] |= (attrs_t)1 << sl;
+
+			tags.insert(tbd->get_start(), boundary_tag_t::Start, (std::uintptr_t)tbd);
+			tags.insert(tbd->get_end(), boundary_tag_t::End, (std::uintptr_t)tbd);
+		}
+
+		void remove_free_run(tbd_t* tbd) {
+			auto [fl, sl] = mapping_insert(get_pages(tbd->size));
+			if (tbd->prev) {
+				tbd->prev->next = tbd->next;
+			} else {
+				heads[fl][sl] = tbd->next;
+				if (!tbd->next) {
+					sl_map[fl] &= ~((attrs_t)1 << sl);
+					if (!sl_map[fl]) {
+						fl_map &= ~((attrs_t)1 << fl);
+					}
+				}
+			}
+			if (tbd->next) {
+				tbd->next->prev = tbd->prev;
+			}
+
+			tags.erase(tbd->get_start(), boundary_tag_t::Start);
+			tags.erase(tbd->get_end(), boundary_tag_t::End);
+		}
+
+		bool is_region_start(void* ptr) const {
+			return tags.find(ptr, boundary_tag_t::Region) != 0;
+		}
+
+	private:
+		[[nodiscard]] void* alloc_region(std::size_t size) {
+			if (!reserve_tags(1)) {
+				return nullptr;
+			}
+
+			void* region = base_t::allocate(size);
+			if (region) {
+				tags.insert(region, boundary_tag_t::Region, size);
+				sysmem_size += size;
+			}
+			return region;
+		}
+
+		// region was mapped outside of a lock (deferred mode)
+		[[nodiscard]] bool adopt_region(void* region, std::size_t size) {
+			if (!reserve_tags(1)) {
+				return false;
+			}
+			tags.insert(region, boundary_tag_t::Region, size);
+			sysmem_size += size;
+			return true;
+		}
+
+		// retention policy: same as in page_alloc_t, fully free region is unmapped only if one growth step of free memory remains
+		bool can_release_region(std::size_t region_size, bool retain) const {
+			if (sysmem_size - region_size < retained_size) {
+				return false;
+			} if constexpr(base_t::use_region_retention) {
+				if (retain) {
+					std::size_t free_size = sysmem_size - used_size - region_size;
+					return free_size >= std::clamp(sysmem_size - region_size, min_block_size, max_block_size);
+				}
+			} return true;
+		}
+
+		void free_region(void* region, std::size_t size) {
+			sysmem_size -= size;
+			tags.erase(region, boundary_tag_t::Region);
+			base_t::deallocate(region, size);
+		}
+
+		// O(1), ptr & size are already aligned
+		// returns false if metadata cannot be allocated, nothing is modified then
+		[[nodiscard]] bool insert_free_block(void* ptr, std::size_t size) {
+			if (!reserve_tags(2)) {
+				return false;
+			}
+
+			void* end = advance_ptr(ptr, size);
+			tbd_t* left = !is_region_start(ptr) ? (tbd_t*)tags.find(ptr, boundary_tag_t::End) : nullptr;
+			tbd_t* right = !is_region_start(end) ? (tbd_t*)tags.find(end, boundary_tag_t::Start) : nullptr;
+
+			tbd_t* block = nullptr;
+			if (left) {
+				remove_free_run(left);
+				left->extend_right(size);
+				block = left;
+			}
+
+			if (right) {
+				remove_free_run(right);
+				if (block) {
+					block->extend_right(right->size);
+					free_tbd(right);
+				} else {
+					right->extend_left(size);
+					block = right;
+				}
+			}
+
+			if (!block) {
+				block = alloc_tbd(ptr, size); // no neighbours were consumed so far
+				if (!block) {
+					return false;
+				}
+			}
+
+			if constexpr(!base_t::use_dirty_optimization_hacks) {
+				std::size_t region_size = tags.find(block->get_start(), boundary_tag_t::Region);
+				if (region_size == block->size && can_release_region(region_size, true)) {
+					free_region(block->get_start(), region_size);
+					free_tbd(block);
+					return true;
+				}
+			}
+
+			insert_free_run(block);
+			return true;
+		}
+
+		// fallback for frees when metadata is exhausted: whole region is unmapped, otherwise run is decommitted & lost
+		// lost run is never reused so its decommit needs no completion in deferred mode
+		void drop_free_block(void* ptr, std::size_t size) {
+			if (is_region_start(ptr) && tags.find(ptr, boundary_tag_t::Region) == size) {
+				free_region(ptr, size);
+				return;
+			} if constexpr(has_decommit_v<base_t>) {
+				if (!queue_sysmem_op({.type = sysmem_op_type_t::Decommit, .ptr = ptr, .size = size})) {
+					base_t::decommit(ptr, size);
+				}
+			}
+		}
+
+		void release_free_block(void* ptr, std::size_t size) {
+			if (!insert_free_block(ptr, size)) {
+				drop_free_block(ptr, size);
+			}
+		}
+
+		[[nodiscard]] void* bite_free_run(tbd_t* tbd, std::size_t size) {
+			assert(tbd->size >= size);
+
+			remove_free_run(tbd);
+
+			void* ptr = tbd->get_start();
+			if (tbd->size != size) {
+				tbd->shrink_left(size);
+				insert_free_run(tbd); // two tags were erased so there is enough space
+			} else {
+				free_tbd(tbd);
+			}
+			return ptr;
+		}
+
+		[[nodiscard]] void* try_alloc_from_existing(std::size_t size) {
+			if (tbd_t* found = find_suitable(mapping_search(get_pages(size)))) {
+				return bite_free_run(found, size);
+			}
+			return nullptr;
+		}
+
+		[[nodiscard]] void* try_alloc_by_extend(std::size_t size) {
+			// growth policy: same as in page_alloc_t, new region is as big as everything that is already allocated
+			std::size_t grow_size = std::clamp(sysmem_size, min_block_size, max_block_size);
+			std::size_t size_ext = align_value(std::max(size, grow_size), get_region_granularity());
+
+			if (can_queue_sysmem_op()) {
+				return try_alloc_from_spare(size, size_ext);
+			} if (size_ext != size) {
+				if (void* region = alloc_region(size_ext)) {
+					if (insert_free_block(advance_ptr(region, size), size_ext - size)) {
+						return region;
+					}
+					free_region(region, size_ext); // tail cannot be tracked
+				}
+			}
+			return alloc_region(size); // fallback
+		}
+
+		// deferred mode: same as in page_alloc_t, spare region is used or Map is queued & allocation fails until it is finished
+		[[nodiscard]] void* try_alloc_from_spare(std::size_t size, std::size_t size_ext) {
+			if (spare_region_size < size) {
+				queue_map_op(size_ext, size);
+				return nullptr;
+			} if (!adopt_region(spare_region, spare_region_size)) {
+				return nullptr;
+			}
+
+			void* region = std::exchange(spare_region, nullptr);
+			std::size_t region_size = std::exchange(spare_region_size, 0);
+			if (region_size != size && !insert_free_block(advance_ptr(region, size), region_size - size)) {
+				free_region(region, region_size); // tail cannot be tracked
+				return nullptr;
+			} return region;
+		}
+
+		[[nodiscard]] void* try_alloc_memory(std::size_t size) {
+			assert(is_aligned(size, page_size));
+			if (void* ptr = try_alloc_from_existing(size)) {
+				return ptr;
+			}
+			return try_alloc_by_extend(size);
+		}
+
+	private:
+		static constexpr std::size_t sysmem_queue_size = base_t::alloc_sysmem_queue_size;
+
+		bool can_queue_sysmem_op() const {
+			return deferred_sysmem_ops && sysmem_op_count != sysmem_queue_size;
+		}
+
+		// returns false if the call must be made right away (deferred mode is off or the queue is full)
+		bool queue_sysmem_op(const sysmem_op_t& op) {
+			if (!can_queue_sysmem_op()) {
+				return false;
+			}
+			sysmem_ops[sysmem_op_count++] = op;
+			return true;
+		}
+
+		// one Map is queued per lock session, the biggest request wins
+		void queue_map_op(std::size_t size, std::size_t min_size) {
+			for (std::size_t i = 0; i < sysmem_op_count; i++) {
+				if (sysmem_op_t& op = sysmem_ops[i]; op.type == sysmem_op_type_t::Map) {
+					op.size = std::max(op.size, size);
+					op.min_size = std::max(op.min_size, min_size);
+					return;
+				}
+			}
+			queue_sysmem_op({.type = sysmem_op_type_t::Map, .size = size, .min_size = min_size});
+		}
+
+		// ops that were not taken when deferred mode is turned off
+		void execute_sysmem_op(sysmem_op_t& op) {
+			if (op.type == sysmem_op_type_t::Map) {
+				if (!(op.ptr = base_t::allocate(op.size)) && op.min_size != op.size) {
+					op.size = op.min_size;
+					op.ptr = base_t::allocate(op.size);
+				} op.done = op.ptr != nullptr;
+			} else if constexpr(has_decommit_v<base_t>) {
+				base_t::decommit(op.ptr, op.size);
+				op.done = true;
+			}
+		}
+
+		// returns how many bytes were released
+		std::size_t release_spare() {
+			std::size_t released = std::exchange(spare_region_size, 0);
+			if (void* region = std::exchange(spare_region, nullptr)) {
+				base_t::deallocate(region, released);
+			} return released;
+		}
+
+	public:
+		// deferred mode: same as in page_alloc_t, only Map (region growth) & Decommit (dropped runs) are queued here
+		void set_deferred_sysmem_ops(bool mode) {
+			deferred_sysmem_ops = mode;
+			if (!mode) {
+				sysmem_op_t ops[sysmem_queue_size];
+				std::size_t count = take_sysmem_ops(ops);
+				for (std::size_t i = 0; i < count; i++) {
+					execute_sysmem_op(ops[i]);
+				}
+				(void)finish_sysmem_ops(ops, count);
+			}
+		}
+
+		bool get_deferred_sysmem_ops() const {
+			return deferred_sysmem_ops;
+		}
+
+		// ops must fit sysmem_queue_size entries, returns count of ops
+		std::size_t take_sysmem_ops(sysmem_op_t* ops) {
+			std::copy(sysmem_ops, sysmem_ops + sysmem_op_count, ops);
+			return std::exchange(sysmem_op_count, 0);
+		}
+
+		// returns true if memory was obtained so failed allocation can be retried, the bigger region is kept as the spare
+		[[nodiscard]] bool finish_sysmem_ops(const sysmem_op_t* ops, std::size_t count) {
+			bool retry = false;
+			for (std::size_t i = 0; i < count; i++) {
+				const sysmem_op_t& op = ops[i];
+				if (op.type != sysmem_op_type_t::Map || !op.done) {
+					continue;
+				} if (spare_region_size < op.size) {
+					(void)release_spare();
+					spare_region = op.ptr;
+					spare_region_size = op.size;
+				} else {
+					base_t::deallocate(op.ptr, op.size);
+				}
+				retry = true;
+			}
+			return retry;
+		}
+
+	public:
+		[[nodiscard]] void* allocate(std::size_t size) {
+			size = align_value(size, page_size);
+			void* ptr = try_alloc_memory(size);
+			if (ptr) {
+				used_size += size;
+			}
+			return ptr;
+		}
+
+		void deallocate(void* ptr, std::size_t size) {
+			size = align_value(size, page_size);
+			used_size -= size;
+			release_free_block(ptr, size);
+		}
+
+		// pre-maps & prefaults at least size bytes of free memory so the first allocations don't page fault
+		// reserved memory is never unmapped
+		[[nodiscard]] bool reserve(std::size_t size) {
+			size = align_value(size, page_size);
+			void* ptr = try_alloc_memory(size);
+			if (!ptr) {
+				return false;
+			} if constexpr(has_prefault_v<base_t>) {
+				base_t::prefault(ptr, size);
+			}
+			retained_size += size;
+			if (!insert_free_block(ptr, size)) {
+				retained_size -= size;
+				drop_free_block(ptr, size);
+				return false;
+			}
+			return true;
+		}
+
+		// returns free memory to the system: fully free regions are unmapped, empty descriptor pools are released
+		// & free metadata is decommitted, free runs are not decommitted, reserved memory is kept only up to keep_size, returns how many bytes were released
+		std::size_t trim(std::size_t keep_size = 0) {
+			retained_size = std::min(retained_size, keep_size);
+
+			std::size_t sysmem_size_before = sysmem_size;
+			for (auto& lists : heads) {
+				for (tbd_t* head : lists) {
+					for (tbd_t* tbd = head, *next = nullptr; tbd; tbd = next) {
+						next = tbd->next;
+						std::size_t region_size = tags.find(tbd->get_start(), boundary_tag_t::Region);
+						if (region_size == tbd->size && can_release_region(region_size, false)) {
+							remove_free_run(tbd);
+							free_region(tbd->get_start(), region_size);
+							free_tbd(tbd);
+						}
+					}
+				}
+			}
+
+			std::size_t released_pools = 0;
+			tbd_entry.release_empty([&] (void* data, std::size_t size) {
+				released_pools += deallocate_meta(data, size);
+			});
+			return sysmem_size_before - sysmem_size + released_pools + release_spare() + trim_meta();
+		}
+
+		[[nodiscard]] void* reallocate(void* old_ptr, std::size_t old_size, std::size_t new_size) {
+			std::size_t old_size_aligned = align_value(old_size, page_size);
+			std::size_t new_size_aligned = align_value(new_size, page_size);
+
+			if (new_size_aligned == old_size_aligned) {
+				return old_ptr;
+			}
+
+			if (new_size_aligned < old_size_aligned) {
+				used_size -= old_size_aligned - new_size_aligned;
+				release_free_block(advance_ptr(old_ptr, new_size_aligned), old_size_aligned - new_size_aligned);
+				return old_ptr;
+			}
+
+			// check if there is a free run adjacent to the right of the allocation within the same region
+			void* old_ptr_end = advance_ptr(old_ptr, old_size_aligned);
+			if (!is_region_start(old_ptr_end)) {
+				std::size_t delta = new_size_aligned - old_size_aligned;
+				if (tbd_t* right = (tbd_t*)tags.find(old_ptr_end, boundary_tag_t::Start); right && right->size >= delta) {
+					(void)bite_free_run(right, delta);
+					used_size += delta;
+					return old_ptr;
+				}
+			}
+
+			if (void* new_ptr = this_t::allocate(new_size)) {
+				std::memcpy(new_ptr, old_ptr, std::min(old_size, new_size));
+				this_t::deallocate(old_ptr, old_size);
+				return new_ptr;
+			}
+
+			return nullptr;
+		}
+
+	public:
+		// void func(void* ptr, std::size_t size), mostly for debugging purpose
+		template<class func_t>
+		void traverse_free_runs(func_t func) const {
+			tags.traverse(boundary_tag_t::Start, [&] (void* ptr, std::uintptr_t value) {
+				func(ptr, ((tbd_t*)value)->get_size());
+			});
+		}
+
+		std::size_t get_true_size(std::size_t size) {
+			return align_value(size, page_size);
+		}
+
+		std::size_t get_page_size() const {
+			return page_size;
+		}
+
+		// regions are multiple of the huge page size (when huge pages are used) so huge pages are never split
+		std::size_t get_region_granularity() const {
+			if constexpr(has_huge_pages_v<base_t>) {
+				return std::max(page_size, base_t::get_huge_page_size());
+			} return page_size;
+		}
+
+		std::size_t get_block_pool_size() const {
+			return block_pool_size;
+		}
+
+		std::size_t get_min_block_size() const {
+			return min_block_size;
+		}
+
+		std::size_t get_max_block_size() const {
+			return max_block_size;
+		}
+
+		std::size_t get_sysmem_size() const {
+			return sysmem_size;
+		}
+
+		std::size_t get_sysmem_pool_size() const {
+			return sysmem_pool_size;
+		}
+
+		// memory that is kept mapped because of reserve()
+		std::size_t get_retained_size() const {
+			return retained_size;
+		}
+
+	private:
+		tbd_entry_t tbd_entry{};
+		tags_t tags{};
+
+		attrs_t fl_map{};
+		attrs_t sl_map[fl_count] = {};
+		tbd_t* heads[fl_count][sl_count] = {};
+
+		std::size_t page_size{};
+		std::size_t page_size_log2{};
+		std::size_t block_pool_size{};
+		std::size_t sysmem_pool_size{};
+		std::size_t min_block_size{};
+		std::size_t max_block_size{};
+		std::size_t sysmem_size{};
+		std::size_t used_size{};
+		std::size_t retained_size{};
+
+		meta_region_t meta_region{};
+
+		sysmem_op_t sysmem_ops[sysmem_queue_size] = {};
+		std::size_t sysmem_op_count{};
+		bool deferred_sysmem_ops{};
+		void* spare_region{}; // region mapped outside of a lock that is not used yet
+		std::size_t spare_region_size{};
+	};
+
+	namespace impl {
+		template<class basic_alloc_t, bool use_tlsf_page_alloc>
+		struct page_alloc_backend_t {
+			using type = page_alloc_t<basic_alloc_t>;
+		};
+
+		template<class basic_alloc_t>
+		struct page_alloc_backend_t<basic_alloc_t, true> {
+			using type = tlsf_page_alloc_t<basic_alloc_t>;
+		};
+	}
+
+	// page allocator selected by use_tlsf_page_alloc option
+	template<class basic_alloc_t>
+	using page_alloc_backend_t = typename impl::page_alloc_backend_t<basic_alloc_t, basic_alloc_t::use_tlsf_page_alloc>::type;
+}
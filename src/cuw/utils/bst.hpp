@@ -1,10 +1,72 @@
 #pragma once
 
 #include <cassert>
+#include <cstddef>
+#include <type_traits>
 
 namespace cuw::bst {
 	// parent pointer is treated specially on assignment as a little workaround for trb & tagged_ptr implementation
 	// so only pointer part is assigned and not data part
+	// links are always cast to node_t* before being stored or passed further
+
+	// augmentation protocol: aug_ops.update(node) recomputes augmented data of the node from its own data and its children
+	// augmented data is kept outside of the node (for example, in the object containing the node)
+	struct no_augment_t {
+		template<class node_t>
+		void update(node_t*) const {}
+	};
+
+	template<class aug_ops_t>
+	inline constexpr bool is_augmented_v = !std::is_same_v<std::remove_cvref_t<aug_ops_t>, no_augment_t>;
+
+	// linked (threaded) nodes keep prev/next pointers to their in-order neighbours
+	template<class node_t>
+	inline constexpr bool is_linked_v = requires (node_t* node) { node->prev; node->next; };
+
+	// node must be just attached as a leaf (its parent is set), it is linked between its neighbours
+	template<class node_t>
+	void link_leaf(node_t* node) {
+		if constexpr(is_linked_v<node_t>) {
+			node_t* parent = node->parent;
+			if (!parent) {
+				node->prev = nullptr;
+				node->next = nullptr;
+			} else if (node == parent->left) {
+				node->prev = parent->prev;
+				node->next = parent;
+			} else {
+				node->prev = parent;
+				node->next = parent->next;
+			}
+
+			if (node->prev) {
+				node->prev->next = node;
+			} if (node->next) {
+				node->next->prev = node;
+			}
+		}
+	}
+
+	// node is going to be removed from the tree
+	template<class node_t>
+	void unlink(node_t* node) {
+		if constexpr(is_linked_v<node_t>) {
+			if (node->prev) {
+				node->prev->next = node->next;
+			} if (node->next) {
+				node->next->prev = node->prev;
+			}
+		}
+	}
+
+	// recomputes augmented data on the path from node to the root, required when data of the node is changed in-place
+	template<class node_t, class aug_ops_t>
+	void propagate(node_t* node, aug_ops_t&& aops) {
+		while (node) {
+			aops.update(node);
+			node = (node_t*)node->parent;
+		}
+	}
 
 	template<class node_t>
 	node_t* tree_min(node_t* root) {
@@ -28,8 +90,12 @@ namespace cuw::bst {
 	node_t* predecessor(node_t* node) {
 		assert(node);
 
+		if constexpr(is_linked_v<node_t>) {
+			return node->prev;
+		}
+
 		if (node->left) {
-			return tree_max(node->left);
+			return tree_max((node_t*)node->left);
 		}
 
 		node_t* pred = node->parent;
@@ -44,8 +110,12 @@ namespace cuw::bst {
 	node_t* successor(node_t* node) {
 		assert(node);
 
+		if constexpr(is_linked_v<node_t>) {
+			return node->next;
+		}
+
 		if (node->right) {
-			return tree_min(node->right);
+			return tree_min((node_t*)node->right);
 		}
 
 		node_t* succ = node->parent;
@@ -71,6 +141,34 @@ namespace cuw::bst {
 		return lb;
 	}
 
+	// lower_bound that starts from finger (any node of the tree) instead of the root
+	// climbs only until the subtree that must contain the result is found, so search near the finger is cheap
+	template<class node_t, class key_t, class key_ops_t>
+	node_t* finger_lower_bound(node_t* root, node_t* finger, key_t&& key, key_ops_t&& kops) {
+		if (!finger) {
+			return lower_bound(root, key, kops);
+		}
+
+		node_t* curr = finger;
+		if (kops.compare(kops.get_key(finger), key)) {
+			// result is to the right of the finger: stop at the first right ancestor that is not less than key
+			while (node_t* parent = curr->parent) {
+				if (curr == parent->left && !kops.compare(kops.get_key(parent), key)) {
+					node_t* lb = lower_bound(curr, key, kops);
+					return lb ? lb : parent;
+				} curr = parent;
+			}
+		} else {
+			// result is the finger or to the left of it: stop at the first left ancestor that is less than key
+			while (node_t* parent = curr->parent) {
+				if (curr == parent->right && kops.compare(kops.get_key(parent), key)) {
+					return lower_bound(curr, key, kops);
+				} curr = parent;
+			}
+		}
+		return lower_bound(curr, key, kops);
+	}
+
 	// searches in reversed order
 	template<class node_t, class key_t, class key_ops_t>
 	node_t* rlower_bound(node_t* root, key_t&& key, key_ops_t&& kops) {
@@ -103,8 +201,31 @@ namespace cuw::bst {
 		return ub;
 	}
 
-	template<class node_t>
-	[[nodiscard]] node_t* rotate_left(node_t* root, node_t* node) {
+	// searches the leftmost node satisfying node_pred
+	// subtree_pred(node) must tell if the subtree of the node contains such node (usually it checks augmented data)
+	template<class node_t, class subtree_pred_t, class node_pred_t>
+	node_t* find_first(node_t* root, subtree_pred_t&& subtree_pred, node_pred_t&& node_pred) {
+		if (!root || !subtree_pred(root)) {
+			return nullptr;
+		}
+
+		node_t* curr = root;
+		while (curr) {
+			if (curr->left && subtree_pred(curr->left)) {
+				curr = curr->left;
+			} else if (node_pred(curr)) {
+				return curr;
+			} else if (curr->right && subtree_pred(curr->right)) {
+				curr = curr->right;
+			} else {
+				break;
+			}
+		}
+		return nullptr;
+	}
+
+	template<class node_t, class aug_ops_t = no_augment_t>
+	[[nodiscard]] node_t* rotate_left(node_t* root, node_t* node, aug_ops_t&& aops = {}) {
 		assert(node);
 		assert(node->right);
 
@@ -129,11 +250,14 @@ namespace cuw::bst {
 
 		pivot->parent = (node_t*)node->parent; // assign possibly tagged pointer, explicitly cast it to node_t*
 		node->parent = pivot;
+
+		aops.update(node); // node is now child of the pivot
+		aops.update(pivot);
 		return root;
 	}
 
-	template<class node_t>
-	[[nodiscard]] node_t* rotate_right(node_t* root, node_t* node) {
+	template<class node_t, class aug_ops_t = no_augment_t>
+	[[nodiscard]] node_t* rotate_right(node_t* root, node_t* node, aug_ops_t&& aops = {}) {
 		assert(node);
 		assert(node->left);
 
@@ -157,6 +281,9 @@ namespace cuw::bst {
 
 		pivot->parent = (node_t*)node->parent; // assign possibly tagged pointer, explicitly cast it to node_t*
 		node->parent = pivot;
+
+		aops.update(node); // node is now child of the pivot
+		aops.update(pivot);
 		return root;
 	}
 
@@ -241,14 +368,39 @@ namespace cuw::bst {
 		if (new_node->right) {
 			new_node->right->parent = new_node;
 		}
+
+		if constexpr(is_linked_v<node_t>) {
+			if (new_node->prev) {
+				new_node->prev->next = new_node;
+			} if (new_node->next) {
+				new_node->next->prev = new_node;
+			}
+		}
 		
 		return root;
 	}
 
 	template<class node_t, class func_t>
 	void traverse_inorder(node_t* root, func_t&& func) {
+		if constexpr(is_linked_v<node_t>) {
+			if (root) {
+				node_t* last = tree_max(root);
+				node_t* curr = tree_min(root);
+				while (true) {
+					node_t* next = curr->next; // node can be freed by func
+					bool done = curr == last;
+					func(curr);
+					if (done) {
+						break;
+					} curr = next;
+				}
+			}
+			return;
+		}
+
 		if (root) {
-			auto left = root->left, right = root->right;
+			node_t* left = root->left;
+			node_t* right = root->right;
 			traverse_inorder(left, func);
 			func(root);
 			traverse_inorder(right, func);
@@ -258,7 +410,8 @@ namespace cuw::bst {
 	template<class node_t, class func_t>
 	void traverse_preorder(node_t* root, func_t&& func) {
 		if (root) {
-			auto left = root->left, right = root->right;
+			node_t* left = root->left;
+			node_t* right = root->right;
 			func(root);
 			traverse_preorder(left, func);
 			traverse_preorder(right, func);
@@ -268,13 +421,91 @@ namespace cuw::bst {
 	template<class node_t, class func_t>
 	void traverse_postorder(node_t* root, func_t&& func) {
 		if (root) {
-			auto left = root->left, right = root->right;
+			node_t* left = root->left;
+			node_t* right = root->right;
 			traverse_postorder(left, func);
 			traverse_postorder(right, func);
 			func(root);
 		}
 	}
 
+	// iterative post-order traversal that dismantles the tree, func can free the node
+	// children are detached before their parent is visited so no stack is needed
+	template<class node_t, class func_t>
+	void destroy(node_t* root, func_t&& func) {
+		node_t* curr = root;
+		while (curr) {
+			if (curr->left) {
+				curr = curr->left;
+			} else if (curr->right) {
+				curr = curr->right;
+			} else {
+				node_t* parent = curr != root ? (node_t*)curr->parent : nullptr;
+				if (parent) {
+					if (parent->left == curr) {
+						parent->left = nullptr;
+					} else {
+						parent->right = nullptr;
+					}
+				}
+				func(curr);
+				curr = parent;
+			}
+		}
+	}
+
+	namespace impl {
+		template<class node_t, class gen_t, class aug_ops_t, class mark_t>
+		node_t* build(std::size_t count, int depth, node_t*& last, gen_t& gen, aug_ops_t& aops, mark_t& mark) {
+			if (!count) {
+				return nullptr;
+			}
+
+			node_t* left = build<node_t>((count - 1) / 2, depth + 1, last, gen, aops, mark);
+			node_t* node = gen();
+			if constexpr(is_linked_v<node_t>) {
+				node->prev = last;
+				if (last) {
+					last->next = node;
+				}
+			} last = node;
+			node_t* right = build<node_t>(count - 1 - (count - 1) / 2, depth + 1, last, gen, aops, mark);
+
+			node->left = left;
+			node->right = right;
+			if (left) {
+				left->parent = node;
+			} if (right) {
+				right->parent = node;
+			}
+			mark(node, depth);
+			aops.update(node);
+			return node;
+		}
+	}
+
+	// builds balanced tree of count nodes in O(n), gen() must return nodes in sorted order
+	// mark(node, depth) is called for every node after its subtree is built
+	template<class gen_t, class aug_ops_t, class mark_t>
+	auto build(std::size_t count, gen_t&& gen, aug_ops_t&& aops, mark_t&& mark) {
+		using node_t = std::remove_pointer_t<decltype(gen())>;
+
+		node_t* last = nullptr;
+		node_t* root = impl::build<node_t>(count, 0, last, gen, aops, mark);
+		if (root) {
+			root->parent = nullptr;
+		} if constexpr(is_linked_v<node_t>) {
+			if (last) {
+				last->next = nullptr;
+			}
+		} return root;
+	}
+
+	template<class gen_t, class aug_ops_t = no_augment_t>
+	auto build(std::size_t count, gen_t&& gen, aug_ops_t&& aops = {}) {
+		return build(count, gen, aops, [] (auto*, int) {});
+	}
+
 	// creates singly-linked list, left-pointer is next-pointer
 	template<class node_t>
 	struct head_tail_t {
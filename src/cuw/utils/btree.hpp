@@ -0,0 +1,594 @@
+#pragma once
+
+#include <new>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <utility>
+#include <type_traits>
+
+namespace cuw::btree {
+	// pooled B+tree storing pointers to values, keys are copied into the nodes so search touches nodes only
+	// key_ops protocol is the same as for bst/trb: key_ops.get_key(value) & key_ops.compare(lhs_key, rhs_key)
+	// equal keys are allowed, new value is inserted at the end of the range of equal values
+
+	// nodes are taken from chunks requested from alloc_t (allocate(size), deallocate(ptr, size))
+	// insertion cannot fail: reserve(alloc) must be called beforehand so split won't need to allocate
+	// removal never allocates, free nodes are kept for further reuse until release(alloc)
+
+	inline constexpr std::size_t default_node_size = 256; // 4 cache lines
+	inline constexpr std::size_t default_chunk_size = (std::size_t)1 << 16;
+
+	namespace impl {
+		// branchless scans over the whole key array, for integral keys compilers turn them into SIMD compares
+		// count of keys less than key
+		template<class key_t, class key_ops_t>
+		std::uint32_t rank_lt(const key_t* keys, std::uint32_t count, const key_t& key, key_ops_t& kops) {
+			std::uint32_t rank = 0;
+			for (std::uint32_t i = 0; i < count; i++) {
+				rank += kops.compare(keys[i], key);
+			} return rank;
+		}
+
+		// count of keys less than or equal to key
+		template<class key_t, class key_ops_t>
+		std::uint32_t rank_le(const key_t* keys, std::uint32_t count, const key_t& key, key_ops_t& kops) {
+			std::uint32_t rank = 0;
+			for (std::uint32_t i = 0; i < count; i++) {
+				rank += !kops.compare(key, keys[i]);
+			} return rank;
+		}
+	}
+
+	template<class __value_t, class __key_ops_t, std::size_t __node_size = default_node_size>
+	class btree_t {
+	public:
+		using value_t = __value_t;
+		using key_ops_t = __key_ops_t;
+		using key_t = std::remove_cvref_t<decltype(std::declval<key_ops_t&>().get_key(std::declval<value_t*>()))>;
+
+		static constexpr std::size_t node_size = __node_size;
+
+		static_assert(std::is_trivially_copyable_v<key_t>);
+		static_assert(node_size % alignof(std::max_align_t) == 0);
+
+	private:
+		struct node_t {
+			std::uint32_t count; // keys
+			std::uint32_t leaf;
+		};
+
+		static constexpr std::size_t leaf_capacity = (node_size - sizeof(node_t) - 2 * sizeof(void*)) / (sizeof(key_t) + sizeof(value_t*));
+		static constexpr std::size_t inner_capacity = (node_size - sizeof(node_t) - sizeof(void*)) / (sizeof(key_t) + sizeof(node_t*));
+		static constexpr std::uint32_t leaf_min = leaf_capacity / 2;
+		static constexpr std::uint32_t inner_min = inner_capacity / 2;
+
+		static_assert(leaf_capacity >= 4 && inner_capacity >= 4, "node is too small");
+
+		struct leaf_t : node_t {
+			leaf_t* prev;
+			leaf_t* next;
+			key_t keys[leaf_capacity];
+			value_t* values[leaf_capacity];
+		};
+
+		// children[i] contains keys from range [keys[i - 1], keys[i]]
+		struct inner_t : node_t {
+			key_t keys[inner_capacity];
+			node_t* children[inner_capacity + 1];
+		};
+
+		static_assert(sizeof(leaf_t) <= node_size && sizeof(inner_t) <= node_size);
+
+		struct free_node_t {
+			free_node_t* next{};
+		};
+
+		// first node of the chunk is reserved for the header
+		struct chunk_t {
+			chunk_t* next{};
+		};
+
+		struct split_t {
+			node_t* node{};
+			key_t key{};
+		};
+
+	public:
+		btree_t() = default;
+
+		btree_t(const btree_t&) = delete;
+		btree_t& operator = (const btree_t&) = delete;
+
+		void set_chunk_size(std::size_t value) {
+			assert(value >= 2 * node_size);
+			chunk_size = value;
+		}
+
+	private:
+		template<class alloc_t>
+		bool alloc_chunk(alloc_t& alloc) {
+			char* mem = (char*)alloc.allocate(chunk_size);
+			if (!mem) {
+				return false;
+			}
+
+			chunks = new (mem) chunk_t{chunks};
+			for (std::size_t offset = node_size; offset + node_size <= chunk_size; offset += node_size) {
+				spare = new (mem + offset) free_node_t{spare};
+				++spare_count;
+			} return true;
+		}
+
+		void* pop_node() {
+			assert(spare);
+			free_node_t* node = spare;
+			spare = node->next;
+			--spare_count;
+			return node;
+		}
+
+		leaf_t* new_leaf() {
+			leaf_t* leaf = new (pop_node()) leaf_t{};
+			leaf->leaf = 1;
+			return leaf;
+		}
+
+		inner_t* new_inner() {
+			return new (pop_node()) inner_t{};
+		}
+
+		void free_node(node_t* node) {
+			spare = new (node) free_node_t{spare};
+			++spare_count;
+		}
+
+	public:
+		// guarantees that the next insertion won't need to allocate, returns false if memory cannot be allocated
+		template<class alloc_t>
+		[[nodiscard]] bool reserve(alloc_t& alloc) {
+			while (spare_count < height + 1) { // split at every level & new root
+				if (!alloc_chunk(alloc)) {
+					return false;
+				}
+			} return true;
+		}
+
+		// all nodes are freed, values are not touched
+		template<class alloc_t>
+		void release(alloc_t& alloc) {
+			while (chunks) {
+				chunk_t* next = chunks->next;
+				alloc.deallocate(chunks, chunk_size);
+				chunks = next;
+			}
+			root = nullptr;
+			spare = nullptr;
+			spare_count = 0;
+			height = 0;
+			count = 0;
+		}
+
+	private:
+		template<class array_t>
+		static void shift_right(array_t* array, std::uint32_t pos, std::uint32_t count) {
+			std::memmove((void*)(array + pos + 1), array + pos, (count - pos) * sizeof(array_t));
+		}
+
+		template<class array_t>
+		static void shift_left(array_t* array, std::uint32_t pos, std::uint32_t count) {
+			std::memmove((void*)(array + pos), array + pos + 1, (count - pos - 1) * sizeof(array_t));
+		}
+
+		static void leaf_insert_at(leaf_t* leaf, std::uint32_t pos, const key_t& key, value_t* value) {
+			assert(leaf->count < leaf_capacity);
+			shift_right(leaf->keys, pos, leaf->count);
+			shift_right(leaf->values, pos, leaf->count);
+			leaf->keys[pos] = key;
+			leaf->values[pos] = value;
+			++leaf->count;
+		}
+
+		static void leaf_remove_at(leaf_t* leaf, std::uint32_t pos) {
+			shift_left(leaf->keys, pos, leaf->count);
+			shift_left(leaf->values, pos, leaf->count);
+			--leaf->count;
+		}
+
+		// key is inserted at pos, child is inserted to the right of the key
+		static void inner_insert_at(inner_t* inner, std::uint32_t pos, const key_t& key, node_t* child) {
+			assert(inner->count < inner_capacity);
+			shift_right(inner->keys, pos, inner->count);
+			shift_right(inner->children, pos + 1, inner->count + 1);
+			inner->keys[pos] = key;
+			inner->children[pos + 1] = child;
+			++inner->count;
+		}
+
+		// key at pos & child to the right of it are removed
+		static void inner_remove_at(inner_t* inner, std::uint32_t pos) {
+			shift_left(inner->keys, pos, inner->count);
+			shift_left(inner->children, pos + 1, inner->count + 1);
+			--inner->count;
+		}
+
+		split_t insert_leaf(leaf_t* leaf, const key_t& key, value_t* value) {
+			std::uint32_t pos = impl::rank_le(leaf->keys, leaf->count, key, kops);
+			if (leaf->count < leaf_capacity) {
+				leaf_insert_at(leaf, pos, key, value);
+				return {};
+			}
+
+			leaf_t* right = new_leaf();
+			std::uint32_t keep = leaf->count - leaf_capacity / 2;
+			right->count = leaf->count - keep;
+			std::memcpy((void*)right->keys, leaf->keys + keep, right->count * sizeof(key_t));
+			std::memcpy((void*)right->values, leaf->values + keep, right->count * sizeof(value_t*));
+			leaf->count = keep;
+
+			right->prev = leaf;
+			right->next = leaf->next;
+			if (leaf->next) {
+				leaf->next->prev = right;
+			} leaf->next = right;
+
+			if (pos <= keep) {
+				leaf_insert_at(leaf, pos, key, value);
+			} else {
+				leaf_insert_at(right, pos - keep, key, value);
+			} return {right, right->keys[0]};
+		}
+
+		split_t insert_inner(inner_t* inner, std::uint32_t pos, const split_t& child_split) {
+			if (inner->count < inner_capacity) {
+				inner_insert_at(inner, pos, child_split.key, child_split.node);
+				return {};
+			}
+
+			// all keys & children are gathered first, middle key goes up
+			key_t keys[inner_capacity + 1];
+			node_t* children[inner_capacity + 2];
+			std::memcpy((void*)keys, inner->keys, pos * sizeof(key_t));
+			std::memcpy((void*)(keys + pos + 1), inner->keys + pos, (inner->count - pos) * sizeof(key_t));
+			std::memcpy((void*)children, inner->children, (pos + 1) * sizeof(node_t*));
+			std::memcpy((void*)(children + pos + 2), inner->children + pos + 1, (inner->count - pos) * sizeof(node_t*));
+			keys[pos] = child_split.key;
+			children[pos + 1] = child_split.node;
+
+			std::uint32_t total = inner->count + 1;
+			std::uint32_t mid = total / 2;
+
+			inner_t* right = new_inner();
+			inner->count = mid;
+			std::memcpy((void*)inner->keys, keys, mid * sizeof(key_t));
+			std::memcpy((void*)inner->children, children, (mid + 1) * sizeof(node_t*));
+			right->count = total - mid - 1;
+			std::memcpy((void*)right->keys, keys + mid + 1, right->count * sizeof(key_t));
+			std::memcpy((void*)right->children, children + mid + 1, (right->count + 1) * sizeof(node_t*));
+			return {right, keys[mid]};
+		}
+
+		split_t insert_rec(node_t* node, const key_t& key, value_t* value) {
+			if (node->leaf) {
+				return insert_leaf(static_cast<leaf_t*>(node), key, value);
+			}
+
+			inner_t* inner = static_cast<inner_t*>(node);
+			std::uint32_t pos = impl::rank_le(inner->keys, inner->count, key, kops);
+			if (split_t split = insert_rec(inner->children[pos], key, value); split.node) {
+				return insert_inner(inner, pos, split);
+			} return {};
+		}
+
+	public:
+		// reserve() must be called beforehand
+		void insert(value_t* value) {
+			assert(value);
+			assert(spare_count >= height + 1);
+
+			key_t key = kops.get_key(value);
+			if (!root) {
+				leaf_t* leaf = new_leaf();
+				leaf_insert_at(leaf, 0, key, value);
+				root = leaf;
+				height = 1;
+				count = 1;
+				return;
+			}
+
+			if (split_t split = insert_rec(root, key, value); split.node) {
+				inner_t* new_root = new_inner();
+				new_root->count = 1;
+				new_root->keys[0] = split.key;
+				new_root->children[0] = root;
+				new_root->children[1] = split.node;
+				root = new_root;
+				++height;
+			} ++count;
+		}
+
+		template<class alloc_t>
+		[[nodiscard]] bool insert(alloc_t& alloc, value_t* value) {
+			if (!reserve(alloc)) {
+				return false;
+			}
+			insert(value);
+			return true;
+		}
+
+	private:
+		void fix_leaf(inner_t* parent, std::uint32_t pos) {
+			leaf_t* leaf = static_cast<leaf_t*>(parent->children[pos]);
+			leaf_t* left = pos > 0 ? static_cast<leaf_t*>(parent->children[pos - 1]) : nullptr;
+			leaf_t* right = pos < parent->count ? static_cast<leaf_t*>(parent->children[pos + 1]) : nullptr;
+			if (left && left->count > leaf_min) {
+				leaf_insert_at(leaf, 0, left->keys[left->count - 1], left->values[left->count - 1]);
+				--left->count;
+				parent->keys[pos - 1] = leaf->keys[0];
+			} else if (right && right->count > leaf_min) {
+				leaf_insert_at(leaf, leaf->count, right->keys[0], right->values[0]);
+				leaf_remove_at(right, 0);
+				parent->keys[pos] = right->keys[0];
+			} else if (left) {
+				merge_leaves(parent, pos - 1, left, leaf);
+			} else {
+				merge_leaves(parent, pos, leaf, right);
+			}
+		}
+
+		void merge_leaves(inner_t* parent, std::uint32_t pos, leaf_t* left, leaf_t* right) {
+			std::memcpy((void*)(left->keys + left->count), right->keys, right->count * sizeof(key_t));
+			std::memcpy((void*)(left->values + left->count), right->values, right->count * sizeof(value_t*));
+			left->count += right->count;
+			left->next = right->next;
+			if (right->next) {
+				right->next->prev = left;
+			}
+			inner_remove_at(parent, pos);
+			free_node(right);
+		}
+
+		void fix_inner(inner_t* parent, std::uint32_t pos) {
+			inner_t* inner = static_cast<inner_t*>(parent->children[pos]);
+			inner_t* left = pos > 0 ? static_cast<inner_t*>(parent->children[pos - 1]) : nullptr;
+			inner_t* right = pos < parent->count ? static_cast<inner_t*>(parent->children[pos + 1]) : nullptr;
+			if (left && left->count > inner_min) {
+				shift_right(inner->keys, 0, inner->count);
+				shift_right(inner->children, 0, inner->count + 1);
+				inner->keys[0] = parent->keys[pos - 1];
+				inner->children[0] = left->children[left->count];
+				++inner->count;
+				parent->keys[pos - 1] = left->keys[left->count - 1];
+				--left->count;
+			} else if (right && right->count > inner_min) {
+				inner->keys[inner->count] = parent->keys[pos];
+				inner->children[inner->count + 1] = right->children[0];
+				++inner->count;
+				parent->keys[pos] = right->keys[0];
+				shift_left(right->keys, 0, right->count);
+				shift_left(right->children, 0, right->count + 1);
+				--right->count;
+			} else if (left) {
+				merge_inners(parent, pos - 1, left, inner);
+			} else {
+				merge_inners(parent, pos, inner, right);
+			}
+		}
+
+		void merge_inners(inner_t* parent, std::uint32_t pos, inner_t* left, inner_t* right) {
+			left->keys[left->count] = parent->keys[pos];
+			std::memcpy((void*)(left->keys + left->count + 1), right->keys, right->count * sizeof(key_t));
+			std::memcpy((void*)(left->children + left->count + 1), right->children, (right->count + 1) * sizeof(node_t*));
+			left->count += right->count + 1;
+			inner_remove_at(parent, pos);
+			free_node(right);
+		}
+
+		bool erase_rec(node_t* node, const key_t& key, value_t* value) {
+			if (node->leaf) {
+				leaf_t* leaf = static_cast<leaf_t*>(node);
+				std::uint32_t first = impl::rank_lt(leaf->keys, leaf->count, key, kops);
+				std::uint32_t last = impl::rank_le(leaf->keys, leaf->count, key, kops);
+				for (std::uint32_t pos = first; pos < last; pos++) {
+					if (leaf->values[pos] == value) {
+						leaf_remove_at(leaf, pos);
+						return true;
+					}
+				} return false;
+			}
+
+			// range of equal keys can span several children
+			inner_t* inner = static_cast<inner_t*>(node);
+			std::uint32_t first = impl::rank_lt(inner->keys, inner->count, key, kops);
+			std::uint32_t last = impl::rank_le(inner->keys, inner->count, key, kops);
+			for (std::uint32_t pos = first; pos <= last; pos++) {
+				node_t* child = inner->children[pos];
+				if (erase_rec(child, key, value)) {
+					if (child->leaf && child->count < leaf_min) {
+						fix_leaf(inner, pos);
+					} else if (!child->leaf && child->count < inner_min) {
+						fix_inner(inner, pos);
+					} return true;
+				}
+			} return false;
+		}
+
+	public:
+		// key of the value must not be changed while value is in the tree
+		bool erase(value_t* value) {
+			assert(value);
+
+			if (!root || !erase_rec(root, kops.get_key(value), value)) {
+				return false;
+			}
+
+			--count;
+			if (root->count == 0) {
+				node_t* old_root = root;
+				root = root->leaf ? nullptr : static_cast<inner_t*>(root)->children[0];
+				free_node(old_root);
+				--height;
+			} return true;
+		}
+
+	private:
+		value_t** find_slot(node_t* node, const key_t& key, value_t* value) {
+			if (node->leaf) {
+				leaf_t* leaf = static_cast<leaf_t*>(node);
+				std::uint32_t first = impl::rank_lt(leaf->keys, leaf->count, key, kops);
+				std::uint32_t last = impl::rank_le(leaf->keys, leaf->count, key, kops);
+				for (std::uint32_t pos = first; pos < last; pos++) {
+					if (leaf->values[pos] == value) {
+						return &leaf->values[pos];
+					}
+				} return nullptr;
+			}
+
+			inner_t* inner = static_cast<inner_t*>(node);
+			std::uint32_t first = impl::rank_lt(inner->keys, inner->count, key, kops);
+			std::uint32_t last = impl::rank_le(inner->keys, inner->count, key, kops);
+			for (std::uint32_t pos = first; pos <= last; pos++) {
+				if (value_t** slot = find_slot(inner->children[pos], key, value)) {
+					return slot;
+				}
+			} return nullptr;
+		}
+
+	public:
+		// value is replaced in place (for example, when value object is moved), new value must have the same key
+		bool replace(value_t* old_value, value_t* new_value) {
+			assert(old_value);
+			assert(new_value);
+
+			if (!root) {
+				return false;
+			} if (value_t** slot = find_slot(root, kops.get_key(old_value), old_value)) {
+				*slot = new_value;
+				return true;
+			} return false;
+		}
+
+	private:
+		const leaf_t* find_leaf(const key_t& key, bool upper) const {
+			const node_t* node = root;
+			while (!node->leaf) {
+				const inner_t* inner = static_cast<const inner_t*>(node);
+				std::uint32_t pos = upper
+					? impl::rank_le(inner->keys, inner->count, key, kops)
+					: impl::rank_lt(inner->keys, inner->count, key, kops);
+				node = inner->children[pos];
+			} return static_cast<const leaf_t*>(node);
+		}
+
+	public:
+		// first value with key greater than or equal to the given one
+		value_t* lower_bound(const key_t& key) const {
+			if (!root) {
+				return nullptr;
+			}
+
+			const leaf_t* leaf = find_leaf(key, false);
+			if (std::uint32_t pos = impl::rank_lt(leaf->keys, leaf->count, key, kops); pos < leaf->count) {
+				return leaf->values[pos];
+			} return leaf->next ? leaf->next->values[0] : nullptr;
+		}
+
+		// last value with key less than or equal to the given one
+		value_t* floor(const key_t& key) const {
+			if (!root) {
+				return nullptr;
+			}
+
+			const leaf_t* leaf = find_leaf(key, true);
+			if (std::uint32_t pos = impl::rank_le(leaf->keys, leaf->count, key, kops); pos > 0) {
+				return leaf->values[pos - 1];
+			} return leaf->prev ? leaf->prev->values[leaf->prev->count - 1] : nullptr;
+		}
+
+		// void func(value_t* value), in key order
+		template<class func_t>
+		void traverse(func_t&& func) const {
+			if (!root) {
+				return;
+			}
+
+			const node_t* node = root;
+			while (!node->leaf) {
+				node = static_cast<const inner_t*>(node)->children[0];
+			}
+			for (const leaf_t* leaf = static_cast<const leaf_t*>(node); leaf; leaf = leaf->next) {
+				for (std::uint32_t i = 0; i < leaf->count; i++) {
+					func(leaf->values[i]);
+				}
+			}
+		}
+
+	private:
+		bool check_node(const node_t* node, std::size_t depth, const key_t* lo, const key_t* hi) const {
+			auto in_range = [&] (const key_t& key) {
+				return (!lo || !kops.compare(key, *lo)) && (!hi || !kops.compare(*hi, key));
+			};
+
+			if (node != root && node->count < (node->leaf ? leaf_min : inner_min)) {
+				return false;
+			} if (node->leaf) {
+				const leaf_t* leaf = static_cast<const leaf_t*>(node);
+				for (std::uint32_t i = 0; i < leaf->count; i++) {
+					if (!in_range(leaf->keys[i]) || (i > 0 && kops.compare(leaf->keys[i], leaf->keys[i - 1]))
+						|| kops.compare(kops.get_key(leaf->values[i]), leaf->keys[i]) || kops.compare(leaf->keys[i], kops.get_key(leaf->values[i]))) {
+						return false;
+					}
+				} return depth == height;
+			}
+
+			const inner_t* inner = static_cast<const inner_t*>(node);
+			for (std::uint32_t i = 0; i < inner->count; i++) {
+				if (!in_range(inner->keys[i]) || (i > 0 && kops.compare(inner->keys[i], inner->keys[i - 1]))) {
+					return false;
+				}
+			}
+			for (std::uint32_t i = 0; i <= inner->count; i++) {
+				const key_t* child_lo = i > 0 ? &inner->keys[i - 1] : lo;
+				const key_t* child_hi = i < inner->count ? &inner->keys[i] : hi;
+				if (!check_node(inner->children[i], depth + 1, child_lo, child_hi)) {
+					return false;
+				}
+			} return true;
+		}
+
+	public:
+		// serves mostly for debug purposes: checks order, occupancy & that all leaves have the same depth
+		bool check_invariant() const {
+			if (!root) {
+				return height == 0 && count == 0;
+			}
+
+			std::size_t total = 0;
+			traverse([&] (value_t*) { ++total; });
+			return total == count && check_node(root, 1, nullptr, nullptr);
+		}
+
+		std::size_t get_size() const {
+			return count;
+		}
+
+		std::size_t get_height() const {
+			return height;
+		}
+
+		bool empty() const {
+			return count == 0;
+		}
+
+	private:
+		node_t* root{};
+		free_node_t* spare{};
+		chunk_t* chunks{};
+		std::size_t spare_count{};
+		std::size_t height{};
+		std::size_t count{};
+		std::size_t chunk_size{default_chunk_size};
+		[[no_unique_address]] key_ops_t kops{};
+	};
+}
@@ -3,6 +3,7 @@
 #include <new>
 #include <cstddef>
 #include <cassert>
+#include <cstdint>
 
 namespace cuw {
 	inline void* advance_ptr(void* ptr, std::ptrdiff_t diff) {
@@ -110,4 +111,101 @@ namespace cuw {
 
 		std::uintptr_t ptr_data{};
 	};
+
+	// compact counterpart of tagged_ptr_t: 32-bit offset relative to the base of the region containing the pointer itself
+	// region is 2^region_bits bytes aligned by its size so the base is the address of the pointer with low bits cleared
+	// pointer and its target must be within the same region, offset 0 is null (region base cannot be a target)
+	// data is packed into low bits of the offset so the target must be aligned by 2^bits
+	// copy is re-encoded relatively to its own region so copy it only within the region, cast it to type_t* otherwise
+	template<class __type_t, std::size_t __region_bits, std::size_t __bits = 0>
+	struct region_ptr_t {
+		using type_t = __type_t;
+
+		static constexpr std::size_t region_bits = __region_bits;
+		static constexpr std::size_t bits = __bits;
+		static constexpr std::uint32_t data_mask = ((std::uint32_t)1 << bits) - 1;
+		static constexpr std::uint32_t ptr_mask = ~data_mask;
+		static constexpr std::uintptr_t region_mask = ((std::uintptr_t)1 << region_bits) - 1;
+
+		static_assert(region_bits <= 32, "region is too large for 32-bit offset");
+		static_assert(bits < region_bits, "too many bits");
+
+		region_ptr_t(type_t* ptr = nullptr) {
+			set_ptr_data(ptr, 0);
+		}
+
+		region_ptr_t(type_t* ptr, std::uint32_t data) {
+			set_ptr_data(ptr, data);
+		}
+
+		region_ptr_t(const region_ptr_t& another) {
+			set_ptr_data(another.get_ptr(), another.get_data());
+		}
+
+		region_ptr_t& operator = (const region_ptr_t& another) {
+			set_ptr_data(another.get_ptr(), another.get_data());
+			return *this;
+		}
+
+		region_ptr_t& operator = (type_t* ptr) {
+			set_ptr(ptr);
+			return *this;
+		}
+
+		type_t* operator -> () const {
+			return get_ptr();
+		}
+
+		type_t& operator * () const {
+			return *get_ptr();
+		}
+
+		operator type_t* () const {
+			return get_ptr();
+		}
+
+		// data part is kept
+		void set_ptr(type_t* ptr) {
+			offset = encode(ptr) | (offset & data_mask);
+		}
+
+		// data must not contain inappropriate bits
+		void set_data(std::uint32_t data) {
+			assert((data & ptr_mask) == 0);
+			offset = (offset & ptr_mask) | data;
+		}
+
+		void set_ptr_data(type_t* ptr, std::uint32_t data) {
+			assert((data & ptr_mask) == 0);
+			offset = encode(ptr) | data;
+		}
+
+		type_t* get_ptr() const {
+			std::uint32_t value = offset & ptr_mask;
+			return value ? (type_t*)(get_base() + value) : nullptr;
+		}
+
+		std::uint32_t get_data() const {
+			return offset & data_mask;
+		}
+
+	private:
+		std::uintptr_t get_base() const {
+			return (std::uintptr_t)this & ~region_mask;
+		}
+
+		std::uint32_t encode(type_t* ptr) const {
+			if (!ptr) {
+				return 0;
+			}
+
+			std::uintptr_t value = (std::uintptr_t)ptr - get_base();
+			assert(value != 0 && value <= region_mask);
+			assert((value & data_mask) == 0);
+			return (std::uint32_t)value;
+		}
+
+	public:
+		std::uint32_t offset{};
+	};
 }
\ No newline at end of file
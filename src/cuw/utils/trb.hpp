@@ -3,12 +3,21 @@
 #include "bst.hpp"
 #include "trb_node.hpp"
 
+#include <bit>
 #include <cassert>
+#include <tuple>
 #include <utility>
+#include <algorithm>
 
 namespace cuw::trb {
 	template<class node_t>
-	[[nodiscard]] node_t* fix_insert(node_t* root, node_t* node) {
+	struct split_res_t {
+		node_t* left{};
+		node_t* right{};
+	};
+
+	template<class node_t, class aug_ops_t = bst::no_augment_t>
+	[[nodiscard]] node_t* fix_insert(node_t* root, node_t* node, aug_ops_t&& aops = {}) {
 		while (node->parent && get_color(node->parent) == node_color_t::Red) {
 			if (node->parent == node->parent->parent->left) {
 				node_t* uncle = node->parent->parent->right;
@@ -20,11 +29,11 @@ namespace cuw::trb {
 				} else {
 					if (node == node->parent->right) {
 						node = node->parent;
-						root = bst::rotate_left(root, node);
+						root = bst::rotate_left(root, node, aops);
 					}
 					set_color(node->parent, node_color_t::Black);
 					set_color(node->parent->parent, node_color_t::Red);
-					root = bst::rotate_right(root, (node_t*)node->parent->parent);
+					root = bst::rotate_right(root, (node_t*)node->parent->parent, aops);
 				}
 			} else {
 				node_t* uncle = node->parent->parent->left;
@@ -36,11 +45,11 @@ namespace cuw::trb {
 				} else {
 					if (node == node->parent->left) {
 						node = node->parent;
-						root = bst::rotate_right(root, node);
+						root = bst::rotate_right(root, node, aops);
 					}
 					set_color(node->parent, node_color_t::Black);
 					set_color(node->parent->parent, node_color_t::Red);
-					root = bst::rotate_left(root, (node_t*)node->parent->parent);
+					root = bst::rotate_left(root, (node_t*)node->parent->parent, aops);
 				}
 			}
 		}
@@ -50,8 +59,8 @@ namespace cuw::trb {
 
 	// element will be inserted at the beginning of the range of equal elements
 	// hint is some valid insert position (like gotten from search_{lb,ub} functions) 
-	template<class node_t, class key_ops_t>
-	[[nodiscard]] node_t* insert_lb_hint(node_t* root, node_t* node, node_t* hint, key_ops_t&& kops) {
+	template<class node_t, class key_ops_t, class aug_ops_t = bst::no_augment_t>
+	[[nodiscard]] node_t* insert_lb_hint(node_t* root, node_t* node, node_t* hint, key_ops_t&& kops, aug_ops_t&& aops = {}) {
 		assert(node);
 
 		node->parent = hint;
@@ -68,22 +77,26 @@ namespace cuw::trb {
 		}
 		node->left = nullptr;
 		node->right = nullptr;
+		bst::link_leaf(node);
 		set_color(node, node_color_t::Red);
-		return fix_insert(root, node);
+		if constexpr(bst::is_augmented_v<aug_ops_t>) {
+			bst::propagate(node, aops);
+		}
+		return fix_insert(root, node, aops);
 	}
 
-	template<class node_t, class key_ops_t>
-	[[nodiscard]] node_t* insert_lb(node_t* root, node_t* node, key_ops_t&& kops) {
+	template<class node_t, class key_ops_t, class aug_ops_t = bst::no_augment_t>
+	[[nodiscard]] node_t* insert_lb(node_t* root, node_t* node, key_ops_t&& kops, aug_ops_t&& aops = {}) {
 		assert(node);
 
 		auto [lb, prev] = bst::search_insert_lb(root, kops.get_key(node), kops);
-		return insert_lb_hint(root, node, prev, kops);
+		return insert_lb_hint(root, node, prev, kops, aops);
 	}
 
 	// element will be inserted at the end of the range of equal elements
 	// hint is some valid insert position (like gotten from search_{lb,ub} functions)
-	template<class node_t, class key_ops_t>
-	[[nodiscard]] node_t* insert_ub_hint(node_t* root, node_t* node, node_t* hint, key_ops_t&& kops) {
+	template<class node_t, class key_ops_t, class aug_ops_t = bst::no_augment_t>
+	[[nodiscard]] node_t* insert_ub_hint(node_t* root, node_t* node, node_t* hint, key_ops_t&& kops, aug_ops_t&& aops = {}) {
 		assert(node);
 
 		node->parent = hint;
@@ -100,27 +113,31 @@ namespace cuw::trb {
 		}
 		node->left = nullptr;
 		node->right = nullptr;
+		bst::link_leaf(node);
 		set_color(node, node_color_t::Red);
-		return fix_insert(root, node);
+		if constexpr(bst::is_augmented_v<aug_ops_t>) {
+			bst::propagate(node, aops);
+		}
+		return fix_insert(root, node, aops);
 	}
 
-	template<class node_t, class key_ops_t>
-	[[nodiscard]] node_t* insert_ub(node_t* root, node_t* node, key_ops_t&& kops) {
+	template<class node_t, class key_ops_t, class aug_ops_t = bst::no_augment_t>
+	[[nodiscard]] node_t* insert_ub(node_t* root, node_t* node, key_ops_t&& kops, aug_ops_t&& aops = {}) {
 		assert(node);
 
 		node_t* prev = bst::search_insert_ub(root, kops.get_key(node), kops);
-		return insert_ub_hint(root, node, prev, kops);
+		return insert_ub_hint(root, node, prev, kops, aops);
 	}
 
 	// insert node after given node, so tree order will be ... -> after -> node -> ...
-	template<class node_t>
-	[[nodiscard]] node_t* insert_after(node_t* root, node_t* after, node_t* node) {        
+	template<class node_t, class aug_ops_t = bst::no_augment_t>
+	[[nodiscard]] node_t* insert_after(node_t* root, node_t* after, node_t* node, aug_ops_t&& aops = {}) {        
 		assert(root);
 		assert(after);
 		assert(node);
 
 		if (after->right) {
-			node_t* succ = successor(after);
+			node_t* succ = bst::successor(after);
 			succ->left = node;
 			node->parent = succ;
 		} else {
@@ -129,13 +146,17 @@ namespace cuw::trb {
 		}
 		node->left = nullptr;
 		node->right = nullptr;
+		bst::link_leaf(node);
 		set_color(node, node_color_t::Red);
-		return fix_insert(root, node);
+		if constexpr(bst::is_augmented_v<aug_ops_t>) {
+			bst::propagate(node, aops);
+		}
+		return fix_insert(root, node, aops);
 	}
 
 	// insert node before given node, so tree order will be ... -> node -> before -> ...
-	template<class node_t>
-	[[nodiscard]] node_t* insert_before(node_t* root, node_t* before, node_t* node) {
+	template<class node_t, class aug_ops_t = bst::no_augment_t>
+	[[nodiscard]] node_t* insert_before(node_t* root, node_t* before, node_t* node, aug_ops_t&& aops = {}) {
 		assert(root);
 		assert(before);
 		assert(node);
@@ -150,19 +171,23 @@ namespace cuw::trb {
 		}
 		node->left = nullptr;
 		node->right = nullptr;
+		bst::link_leaf(node);
 		set_color(node, node_color_t::Red);
-		return fix_insert(root, node);
+		if constexpr(bst::is_augmented_v<aug_ops_t>) {
+			bst::propagate(node, aops);
+		}
+		return fix_insert(root, node, aops);
 	}
 
-	template<class node_t>
-	[[nodiscard]] node_t* fix_remove(node_t* root, node_t* restore_parent, node_t* restore, bool restore_parent_left) {
+	template<class node_t, class aug_ops_t = bst::no_augment_t>
+	[[nodiscard]] node_t* fix_remove(node_t* root, node_t* restore_parent, node_t* restore, bool restore_parent_left, aug_ops_t&& aops = {}) {
 		if (!restore && restore != root) { // nullptr is colored black
 			if (restore_parent_left) {
 				node_t* brother = restore_parent->right; // brother must not be nullptr
 				if (get_color(brother) == node_color_t::Red) {
 					set_color(brother, node_color_t::Black);
 					set_color(restore_parent, node_color_t::Red);
-					root = bst::rotate_left(root, restore_parent);
+					root = bst::rotate_left(root, restore_parent, aops);
 					brother = restore_parent->right; // must not be nullptr
 				}
 
@@ -175,13 +200,13 @@ namespace cuw::trb {
 					if (!brother->right || get_color(brother->right) == node_color_t::Black) {
 						set_color(brother->left, node_color_t::Black);
 						set_color(brother, node_color_t::Red);
-						root = bst::rotate_right(root, brother);
+						root = bst::rotate_right(root, brother, aops);
 						brother = restore_parent->right;
 					}
 					set_color(brother, get_color(restore_parent));
 					set_color(restore_parent, node_color_t::Black);
 					set_color(brother->right, node_color_t::Black);
-					root = bst::rotate_left(root, restore_parent);
+					root = bst::rotate_left(root, restore_parent, aops);
 					restore = root;
 				}
 			} else {
@@ -189,7 +214,7 @@ namespace cuw::trb {
 				if (get_color(brother) == node_color_t::Red) {
 					set_color(brother, node_color_t::Black);
 					set_color(restore_parent, node_color_t::Red);
-					root = bst::rotate_right(root, restore_parent);
+					root = bst::rotate_right(root, restore_parent, aops);
 					brother = restore_parent->left;
 				}
 
@@ -201,13 +226,13 @@ namespace cuw::trb {
 					if (!brother->left || get_color(brother->left) == node_color_t::Black) {
 						set_color(brother->right, node_color_t::Black);
 						set_color(brother, node_color_t::Red);
-						root = bst::rotate_left(root, brother);
+						root = bst::rotate_left(root, brother, aops);
 						brother = restore_parent->left;
 					}
 					set_color(brother, get_color(restore_parent));
 					set_color(restore_parent, node_color_t::Black);
 					set_color(brother->left, node_color_t::Black);
-					root = bst::rotate_right(root, restore_parent);
+					root = bst::rotate_right(root, restore_parent, aops);
 					restore = root;
 				}
 			}
@@ -223,7 +248,7 @@ namespace cuw::trb {
 				if (get_color(brother) == node_color_t::Red) {
 					set_color(brother, node_color_t::Black);
 					set_color(restore->parent, node_color_t::Red);
-					root = bst::rotate_left(root, (node_t*)restore->parent);
+					root = bst::rotate_left(root, (node_t*)restore->parent, aops);
 					brother = restore->parent->right;
 				}
 
@@ -235,13 +260,13 @@ namespace cuw::trb {
 					if (!brother->right || get_color(brother->right) == node_color_t::Black) {
 						set_color(brother->left, node_color_t::Black);
 						set_color(brother, node_color_t::Red);
-						root = bst::rotate_right(root, brother);
+						root = bst::rotate_right(root, brother, aops);
 						brother = restore->parent->right;
 					}
 					set_color(brother, get_color(restore->parent));
 					set_color(restore->parent, node_color_t::Black);
 					set_color(brother->right, node_color_t::Black);
-					root = bst::rotate_left(root, (node_t*)restore->parent);
+					root = bst::rotate_left(root, (node_t*)restore->parent, aops);
 					restore = root;
 				}
 			} else {
@@ -249,7 +274,7 @@ namespace cuw::trb {
 				if (get_color(brother) == node_color_t::Red) {
 					set_color(brother, node_color_t::Black);
 					set_color(restore->parent, node_color_t::Red);
-					root = bst::rotate_right(root, (node_t*)restore->parent);
+					root = bst::rotate_right(root, (node_t*)restore->parent, aops);
 					brother = restore->parent->left;
 				}
 
@@ -261,13 +286,13 @@ namespace cuw::trb {
 					if (!brother->left || get_color(brother->left) == node_color_t::Black) {
 						set_color(brother->right, node_color_t::Black);
 						set_color(brother, node_color_t::Red);
-						root = bst::rotate_left(root, brother);
+						root = bst::rotate_left(root, brother, aops);
 						brother = restore->parent->left;
 					}
 					set_color(brother, get_color(restore->parent));
 					set_color(restore->parent, node_color_t::Black);
 					set_color(brother->left, node_color_t::Black);
-					root = bst::rotate_right(root, (node_t*)restore->parent);
+					root = bst::rotate_right(root, (node_t*)restore->parent, aops);
 					restore = root;
 				}
 			}
@@ -276,14 +301,17 @@ namespace cuw::trb {
 		return root;
 	}
 
-	template<class node_t>
-	[[nodiscard]] node_t* remove(node_t* root, node_t* node) {
+	template<class node_t, class aug_ops_t = bst::no_augment_t>
+	[[nodiscard]] node_t* remove(node_t* root, node_t* node, aug_ops_t&& aops = {}) {
 		assert(node);
 
+		bst::unlink(node);
+
 		node_color_t removed_color = get_color(node);
 
 		node_t* restore_parent = nullptr;
 		node_t* restore = nullptr;
+		node_t* aug_start = nullptr; // lowest node whose subtree was changed
 		bool restore_parent_left = false;
 		if (!node->left) {
 			restore = node->right;
@@ -291,25 +319,29 @@ namespace cuw::trb {
 			if (node->parent) {
 				restore_parent_left = node->parent->left == node;
 			}
-			root = bst::transplant(root, node, node->right);
+			aug_start = (node_t*)node->parent;
+			root = bst::transplant(root, node, (node_t*)node->right);
 		} else if (!node->right) {
 			restore = node->left;
 			restore_parent = node->parent;
 			if (node->parent) {
 				restore_parent_left = node->parent->left == node;
 			}
-			root = bst::transplant(root, node, node->left);
+			aug_start = (node_t*)node->parent;
+			root = bst::transplant(root, node, (node_t*)node->left);
 		} else {
-			node_t* leftmost = bst::tree_min(node->right);
+			node_t* leftmost = bst::successor(node); // node has right child so successor is the leftmost node of the right subtree
 			removed_color = get_color(leftmost);
 			restore = leftmost->right;
 			if (node->right == leftmost) {
 				restore_parent = leftmost;
 				restore_parent_left = false;
+				aug_start = leftmost;
 			} else {
 				restore_parent = leftmost->parent;
+				aug_start = (node_t*)leftmost->parent;
 				restore_parent_left = true;
-				root = bst::transplant(root, leftmost, leftmost->right);
+				root = bst::transplant(root, leftmost, (node_t*)leftmost->right);
 				leftmost->right = node->right;
 				node->right->parent = leftmost;
 			}
@@ -319,13 +351,175 @@ namespace cuw::trb {
 			set_color(leftmost, get_color(node));
 		}
 
+		if constexpr(bst::is_augmented_v<aug_ops_t>) {
+			bst::propagate(aug_start, aops);
+		}
+
 		if (removed_color == node_color_t::Black) {
-			root = fix_remove(root, restore_parent, restore, restore_parent_left);
+			root = fix_remove(root, restore_parent, restore, restore_parent_left, aops);
 		}
 		
 		return root;
 	}
 
+	// builds valid red-black tree from count nodes in O(n), gen() must return nodes in sorted order
+	// tree is perfectly balanced: all nodes are black except the nodes of the deepest level (they are leaves)
+	template<class gen_t, class aug_ops_t = bst::no_augment_t>
+	[[nodiscard]] auto build(std::size_t count, gen_t&& gen, aug_ops_t&& aops = {}) {
+		int max_depth = count ? (int)std::bit_width(count) - 1 : 0;
+		return bst::build(count, gen, aops, [&] (auto* node, int depth) {
+			set_color(node, depth == max_depth && depth != 0 ? node_color_t::Red : node_color_t::Black);
+		});
+	}
+
+	// number of black nodes on the path from root to the leftmost leaf, nullptr has zero black height
+	template<class node_t>
+	int black_height(node_t* root) {
+		int bh = 0;
+		for (node_t* curr = root; curr; curr = curr->left) {
+			if (get_color(curr) == node_color_t::Black) {
+				++bh;
+			}
+		} return bh;
+	}
+
+	namespace impl {
+		// links of linked nodes are not touched, roots of the trees must be black
+		template<class node_t, class aug_ops_t>
+		[[nodiscard]] node_t* join(node_t* left, node_t* mid, node_t* right, aug_ops_t&& aops) {
+			int bh_left = black_height(left);
+			int bh_right = black_height(right);
+			if (bh_left == bh_right) {
+				mid->parent = nullptr;
+				mid->left = left;
+				mid->right = right;
+				if (left) {
+					left->parent = mid;
+				} if (right) {
+					right->parent = mid;
+				}
+				set_color(mid, node_color_t::Black);
+				aops.update(mid);
+				return mid;
+			}
+
+			// descend along the inner spine of the higher tree to the black node of the same black height
+			bool go_right = bh_left > bh_right;
+			node_t* root = go_right ? left : right;
+			node_t* parent = nullptr;
+			node_t* curr = root;
+			for (int bh = std::max(bh_left, bh_right), target = std::min(bh_left, bh_right); curr; ) {
+				bool black = get_color(curr) == node_color_t::Black;
+				if (black && bh == target) {
+					break;
+				} if (black) {
+					--bh;
+				}
+				parent = curr;
+				curr = go_right ? (node_t*)curr->right : (node_t*)curr->left;
+			}
+
+			node_t* other = go_right ? right : left;
+			mid->parent = parent;
+			if (go_right) {
+				parent->right = mid;
+				mid->left = curr;
+				mid->right = other;
+			} else {
+				parent->left = mid;
+				mid->left = other;
+				mid->right = curr;
+			} if (curr) {
+				curr->parent = mid;
+			} if (other) {
+				other->parent = mid;
+			}
+			set_color(mid, node_color_t::Red);
+			if constexpr(bst::is_augmented_v<aug_ops_t>) {
+				bst::propagate(mid, aops);
+			}
+			return fix_insert(root, mid, aops);
+		}
+
+		template<class node_t>
+		node_t* detach(node_t* node) {
+			if (node) {
+				node->parent = nullptr;
+				set_color(node, node_color_t::Black);
+			} return node;
+		}
+
+		template<class node_t, class key_t, class key_ops_t, class aug_ops_t>
+		split_res_t<node_t> split(node_t* root, key_t& key, key_ops_t& kops, aug_ops_t& aops) {
+			if (!root) {
+				return {};
+			}
+
+			node_t* left = detach((node_t*)root->left);
+			node_t* right = detach((node_t*)root->right);
+			if (kops.compare(kops.get_key(root), key)) {
+				auto [less, rest] = impl::split(right, key, kops, aops);
+				return {impl::join(left, root, less, aops), rest};
+			} else {
+				auto [less, rest] = impl::split(left, key, kops, aops);
+				return {less, impl::join(rest, root, right, aops)};
+			}
+		}
+	}
+
+	// all keys of left tree must not be greater than key of mid, all keys of right tree must not be less than it
+	// O(log n), left and right trees are consumed
+	template<class node_t, class aug_ops_t = bst::no_augment_t>
+	[[nodiscard]] node_t* join(node_t* left, node_t* mid, node_t* right, aug_ops_t&& aops = {}) {
+		assert(mid);
+
+		if constexpr(bst::is_linked_v<node_t>) {
+			mid->prev = left ? bst::tree_max(left) : nullptr;
+			mid->next = right ? bst::tree_min(right) : nullptr;
+			if (mid->prev) {
+				mid->prev->next = mid;
+			} if (mid->next) {
+				mid->next->prev = mid;
+			}
+		}
+		return impl::join(impl::detach(left), mid, impl::detach(right), aops);
+	}
+
+	// joins two trees, all keys of left tree must not be greater than keys of right tree
+	template<class node_t, class aug_ops_t = bst::no_augment_t>
+	[[nodiscard]] node_t* concat(node_t* left, node_t* right, aug_ops_t&& aops = {}) {
+		if (!right) {
+			return left;
+		} if (!left) {
+			return right;
+		}
+
+		node_t* mid = bst::tree_min(right);
+		right = remove(right, mid, aops);
+		return trb::join(left, mid, right, aops);
+	}
+
+	// splits tree into nodes less than key and nodes not less than key (lower bound goes to the right tree)
+	// O(log n), tree is consumed
+	template<class node_t, class key_t, class key_ops_t, class aug_ops_t = bst::no_augment_t>
+	[[nodiscard]] split_res_t<node_t> split(node_t* root, key_t&& key, key_ops_t&& kops, aug_ops_t&& aops = {}) {
+		node_t* lb = nullptr;
+		node_t* pred = nullptr;
+		if constexpr(bst::is_linked_v<node_t>) {
+			lb = bst::lower_bound(root, key, kops);
+			pred = lb ? (node_t*)lb->prev : (root ? bst::tree_max(root) : nullptr);
+		}
+
+		auto res = impl::split(root, key, kops, aops);
+		if constexpr(bst::is_linked_v<node_t>) {
+			if (pred) {
+				pred->next = nullptr;
+			} if (lb) {
+				lb->prev = nullptr;
+			}
+		} return res;
+	}
+
 	namespace impl {
 		// returns (black height, check value)
 		template<class node_t>
@@ -334,12 +528,12 @@ namespace cuw::trb {
 				return {1, true};
 			}
 
-			auto [bh_left, check_left] = check_rb_inv(root->left);
+			auto [bh_left, check_left] = check_rb_inv((node_t*)root->left);
 			if (!check_left) {
 				return {-1, false};
 			}
 
-			auto [bh_right, check_right] = check_rb_inv(root->right);
+			auto [bh_right, check_right] = check_rb_inv((node_t*)root->right);
 			if (!check_right) {
 				return {-1, false};
 			}
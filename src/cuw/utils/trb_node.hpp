@@ -1,6 +1,8 @@
 #pragma once
 
+#include <cstdint>
 #include <utility>
+#include <algorithm>
 #include <type_traits>
 
 #include "ptr.hpp"
@@ -145,6 +147,209 @@ namespace cuw::trb {
 	}
 
 
+	// linked (threaded) node declaration
+	// packed node that additionally keeps its in-order neighbours, they are maintained by trb insert & remove
+	// so predecessor/successor are O(1) and in-order traversal doesn't recurse
+	template<class __traits_t, class __tag_t = default_node_tag_t, class = traits_data_t<__traits_t>>
+	struct alignas(__traits_t::align) tree_node_linked_t {
+		using tag_t = __tag_t;
+		using traits_t = __traits_t;
+		using data_t = traits_data_t<traits_t>;
+		using tagged_node_t = tagged_ptr_t<tree_node_linked_t, traits_t::bits>;
+
+		tagged_node_t parent;
+		tree_node_linked_t* left;
+		tree_node_linked_t* right;
+		tree_node_linked_t* prev;
+		tree_node_linked_t* next;
+		data_t data;
+	};
+
+	// specialization if data is void
+	template<class __traits_t, class __tag_t>
+	struct alignas(__traits_t::align) tree_node_linked_t<__traits_t, __tag_t, void> {
+		using tag_t = __tag_t;
+		using traits_t = __traits_t;
+		using data_t = traits_data_t<traits_t>;
+		using tagged_node_t = tagged_ptr_t<tree_node_linked_t, traits_t::bits>;
+
+		tagged_node_t parent;
+		tree_node_linked_t* left;
+		tree_node_linked_t* right;
+		tree_node_linked_t* prev;
+		tree_node_linked_t* next;
+	};
+
+	template<class traits_t, class tag_t>
+	inline node_color_t get_color(tree_node_linked_t<traits_t, tag_t>* node) {
+		return (node_color_t)node->parent.get_data();
+	}
+
+	template<class traits_t, class tag_t>
+	inline void set_color(tree_node_linked_t<traits_t, tag_t>* node, node_color_t color) {
+		node->parent.set_data((std::uintptr_t)color);
+	}
+
+	namespace impl {
+		template<class traits_t, class tag_t>
+		auto tree_node_linked_test(const tree_node_linked_t<traits_t, tag_t>*) -> std::true_type;
+
+		auto tree_node_linked_test(const void*) -> std::false_type;
+
+		template<class node_t>
+		struct is_tree_node_linked_t : decltype(tree_node_linked_test(std::declval<node_t*>())) {};
+	}
+
+	template<class node_t>
+	inline constexpr bool is_tree_node_linked_v =
+		impl::is_tree_node_linked_t<std::remove_volatile_t<std::remove_pointer_t<node_t>>>::value;
+
+	template<class node_t, class alloc_t, class ... args_t>
+	inline auto alloc_node(alloc_t alloc, args_t&& ... args) -> std::enable_if_t<is_tree_node_linked_v<node_t>, node_t*> {
+		return alloc(nullptr, nullptr, nullptr, nullptr, nullptr, std::forward<args_t>(args)...);
+	}
+
+	// compact node declaration
+	// links are 32-bit offsets relative to the base of the region of the node (region_ptr_t), color is packed into parent
+	// so node takes 12 bytes (linked one 20 bytes) and descriptor with its data fits into half of the cache line
+	// all nodes of one tree must be within one region aligned by its size (2^region_bits)
+	template<class __data_t, std::size_t __region_bits, std::size_t __align = 1, std::size_t __bits = 1>
+	struct tree_node_compact_traits_t {
+		static constexpr std::size_t region_bits = __region_bits;
+		static constexpr std::size_t bits = __bits;
+		static constexpr std::size_t align = std::max(alignof(std::uint32_t), std::max(__align, (std::size_t)1 << __bits));
+		using data_t = __data_t;
+	};
+
+	// primary template
+	template<class __traits_t, class __tag_t = default_node_tag_t, class = traits_data_t<__traits_t>>
+	struct alignas(__traits_t::align) tree_node_compact_t {
+		using tag_t = __tag_t;
+		using traits_t = __traits_t;
+		using data_t = traits_data_t<traits_t>;
+		using tagged_node_t = region_ptr_t<tree_node_compact_t, traits_t::region_bits, traits_t::bits>;
+		using link_t = region_ptr_t<tree_node_compact_t, traits_t::region_bits>;
+
+		tagged_node_t parent;
+		link_t left;
+		link_t right;
+		data_t data;
+	};
+
+	// specialization if data is void
+	template<class __traits_t, class __tag_t>
+	struct alignas(__traits_t::align) tree_node_compact_t<__traits_t, __tag_t, void> {
+		using tag_t = __tag_t;
+		using traits_t = __traits_t;
+		using data_t = traits_data_t<traits_t>;
+		using tagged_node_t = region_ptr_t<tree_node_compact_t, traits_t::region_bits, traits_t::bits>;
+		using link_t = region_ptr_t<tree_node_compact_t, traits_t::region_bits>;
+
+		tagged_node_t parent;
+		link_t left;
+		link_t right;
+	};
+
+	// compact node that additionally keeps its in-order neighbours (as tree_node_linked_t)
+	template<class __traits_t, class __tag_t = default_node_tag_t, class = traits_data_t<__traits_t>>
+	struct alignas(__traits_t::align) tree_node_compact_linked_t {
+		using tag_t = __tag_t;
+		using traits_t = __traits_t;
+		using data_t = traits_data_t<traits_t>;
+		using tagged_node_t = region_ptr_t<tree_node_compact_linked_t, traits_t::region_bits, traits_t::bits>;
+		using link_t = region_ptr_t<tree_node_compact_linked_t, traits_t::region_bits>;
+
+		tagged_node_t parent;
+		link_t left;
+		link_t right;
+		link_t prev;
+		link_t next;
+		data_t data;
+	};
+
+	// specialization if data is void
+	template<class __traits_t, class __tag_t>
+	struct alignas(__traits_t::align) tree_node_compact_linked_t<__traits_t, __tag_t, void> {
+		using tag_t = __tag_t;
+		using traits_t = __traits_t;
+		using data_t = traits_data_t<traits_t>;
+		using tagged_node_t = region_ptr_t<tree_node_compact_linked_t, traits_t::region_bits, traits_t::bits>;
+		using link_t = region_ptr_t<tree_node_compact_linked_t, traits_t::region_bits>;
+
+		tagged_node_t parent;
+		link_t left;
+		link_t right;
+		link_t prev;
+		link_t next;
+	};
+
+	template<class traits_t, class tag_t>
+	inline node_color_t get_color(tree_node_compact_t<traits_t, tag_t>* node) {
+		return (node_color_t)node->parent.get_data();
+	}
+
+	template<class traits_t, class tag_t>
+	inline node_color_t get_color(tree_node_compact_linked_t<traits_t, tag_t>* node) {
+		return (node_color_t)node->parent.get_data();
+	}
+
+	// links are passed by reference as they are valid only within their region
+	template<class type_t, std::size_t region_bits, std::size_t bits>
+	inline node_color_t get_color(const region_ptr_t<type_t, region_bits, bits>& node) {
+		return get_color(node.get_ptr());
+	}
+
+	template<class traits_t, class tag_t>
+	inline void set_color(tree_node_compact_t<traits_t, tag_t>* node, node_color_t color) {
+		node->parent.set_data((std::uint32_t)color);
+	}
+
+	template<class traits_t, class tag_t>
+	inline void set_color(tree_node_compact_linked_t<traits_t, tag_t>* node, node_color_t color) {
+		node->parent.set_data((std::uint32_t)color);
+	}
+
+	template<class type_t, std::size_t region_bits, std::size_t bits>
+	inline void set_color(const region_ptr_t<type_t, region_bits, bits>& node, node_color_t color) {
+		set_color(node.get_ptr(), color);
+	}
+
+	namespace impl {
+		template<class traits_t, class tag_t>
+		auto tree_node_compact_test(const tree_node_compact_t<traits_t, tag_t>*) -> std::true_type;
+
+		auto tree_node_compact_test(const void*) -> std::false_type;
+
+		template<class node_t>
+		struct is_tree_node_compact_t : decltype(tree_node_compact_test(std::declval<node_t*>())) {};
+
+		template<class traits_t, class tag_t>
+		auto tree_node_compact_linked_test(const tree_node_compact_linked_t<traits_t, tag_t>*) -> std::true_type;
+
+		auto tree_node_compact_linked_test(const void*) -> std::false_type;
+
+		template<class node_t>
+		struct is_tree_node_compact_linked_t : decltype(tree_node_compact_linked_test(std::declval<node_t*>())) {};
+	}
+
+	template<class node_t>
+	inline constexpr bool is_tree_node_compact_v =
+		impl::is_tree_node_compact_t<std::remove_volatile_t<std::remove_pointer_t<node_t>>>::value;
+
+	template<class node_t>
+	inline constexpr bool is_tree_node_compact_linked_v =
+		impl::is_tree_node_compact_linked_t<std::remove_volatile_t<std::remove_pointer_t<node_t>>>::value;
+
+	template<class node_t, class alloc_t, class ... args_t>
+	inline auto alloc_node(alloc_t alloc, args_t&& ... args) -> std::enable_if_t<is_tree_node_compact_v<node_t>, node_t*> {
+		return alloc(nullptr, nullptr, nullptr, std::forward<args_t>(args)...);
+	}
+
+	template<class node_t, class alloc_t, class ... args_t>
+	inline auto alloc_node(alloc_t alloc, args_t&& ... args) -> std::enable_if_t<is_tree_node_compact_linked_v<node_t>, node_t*> {
+		return alloc(nullptr, nullptr, nullptr, nullptr, nullptr, std::forward<args_t>(args)...);
+	}
+
 	// simple node declaration
 	template<class __data_t>
 	struct tree_node_traits_t {
@@ -237,6 +237,94 @@ namespace {
 			return nullptr;
 		}
 
+		// reserved range is just an allocation aligned by alignment (at least by page_size)
+		[[nodiscard]] void* reserve(std::size_t size, std::size_t alignment) {
+			size = mem::align_value(size, page_size);
+			alignment = std::max(alignment, page_size);
+
+			std::cout << "reserving range of size " << size << " aligned by " << alignment << std::endl;
+			for (auto i = ranges.begin(), e = ranges.end(); i != e; ++i) {
+				auto range = *i;
+				auto start = mem::align_value((std::uintptr_t)range.ptr, alignment);
+				std::size_t head_size = start - (std::uintptr_t)range.ptr;
+				if (range.size >= head_size + size) {
+					ranges.erase(i);
+					if (head_size > 0) {
+						ranges.insert(range_t{range.base_ptr, range.ptr, head_size});
+					} if (range.size > head_size + size) {
+						ranges.insert(range_t{range.base_ptr, (char*)start + size, range.size - head_size - size});
+					}
+					std::cout << "reserved memory: " << (void*)start << std::endl << std::endl;
+					return (void*)start;
+				}
+			}
+
+			std::cout << "failed to reserve range of size " << size << std::endl << std::endl;
+			return nullptr;
+		}
+
+		[[nodiscard]] bool commit(void* ptr, std::size_t size) {
+			range_t range{nullptr, ptr, size};
+			std::cout << "commiting range: " << range << std::endl;
+			for (auto& free_range : ranges) {
+				if (free_range.get_start() < range.get_end() && range.get_start() < free_range.get_end()) {
+					std::cerr << "commited range overlaps unallocated range " << free_range << std::endl;
+					std::abort();
+				}
+			}
+
+			committed_size += size;
+			return true;
+		}
+
+		void uncommit(void* ptr, std::size_t size) {
+			std::cout << "uncommiting range: " << range_t{nullptr, ptr, size} << std::endl;
+			assert(committed_size >= size);
+			std::memset(ptr, 0xDC, size);
+			committed_size -= size;
+		}
+
+		// decommitted memory must be allocated, its contents are lost
+		void decommit(void* ptr, std::size_t size) {
+			range_t range{nullptr, ptr, size};
+			std::cout << "decommiting range: " << range << std::endl;
+			if (!mem::is_aligned(ptr, page_size) || !mem::is_aligned(size, page_size)) {
+				std::cerr << "decommited range is not aligned" << std::endl;
+				std::abort();
+			}
+
+			for (auto& free_range : ranges) {
+				if (free_range.get_start() < range.get_end() && range.get_start() < free_range.get_end()) {
+					std::cerr << "decommited range overlaps unallocated range " << free_range << std::endl;
+					std::abort();
+				}
+			}
+
+			std::memset(ptr, 0xDC, size);
+			decommitted_size += size;
+		}
+
+		// prefaulted memory must be allocated, its contents are kept
+		void prefault(void* ptr, std::size_t size) {
+			range_t range{nullptr, ptr, size};
+			std::cout << "prefaulting range: " << range << std::endl;
+			for (auto& free_range : ranges) {
+				if (free_range.get_start() < range.get_end() && range.get_start() < free_range.get_end()) {
+					std::cerr << "prefaulted range overlaps unallocated range " << free_range << std::endl;
+					std::abort();
+				}
+			}
+			prefaulted_size += size;
+		}
+
+		bool get_prefault_mode() const {
+			return prefault_mode;
+		}
+
+		void set_prefault_mode(bool mode) {
+			prefault_mode = mode;
+		}
+
 	public:
 		[[nodiscard]] void* allocate_hint(void* hint, std::size_t size) {
 			hint = mem::align_value(hint, page_size);
@@ -327,10 +415,26 @@ namespace {
 			return page_size;
 		}
 
+		std::size_t get_decommitted_size() const {
+			return decommitted_size;
+		}
+
+		std::size_t get_committed_size() const {
+			return committed_size;
+		}
+
+		std::size_t get_prefaulted_size() const {
+			return prefaulted_size;
+		}
+
 	private:
 		range_set_t alloc_ranges{};
 		range_set_t ranges;
 		std::size_t page_size{};
+		std::size_t decommitted_size{};
+		std::size_t committed_size{};
+		std::size_t prefaulted_size{};
+		bool prefault_mode{};
 	};
 
 	struct alloc_request_t {
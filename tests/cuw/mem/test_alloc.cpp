@@ -1,6 +1,7 @@
 #include <random>
 #include <vector>
 #include <chrono>
+#include <thread>
 
 #include <cuw/mem/cuwalot.hpp>
 
@@ -84,8 +85,75 @@ void test_cuw_alloc(int k) {
 	std::cout << std::endl;
 }
 
+// frees of the thread are handed over to the background thread in batches, the thread frees memory itself
+// when all batches are queued, everything is freed once the mode is turned off & the queue is drained
+int test_cuw_deferred_free(int k) {
+	constexpr int tail_count = 3; // partial batch handed over when the mode is turned off
+	constexpr ticks_t drain_timeout = 10'000'000;
+
+	std::size_t free_count = 0;
+
+	auto cuw_malloc_func = [](std::size_t size) {
+		return cuw::mem::malloc(size);
+	};
+	
+	auto cuw_free_func = [&](void* ptr, std::size_t) {
+		cuw::mem::free(ptr);
+		free_count++;
+	};
+
+	std::cout << "*** testing cuwalloc with deferred free ***" << std::endl;
+	cuw::mem::trim();
+	cuw::mem::stats_t baseline = cuw::mem::get_stats();
+
+	cuw::mem::set_deferred_free(true);
+	for (int i = 0; i < k; i++) {
+		test_random_stuff(false, cuw_malloc_func, cuw_free_func);
+	}
+
+	void* tail[tail_count] = {};
+	for (auto& ptr : tail) {
+		ptr = cuw_malloc_func(64);
+	} for (auto& ptr : tail) {
+		cuw_free_func(ptr, 64);
+	}
+	cuw::mem::set_deferred_free(false);
+
+	cuw::mem::stats_t stats = cuw::mem::get_stats();
+	for (ticks_t t0 = get_current_time(); stats.reclaimed_frees != stats.deferred_frees && get_current_time() - t0 < drain_timeout; ) {
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		stats = cuw::mem::get_stats();
+	}
+
+	std::size_t deferred = stats.deferred_frees - baseline.deferred_frees;
+	std::size_t direct = stats.direct_frees - baseline.direct_frees;
+	std::cout << "deferred: " << deferred << " direct: " << direct << std::endl;
+	if (deferred == 0) {
+		std::cerr << "frees were not deferred" << std::endl;
+		return -1;
+	} if (direct == 0) {
+		std::cerr << "queue was never full" << std::endl;
+		return -1;
+	} if (deferred + direct != free_count) {
+		std::cerr << "frees were lost: " << deferred + direct << " of " << free_count << std::endl;
+		return -1;
+	} if (stats.reclaimed_frees != stats.deferred_frees) {
+		std::cerr << "queue was not drained" << std::endl;
+		return -1;
+	}
+
+	cuw::mem::trim();
+	if (std::size_t sysmem_size = cuw::mem::get_stats().sysmem_size; sysmem_size > baseline.sysmem_size) {
+		std::cerr << "memory was not freed: " << sysmem_size << " of " << baseline.sysmem_size << std::endl;
+		return -1;
+	}
+
+	std::cout << std::endl;
+	return 0;
+}
+
 int main() {
 	test_std_alloc(7);
 	test_cuw_alloc(7);
- 	return 0;
+	return test_cuw_deferred_free(3);
 }
\ No newline at end of file
@@ -152,8 +152,45 @@ namespace {
 
 		return 0;
 	}
+
+	// free blocks are handed out in address order
+	int test_block_order() {
+		constexpr std::size_t mem_pool_blocks = 200; // more than one map word
+		constexpr std::size_t mem_pool_size = mem::block_align * (mem_pool_blocks + 1);
+
+		mem::block_pool_entry_t entry;
+
+		alignas(mem::block_align) static char block_data[mem_pool_size] = {};
+		entry.create_pool(block_data, mem_pool_size);
+		for (std::size_t i = 0; i < mem_pool_blocks; i++) {
+			if (auto [block, offset] = entry.acquire(); !block || offset != i) {
+				std::abort();
+			}
+		}
+
+		std::size_t released[] = {150, 7, 70, 3, 199};
+		for (std::size_t index : released) {
+			auto [block, offset] = get_block_alloc(block_data, index);
+			entry.release(block, offset);
+		}
+
+		std::sort(std::begin(released), std::end(released));
+		for (std::size_t index : released) {
+			if (auto [block, offset] = entry.acquire(); !block || offset != index || block != std::get<0>(get_block_alloc(block_data, index))) {
+				std::abort();
+			}
+		}
+		if (auto [block, offset] = entry.acquire(); block) {
+			std::abort();
+		}
+
+		return 0;
+	}
 }
 
 int main(int argc, char* argv[]) {
-	return test_block_pool();
+	if (test_block_pool()) {
+		return -1;
+	}
+	return test_block_order();
 }
\ No newline at end of file
@@ -15,6 +15,8 @@ namespace {
 		static constexpr std::size_t alloc_cache_slots = 4;
 		static constexpr std::size_t alloc_min_slot_size = 1;
 		static constexpr std::size_t alloc_max_slot_size = 256;
+		static constexpr std::size_t alloc_large_cache_slots = 2;
+		static constexpr std::size_t alloc_large_cache_size = 2048;
 
 		static_assert(std::has_single_bit(alloc_min_slot_size));
 		static_assert(std::has_single_bit(alloc_max_slot_size));
@@ -63,6 +65,116 @@ namespace {
 		}
 	}
 
+	int test_cached_bins() {
+		constexpr std::size_t max_slot_size = test_cached_alloc_t::alloc_max_slot_size;
+		constexpr std::size_t total_slots = test_cached_alloc_t::alloc_cache_slots;
+
+		test_cached_alloc_t alloc(test_traits_t::alloc_max_cache_size, 1);
+
+		// same-sized blocks are reused in LIFO order
+		void* a = alloc.allocate(64);
+		void* b = alloc.allocate(64);
+		alloc.deallocate(a, 64);
+		alloc.deallocate(b, 64);
+		if (alloc.allocate(64) != b || alloc.allocate(64) != a) {
+			std::cerr << "cached blocks were not reused in LIFO order" << std::endl;
+			return -1;
+		}
+		alloc.deallocate(a, 64);
+		alloc.deallocate(b, 64);
+
+		// bigger block is split and the rest goes back into the cache
+		alloc.flush_slots();
+		void* c = alloc.allocate(128);
+		alloc.deallocate(c, 128);
+		if (alloc.allocate(32) != c || alloc.get_cached_size() != 96) {
+			std::cerr << "cached block was not split" << std::endl;
+			return -1;
+		}
+		alloc.deallocate(c, 32);
+		alloc.flush_slots();
+
+		// any-allocation takes the whole cached block
+		void* d = alloc.allocate(max_slot_size);
+		alloc.deallocate(d, max_slot_size);
+		if (auto [ptr, size] = alloc.allocate_ext(16, mem::cached_alloc_flags_t::Any); ptr != d || size != max_slot_size) {
+			std::cerr << "any-allocation did not return whole cached block" << std::endl;
+			return -1;
+		}
+		alloc.deallocate(d, max_slot_size);
+
+		// cache never exceeds its budget
+		chunk_t chunks[total_slots + 1];
+		for (auto& chunk : chunks) {
+			chunk = {alloc.allocate(max_slot_size / 2), max_slot_size / 2};
+		}
+		for (auto& chunk : chunks) {
+			alloc.deallocate(chunk.ptr, chunk.size);
+		}
+		if (alloc.get_cached_size() > test_cached_alloc_t::alloc_max_cache_size) {
+			std::cerr << "cache budget exceeded" << std::endl;
+			return -1;
+		}
+		alloc.flush_slots();
+
+		return 0;
+	}
+
+	int test_large_cache() {
+		constexpr std::size_t max_large_cache_size = test_cached_alloc_t::alloc_large_cache_size;
+
+		test_cached_alloc_t alloc(4 * max_large_cache_size, 1);
+
+		// big block is reused only with exact size
+		void* a = alloc.allocate(1024);
+		alloc.deallocate(a, 1024);
+		if (alloc.get_large_cached_size() != 1024 || alloc.get_cached_size() != 0) {
+			std::cerr << "big block was not cached" << std::endl;
+			return -1;
+		} if (void* b = alloc.allocate(512); b == a) {
+			std::cerr << "big block of another size was reused" << std::endl;
+			return -1;
+		} else {
+			alloc.deallocate(b, 512);
+		} if (alloc.allocate(1024) != a || alloc.get_large_cached_size() != 512) {
+			std::cerr << "big block was not reused" << std::endl;
+			return -1;
+		}
+		alloc.deallocate(a, 1024);
+
+		// least recently freed block is evicted when there is no free slot or budget is exceeded
+		void* c = alloc.allocate(768);
+		alloc.deallocate(c, 768); // 512 is evicted
+		if (alloc.get_large_cached_size() != 1024 + 768) {
+			std::cerr << "least recently freed block was not evicted" << std::endl;
+			return -1;
+		}
+		void* d = alloc.allocate(max_large_cache_size);
+		alloc.deallocate(d, max_large_cache_size);
+		if (alloc.get_large_cached_size() != max_large_cache_size || alloc.allocate(max_large_cache_size) != d) {
+			std::cerr << "large cache budget was exceeded" << std::endl;
+			return -1;
+		}
+		alloc.deallocate(d, max_large_cache_size);
+
+		// blocks are returned after decay time
+		alloc.set_large_cache_decay_time(0);
+		void* e = alloc.allocate(1024);
+		alloc.deallocate(e, 1024);
+		if (alloc.get_large_cached_size() != 1024) {
+			std::cerr << "decayed blocks were not evicted" << std::endl;
+			return -1;
+		}
+
+		alloc.flush_slots();
+		if (alloc.get_large_cached_size() != 0) {
+			std::cerr << "large cache was not flushed" << std::endl;
+			return -1;
+		}
+
+		return 0;
+	}
+
 	int test_cached_alloc() {
 		test_cached_alloc_t alloc(test_traits_t::alloc_max_cache_size, 1);
 
@@ -80,5 +192,11 @@ namespace {
 }
 
 int main(int argc, char* argv[]) {
+	if (test_cached_bins()) {
+		return -1;
+	}
+	if (test_large_cache()) {
+		return -1;
+	}
 	return test_cached_alloc();
 }
\ No newline at end of file
@@ -0,0 +1,245 @@
+#include <mutex>
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <iostream>
+
+#include <cuw/mem/cpu_cache.hpp>
+
+#include "utils.hpp"
+
+using namespace cuw;
+
+namespace {
+	inline constexpr std::size_t cache_depth = 8;
+	inline constexpr std::size_t cache_pools = 2;
+
+	using cpu_cache_t = mem::cpu_cache_t<cache_depth, cache_pools>;
+
+	// chunks are taken from & returned into an array, calls are counted
+	struct backend_t {
+		static constexpr std::size_t chunk_count = 64;
+
+		std::size_t refill(std::size_t index, void** ptrs, std::size_t count) {
+			std::unique_lock guard{lock};
+			refills++;
+			std::size_t refilled = 0;
+			for (std::size_t i = 0; i < chunk_count && refilled < count && !failing; i++) {
+				if (!used[i]) {
+					used[i] = true;
+					ptrs[refilled++] = &chunks[i];
+				}
+			} return refilled;
+		}
+
+		void flush(std::size_t index, void* const* ptrs, std::size_t count) {
+			std::unique_lock guard{lock};
+			flushes++;
+			for (std::size_t i = 0; i < count; i++) {
+				std::size_t chunk = (int*)ptrs[i] - chunks;
+				if (chunk >= chunk_count || !used[chunk]) {
+					std::abort(); // not a chunk of the backend or freed twice
+				}
+				used[chunk] = false;
+			}
+		}
+
+		std::size_t get_used() {
+			std::unique_lock guard{lock};
+			return std::count(used, used + chunk_count, true);
+		}
+
+		std::mutex lock{};
+		int chunks[chunk_count] = {};
+		bool used[chunk_count] = {};
+		std::size_t refills{};
+		std::size_t flushes{};
+		bool failing{};
+	};
+
+	template<class backend_t>
+	auto get_refill_func(backend_t& backend) {
+		return [&] (std::size_t index, void** ptrs, std::size_t count) { return backend.refill(index, ptrs, count); };
+	}
+
+	template<class backend_t>
+	auto get_flush_func(backend_t& backend) {
+		return [&] (std::size_t index, void* const* ptrs, std::size_t count) { backend.flush(index, ptrs, count); };
+	}
+
+	// empty stack is refilled with a batch, full stack is flushed down to half of its depth, stacks are LIFO
+	int test_cpu_cache() {
+		std::cout << "testing cpu cache..." << std::endl;
+
+		backend_t backend;
+		cpu_cache_t cache;
+
+		auto refill = get_refill_func(backend);
+		auto flush = get_flush_func(backend);
+
+		void* ptrs[cache_depth + 1] = {};
+		for (auto& ptr : ptrs) {
+			if (!(ptr = cache.pop(0, refill, flush))) {
+				std::cerr << "failed to allocate memory" << std::endl;
+				return -1;
+			}
+		} if (backend.refills != 3 || backend.get_used() != 3 * cpu_cache_t::batch_size || cache.get_count(0) != 3 * cpu_cache_t::batch_size - cache_depth - 1) {
+			std::cerr << "unexpected refill: " << backend.refills << std::endl;
+			return -1;
+		} if (cache.get_count(1) != 0) {
+			std::cerr << "stacks are not separated" << std::endl;
+			return -1;
+		}
+
+		for (auto& ptr : ptrs) {
+			cache.push(0, ptr, flush);
+		} if (backend.flushes != 1 || cache.get_count(0) != cache_depth || backend.get_used() != 2 * cpu_cache_t::batch_size) {
+			std::cerr << "unexpected flush: " << backend.flushes << std::endl;
+			return -1;
+		}
+
+		void* ptr = cache.pop(0, refill, flush);
+		if (ptr != ptrs[cache_depth]) {
+			std::cerr << "stack is not LIFO" << std::endl;
+			return -1;
+		}
+
+		cache.push(1, ptr, flush);
+		cache.flush(flush);
+		if (cache.get_count(0) != 0 || cache.get_count(1) != 0 || backend.get_used() != 0) {
+			std::cerr << "cache was not flushed" << std::endl;
+			return -1;
+		}
+
+		backend.failing = true;
+		if (cache.pop(0, refill, flush)) {
+			std::cerr << "refill did not fail" << std::endl;
+			return -1;
+		}
+
+		std::cout << "testing finished" << std::endl;
+		return 0;
+	}
+
+	// refill & flush are called without the spin lock so they can reenter the cache (as another thread on the CPU would)
+	// chunks that do not fit after the refill are flushed
+	int test_cpu_cache_reentry() {
+		std::cout << "testing cpu cache reentry..." << std::endl;
+
+		backend_t backend;
+		cpu_cache_t cache;
+
+		auto flush = get_flush_func(backend);
+		auto refill = [&] (std::size_t index, void** ptrs, std::size_t count) {
+			void* ptr = nullptr;
+			for (std::size_t i = 0; i < cache_depth; i++) {
+				if (backend.refill(index, &ptr, 1) != 1) {
+					std::abort();
+				}
+				cache.push(index, ptr, flush);
+			}
+			return backend.refill(index, ptrs, count);
+		};
+
+		void* ptr = cache.pop(0, refill, flush);
+		if (!ptr) {
+			std::cerr << "failed to allocate memory" << std::endl;
+			return -1;
+		} if (cache.get_count(0) != cache_depth || backend.flushes != 1 || backend.get_used() != cache_depth + 1) {
+			std::cerr << "refilled chunks were not flushed: " << backend.get_used() << std::endl;
+			return -1;
+		}
+
+		auto nested_flush = [&] (std::size_t index, void* const* ptrs, std::size_t count) {
+			cache.flush(flush);
+			backend.flush(index, ptrs, count);
+		};
+
+		cache.push(0, ptr, nested_flush); // stack is full so some chunks are flushed
+		if (cache.get_count(0) != 0 || backend.get_used() != 0) {
+			std::cerr << "cache was not flushed" << std::endl;
+			return -1;
+		}
+
+		std::cout << "testing finished" << std::endl;
+		return 0;
+	}
+
+	// threads share two caches as if they migrated between CPUs, every chunk is owned by one thread at a time
+	int test_cpu_cache_threads() {
+		std::cout << "testing cpu cache with threads..." << std::endl;
+
+		constexpr int thread_count = 4;
+		constexpr int iterations = 20000;
+
+		backend_t backend;
+		cpu_cache_t caches[2];
+		std::atomic<int> owners[backend_t::chunk_count] = {};
+		std::atomic<bool> failed{};
+
+		auto run = [&] (int seed) {
+			auto refill = get_refill_func(backend);
+			auto flush = get_flush_func(backend);
+
+			int_gen_t gen(seed);
+			std::vector<std::pair<void*, std::size_t>> ptrs;
+			for (int i = 0; i < iterations; i++) {
+				cpu_cache_t& cache = caches[gen.gen(2)];
+				if (ptrs.size() < 4 && gen.gen(2)) {
+					std::size_t index = gen.gen(cache_pools);
+					if (void* ptr = cache.pop(index, refill, flush)) {
+						if (owners[(int*)ptr - backend.chunks].fetch_add(1) != 0) {
+							failed = true;
+						}
+						ptrs.push_back({ptr, index});
+					}
+				} else if (!ptrs.empty()) {
+					auto [ptr, index] = ptrs.back();
+					ptrs.pop_back();
+					owners[(int*)ptr - backend.chunks].fetch_sub(1);
+					cache.push(index, ptr, flush);
+				}
+			}
+			for (auto [ptr, index] : ptrs) {
+				owners[(int*)ptr - backend.chunks].fetch_sub(1);
+				caches[0].push(index, ptr, flush);
+			}
+		};
+
+		std::vector<std::thread> threads;
+		for (int i = 0; i < thread_count; i++) {
+			threads.emplace_back(run, 42 + i);
+		} for (auto& thread : threads) {
+			thread.join();
+		}
+
+		for (auto& cache : caches) {
+			cache.flush(get_flush_func(backend));
+		} if (failed || backend.get_used() != 0) {
+			std::cerr << "chunk was shared or lost" << std::endl;
+			return -1;
+		}
+
+		std::cout << "testing finished" << std::endl;
+		return 0;
+	}
+}
+
+int main() {
+	if (test_cpu_cache()) {
+		return -1;
+	}
+	std::cout << std::endl;
+
+	if (test_cpu_cache_reentry()) {
+		return -1;
+	}
+	std::cout << std::endl;
+
+	if (test_cpu_cache_threads()) {
+		return -1;
+	}
+	std::cout << std::endl;
+
+	return 0;
+}
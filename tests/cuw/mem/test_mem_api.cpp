@@ -17,6 +17,26 @@ namespace {
 			return 1;
 		}
 		std::cout << "page size: " << mem_info.page_size << std::endl;
+		std::cout << "huge page size: " << mem_info.huge_page_size << std::endl;
+		std::cout << "test passed" << std::endl;
+		std::cout << std::endl;
+		return 0;
+	}
+
+	int test_cpu_info() {
+		auto [cpu_count, count_status] = mem::get_cpu_count();
+		if (count_status || cpu_count <= 0) {
+			std::cerr << "failed to obtain cpu count" << std::endl;
+			return 1;
+		}
+		std::cout << "cpu count: " << cpu_count << std::endl;
+
+		// not supported on every platform
+		if (auto [cpu, status] = mem::get_current_cpu(); status == 0) {
+			std::cout << "current cpu: " << cpu << std::endl;
+		} else {
+			std::cout << "current cpu is unknown" << std::endl;
+		}
 		std::cout << "test passed" << std::endl;
 		std::cout << std::endl;
 		return 0;
@@ -66,6 +86,92 @@ namespace {
 		return 0;
 	}
 
+	int test_aligned_allocations() {
+		std::cout << "testing aligned allocations..." << std::endl;
+
+		auto [mem_info, status] = mem::get_sysmem_info();
+		if (status || mem_info.huge_page_size == 0) {
+			std::cout << "huge pages are not supported, skipping" << std::endl << std::endl;
+			return 0;
+		}
+
+		std::size_t alignment = mem_info.huge_page_size;
+		std::size_t alloc_size = 3 * alignment;
+		for (auto mode : {mem::huge_page_mode_t::None, mem::huge_page_mode_t::Transparent, mem::huge_page_mode_t::HugeTLB}) {
+			auto [ptr, status] = mem::allocate_sysmem_aligned(alloc_size, alignment, mode);
+			if (status) {
+				std::cerr << "failed to allocate system memory" << std::endl;
+				return 1;
+			}
+
+			std::cout << "mode " << (int)mode << ": " << print_range_t{ptr, alloc_size} << std::endl;
+			if ((std::uintptr_t)ptr % alignment != 0) {
+				std::cerr << "allocation is not aligned" << std::endl;
+				return 1;
+			}
+
+			std::memset(ptr, 0xFF, alloc_size);
+			if (mem::deallocate_sysmem(ptr, alloc_size)) {
+				std::cerr << "failed to deallocate system memory" << std::endl;
+				return 1;
+			}
+		}
+
+		std::cout << "testing finished" << std::endl;
+		std::cout << std::endl;
+		return 0;
+	}
+
+	int test_reserve_commit() {
+		std::cout << "testing reserve/commit..." << std::endl;
+
+		auto [mem_info, info_status] = mem::get_sysmem_info();
+		if (info_status) {
+			std::cerr << "failed to obtain sysmem info" << std::endl;
+			return 1;
+		}
+
+		std::size_t page_size = mem_info.page_size;
+		std::size_t reserve_size = (std::size_t)1 << 32; // 4G of address space, nothing is committed
+		auto [ptr, status] = mem::reserve_sysmem(reserve_size, page_size);
+		if (status) {
+			std::cerr << "failed to reserve address space" << std::endl;
+			return 1;
+		}
+		std::cout << "reserved: " << print_range_t{ptr, reserve_size} << std::endl;
+
+		std::size_t commit_size = 16 * page_size;
+		for (int i = 0; i < 4; i++) {
+			void* part = (char*)ptr + i * commit_size;
+			if (mem::commit_sysmem(part, commit_size, mem::huge_page_mode_t::None)) {
+				std::cerr << "failed to commit memory" << std::endl;
+				return 1;
+			}
+			std::memset(part, 0xFF, commit_size);
+		}
+
+		if (mem::decommit_sysmem(ptr, commit_size)) {
+			std::cerr << "failed to decommit memory" << std::endl;
+			return 1;
+		}
+		std::memset(ptr, 0xFF, commit_size); // still accessible
+
+		void* prefaulted = (char*)ptr + commit_size;
+		if (mem::prefault_sysmem(prefaulted, commit_size) || *(unsigned char*)prefaulted != 0xFF) {
+			std::cerr << "failed to prefault memory" << std::endl;
+			return 1;
+		}
+
+		if (mem::deallocate_sysmem(ptr, reserve_size)) {
+			std::cerr << "failed to release address space" << std::endl;
+			return 1;
+		}
+
+		std::cout << "testing finished" << std::endl;
+		std::cout << std::endl;
+		return 0;
+	}
+
 	int test_memory_allocations() {
 		std::cout << "testing memory allocations..." << std::endl;
 
@@ -117,6 +223,10 @@ int main(int argc, char* argv[]) {
 		return status;
 	}
 	
+	if (int status = test_cpu_info()) {
+		return status;
+	}
+
 	if (int status = test_alloc_free()) {
 		return status;
 	}
@@ -124,6 +234,14 @@ int main(int argc, char* argv[]) {
 	if (int status = test_memory_allocations()) {
 		return status;
 	}
+
+	if (int status = test_aligned_allocations()) {
+		return status;
+	}
+
+	if (int status = test_reserve_commit()) {
+		return status;
+	}
 	
 	return 0;
 }
\ No newline at end of file
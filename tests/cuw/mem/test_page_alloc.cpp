@@ -1,5 +1,6 @@
 #include <random>
 #include <iomanip>
+#include <chrono>
 #include <iostream>
 
 #include <cuw/mem/page_alloc.hpp>
@@ -20,6 +21,9 @@ namespace {
 		static constexpr std::size_t alloc_block_pool_size = block_size_t{blocks_per_pool};
 		static constexpr std::size_t alloc_sysmem_pool_size = block_size_t{blocks_per_sysmem_pool};
 		static constexpr std::size_t alloc_min_block_size = block_size_t{blocks_per_min_block};
+		static constexpr std::size_t alloc_max_block_size = block_size_t{blocks_per_min_block}; // fixed size regions
+		static constexpr std::size_t alloc_quick_list_pages = 0; // block layout is checked against the free block index
+		static constexpr bool use_region_retention = false; // free regions are unmapped immediately
 	};
 
 	template<std::size_t blocks_per_page, std::size_t blocks_per_pool, std::size_t blocks_per_sysmem_pool, std::size_t blocks_per_min_block>
@@ -28,6 +32,15 @@ namespace {
 	template<std::size_t blocks_per_page, std::size_t blocks_per_pool, std::size_t blocks_per_sysmem_pool, std::size_t blocks_per_min_block>
 	using basic_alloc_t = dummy_allocator_t<traits_t<blocks_per_page, blocks_per_pool, blocks_per_sysmem_pool, blocks_per_min_block>>;
 
+	template<class alloc_t>
+	std::size_t count_free_blocks(alloc_t& alloc) {
+		std::size_t count = 0;
+		for (auto node : alloc.get_addr_index()) {
+			++count;
+		}
+		return count;
+	}
+
 	// u - unallocated block
 	// s - smd pool
 	// f - fbd pool
@@ -259,6 +272,850 @@ namespace {
 		return os << print_range_t{allocation.ptr, allocation.size};
 	}
 
+	struct __decommit_traits_t : __traits_t<1, 4, 4, 64> {
+		static constexpr std::size_t alloc_decommit_threshold = block_size_t{8};
+		static constexpr std::int64_t alloc_decay_time_ms = 0;
+	};
+
+	int test_decommit() {
+		using page_alloc_t = mem::page_alloc_t<dummy_allocator_t<mem::page_alloc_traits_t<__decommit_traits_t>>>;
+
+		std::cout << "testing decommit" << std::endl;
+
+		page_alloc_t alloc(block_size_t{256}, block_size_t{1});
+
+		void* a = alloc.allocate(block_size_t{16});
+		void* b = alloc.allocate(block_size_t{16});
+		void* c = alloc.allocate(block_size_t{16});
+		if (alloc.get_dirty_size() != 0) {
+			std::cerr << "freshly mapped memory must be clean" << std::endl;
+			return -1;
+		}
+
+		// above the threshold: decommitted at once
+		alloc.deallocate(b, block_size_t{16});
+		if (alloc.get_decommitted_size() != block_size_t{16} || alloc.get_dirty_size() != 0) {
+			std::cerr << "free run was not decommitted" << std::endl;
+			return -1;
+		}
+
+		// coalesces with a clean block: only the freed part is decommitted
+		alloc.deallocate(a, block_size_t{16});
+		if (alloc.get_decommitted_size() != block_size_t{32} || alloc.get_dirty_size() != 0) {
+			std::cerr << "coalesced free run was not decommitted" << std::endl;
+			return -1;
+		}
+
+		// below the threshold: block stays dirty
+		void* d = alloc.allocate(block_size_t{2});
+		if (d != a) {
+			std::cerr << "lowest free run was not reused" << std::endl;
+			return -1;
+		}
+		alloc.deallocate(d, block_size_t{2});
+		if (alloc.get_decommitted_size() != block_size_t{32} || alloc.get_dirty_size() != block_size_t{2}) {
+			std::cerr << "small free run must not be decommitted" << std::endl;
+			return -1;
+		}
+
+		// whole region is free: it is unmapped, not decommitted
+		alloc.deallocate(c, block_size_t{16});
+		if (alloc.get_decommitted_size() != block_size_t{32} || alloc.get_dirty_size() != 0) {
+			std::cerr << "region was not released" << std::endl;
+			return -1;
+		}
+
+		std::cout << "testing decommit finished" << std::endl << std::endl;
+
+		return 0;
+	}
+
+	struct __decay_traits_t : __traits_t<1, 4, 4, 64> {
+		static constexpr std::int64_t alloc_decay_time_ms = 3200; // 100ms per epoch
+	};
+
+	int test_decay() {
+		using page_alloc_t = mem::page_alloc_t<dummy_allocator_t<mem::page_alloc_traits_t<__decay_traits_t>>>;
+
+		std::cout << "testing decay" << std::endl;
+
+		page_alloc_t alloc(block_size_t{256}, block_size_t{1});
+		alloc.set_decay_time(3200);
+
+		auto now = std::chrono::steady_clock::now().time_since_epoch();
+		std::uint64_t t0 = std::chrono::duration_cast<std::chrono::milliseconds>(now).count();
+
+		void* a = alloc.allocate(block_size_t{16});
+		void* b = alloc.allocate(block_size_t{16});
+		void* c = alloc.allocate(block_size_t{16});
+		void* d = alloc.allocate(block_size_t{16});
+
+		// freshly freed memory stays dirty
+		alloc.deallocate(a, block_size_t{16});
+		alloc.purge_decayed(t0 + 100);
+		alloc.purge_decayed(t0 + 400);
+		if (alloc.get_decommitted_size() != 0 || alloc.get_dirty_size() != block_size_t{16}) {
+			std::cerr << "fresh dirty memory was decommitted" << std::endl;
+			return -1;
+		}
+
+		// older block is decommitted first
+		alloc.deallocate(c, block_size_t{16});
+		alloc.purge_decayed(t0 + 2000);
+		if (alloc.get_decommitted_size() != block_size_t{16} || alloc.get_dirty_size() != block_size_t{16}) {
+			std::cerr << "old dirty memory was not decommitted" << std::endl;
+			return -1;
+		}
+
+		// everything is decommitted after decay time
+		alloc.purge_decayed(t0 + 6000);
+		if (alloc.get_decommitted_size() != block_size_t{32} || alloc.get_dirty_size() != 0) {
+			std::cerr << "dirty memory left after decay time" << std::endl;
+			return -1;
+		}
+
+		// decay is disabled
+		alloc.set_decay_time(-1);
+		alloc.deallocate(b, block_size_t{16});
+		alloc.purge_decayed(t0 + 100000);
+		if (alloc.get_decommitted_size() != block_size_t{32} || alloc.get_dirty_size() != block_size_t{16}) {
+			std::cerr << "dirty memory was decommitted with decay disabled" << std::endl;
+			return -1;
+		}
+
+		// immediate decommit purges everything at once (whole coalesced run is decommitted)
+		alloc.set_decay_time(0);
+		if (alloc.get_decommitted_size() != block_size_t{80} || alloc.get_dirty_size() != 0) {
+			std::cerr << "dirty memory left after switching to immediate decommit" << std::endl;
+			return -1;
+		}
+
+		alloc.deallocate(d, block_size_t{16});
+
+		std::cout << "testing decay finished" << std::endl << std::endl;
+
+		return 0;
+	}
+
+	// freshly freed memory coalesced with an old dirty run does not rejuvenate it
+	int test_decay_coalesce() {
+		using page_alloc_t = mem::page_alloc_t<dummy_allocator_t<mem::page_alloc_traits_t<__decay_traits_t>>>;
+
+		std::cout << "testing decay of coalesced blocks" << std::endl;
+
+		page_alloc_t alloc(block_size_t{256}, block_size_t{1});
+		alloc.set_decay_time(3200);
+
+		auto now = std::chrono::steady_clock::now().time_since_epoch();
+		std::uint64_t t0 = std::chrono::duration_cast<std::chrono::milliseconds>(now).count();
+
+		void* a = alloc.allocate(block_size_t{16});
+		void* b = alloc.allocate(block_size_t{1});
+		void* x = alloc.allocate(block_size_t{16});
+		void* c = alloc.allocate(block_size_t{16});
+
+		// a is aged, b is freed next to a together with c
+		alloc.deallocate(a, block_size_t{16});
+		alloc.purge_decayed(t0 + 1000);
+		alloc.deallocate(c, block_size_t{16});
+		alloc.deallocate(b, block_size_t{1});
+		if (alloc.get_decommitted_size() != 0 || alloc.get_dirty_size() != block_size_t{33}) {
+			std::cerr << "dirty memory was decommitted too early" << std::endl;
+			return -1;
+		}
+
+		// coalesced run keeps the age of a so it is decommitted before c
+		alloc.purge_decayed(t0 + 1900);
+		if (alloc.get_decommitted_size() != block_size_t{17} || alloc.get_dirty_size() != block_size_t{16}) {
+			std::cerr << "aged dirty run was not decommitted: " << alloc.get_decommitted_size() << std::endl;
+			return -1;
+		}
+
+		alloc.deallocate(x, block_size_t{16});
+
+		std::cout << "testing decay of coalesced blocks finished" << std::endl << std::endl;
+
+		return 0;
+	}
+
+	int test_reserve() {
+		using page_alloc_t = mem::page_alloc_t<basic_alloc_t<1, 4, 4, 16>>;
+
+		std::cout << "testing reserve" << std::endl;
+
+		page_alloc_t alloc(block_size_t{256}, block_size_t{1});
+		alloc.set_prefault_mode(true);
+
+		// region is mapped & prefaulted in advance
+		if (!alloc.reserve(block_size_t{32})) {
+			std::cerr << "failed to reserve memory" << std::endl;
+			return -1;
+		}
+		if (alloc.get_sysmem_size() != block_size_t{32} || alloc.get_prefaulted_size() != block_size_t{32} || count_free_blocks(alloc) != 1) {
+			std::cerr << "reserved memory is not mapped or prefaulted" << std::endl;
+			return -1;
+		}
+
+		// reserved memory is reused, clean memory is prefaulted again as it could have been decommitted
+		void* a = alloc.allocate(block_size_t{32});
+		if (alloc.get_sysmem_size() != block_size_t{32} || alloc.get_prefaulted_size() != block_size_t{64}) {
+			std::cerr << "reserved memory was not reused" << std::endl;
+			return -1;
+		}
+
+		// whole region is free but it is retained
+		alloc.deallocate(a, block_size_t{32});
+		if (alloc.get_sysmem_size() != block_size_t{32} || count_free_blocks(alloc) != 1) {
+			std::cerr << "reserved memory was released" << std::endl;
+			return -1;
+		}
+
+		alloc.release_mem();
+
+		std::cout << "testing reserve finished" << std::endl << std::endl;
+
+		return 0;
+	}
+
+	int test_trim() {
+		using page_alloc_t = mem::page_alloc_t<basic_alloc_t<1, 4, 4, 16>>;
+
+		std::cout << "testing trim" << std::endl;
+
+		page_alloc_t alloc(block_size_t{256}, block_size_t{1});
+
+		void* a = alloc.allocate(block_size_t{8});
+		void* b = alloc.allocate(block_size_t{8});
+		alloc.deallocate(a, block_size_t{8});
+
+		// dirty memory fits into keep size
+		if (alloc.trim(block_size_t{8}) != 0 || alloc.get_dirty_size() != block_size_t{8}) {
+			std::cerr << "kept dirty memory was released" << std::endl;
+			return -1;
+		}
+
+		// dirty run is decommitted
+		if (alloc.trim() != block_size_t{8} || alloc.get_dirty_size() != 0 || alloc.get_decommitted_size() != block_size_t{8}) {
+			std::cerr << "dirty memory was not decommitted" << std::endl;
+			return -1;
+		}
+
+		// reserved region is retained until trimmed
+		if (!alloc.reserve(block_size_t{16})) {
+			std::cerr << "failed to reserve memory" << std::endl;
+			return -1;
+		}
+		alloc.deallocate(b, block_size_t{8});
+		if (alloc.get_sysmem_size() != block_size_t{16}) {
+			std::cerr << "unexpected sysmem size" << std::endl;
+			return -1;
+		}
+		if (alloc.trim() < block_size_t{16} || alloc.get_sysmem_size() != 0 || count_free_blocks(alloc) != 0) {
+			std::cerr << "reserved region was not released" << std::endl;
+			return -1;
+		}
+
+		alloc.release_mem();
+
+		std::cout << "testing trim finished" << std::endl << std::endl;
+
+		return 0;
+	}
+
+	struct __quick_traits_t : __traits_t<1, 4, 4, 16> {
+		static constexpr std::size_t alloc_quick_list_pages = 4;
+		static constexpr std::size_t alloc_quick_list_depth = 2;
+	};
+
+	int test_quick_lists() {
+		using page_alloc_t = mem::page_alloc_t<dummy_allocator_t<mem::page_alloc_traits_t<__quick_traits_t>>>;
+
+		std::cout << "testing quick lists" << std::endl;
+
+		page_alloc_t alloc(block_size_t{256}, block_size_t{1});
+
+		void* a = alloc.allocate(block_size_t{2});
+		void* b = alloc.allocate(block_size_t{2});
+		void* c = alloc.allocate(block_size_t{2});
+		void* x = alloc.allocate(block_size_t{8});
+		std::size_t free_blocks = count_free_blocks(alloc);
+
+		// exact-size runs bypass the free block index & are reused in LIFO order
+		alloc.deallocate(a, block_size_t{2});
+		alloc.deallocate(b, block_size_t{2});
+		if (alloc.get_quick_list_size() != block_size_t{4} || count_free_blocks(alloc) != free_blocks) {
+			std::cerr << "runs were not put into quick list" << std::endl;
+			return -1;
+		} if (alloc.allocate(block_size_t{2}) != b) {
+			std::cerr << "quick list is not LIFO" << std::endl;
+			return -1;
+		}
+
+		// overflowing list is flushed & coalesced: a, b and c form one free run
+		alloc.deallocate(b, block_size_t{2});
+		alloc.deallocate(c, block_size_t{2});
+		if (alloc.get_quick_list_size() != block_size_t{2} || count_free_blocks(alloc) != free_blocks + 1) {
+			std::cerr << "quick list was not flushed" << std::endl;
+			return -1;
+		}
+
+		// too big for quick lists
+		alloc.deallocate(x, block_size_t{8});
+		if (alloc.get_quick_list_size() != block_size_t{2}) {
+			std::cerr << "big run was put into quick list" << std::endl;
+			return -1;
+		}
+
+		alloc.trim();
+		if (alloc.get_quick_list_size() != 0 || alloc.get_sysmem_size() != 0) {
+			std::cerr << "quick lists were not trimmed" << std::endl;
+			return -1;
+		}
+
+		alloc.release_mem();
+
+		std::cout << "testing quick lists finished" << std::endl << std::endl;
+
+		return 0;
+	}
+
+	struct __meta_traits_t : __traits_t<1, 4, 4, 16> {
+		static constexpr bool use_meta_region = true;
+		static constexpr std::size_t alloc_meta_reserve_size = block_size_t{32};
+		static constexpr std::size_t alloc_meta_commit_size = block_size_t{8};
+	};
+
+	int test_meta_region() {
+		using page_alloc_t = mem::page_alloc_t<dummy_allocator_t<mem::page_alloc_traits_t<__meta_traits_t>>>;
+
+		std::cout << "testing metadata region" << std::endl;
+
+		page_alloc_t alloc(block_size_t{256}, block_size_t{1});
+
+		// fragmented free memory requires several descriptor pools
+		std::vector<void*> allocations;
+		for (int i = 0; i < 16; i++) {
+			allocations.push_back(alloc.allocate(block_size_t{1}));
+		} for (int i = 0; i < 16; i += 2) {
+			alloc.deallocate(allocations[i], block_size_t{1});
+		}
+
+		if (count_free_blocks(alloc) != 8) {
+			std::cerr << "unexpected count of free blocks" << std::endl;
+			return -1;
+		} for (auto node : alloc.get_addr_index()) {
+			if (!alloc.is_meta_ptr(node)) {
+				std::cerr << "descriptor is not in the metadata region" << std::endl;
+				return -1;
+			}
+		}
+
+		// region is committed in big steps
+		std::size_t committed = alloc.get_committed_size();
+		if (committed == 0 || committed % block_size_t{8} != 0) {
+			std::cerr << "unexpected size of committed metadata" << std::endl;
+			return -1;
+		}
+
+		for (int i = 1; i < 16; i += 2) {
+			alloc.deallocate(allocations[i], block_size_t{1});
+		}
+
+		// all descriptor pools are empty so the whole region is uncommitted
+		if (alloc.trim() == 0 || alloc.get_committed_size() != 0) {
+			std::cerr << "metadata was not released by trim" << std::endl;
+			return -1;
+		}
+		alloc.release_mem();
+
+		std::cout << "testing metadata region finished" << std::endl << std::endl;
+
+		return 0;
+	}
+
+	int test_meta_region_trim() {
+		using sys_alloc_t = dummy_allocator_t<mem::page_alloc_traits_t<__meta_traits_t>>;
+
+		std::cout << "testing metadata region trim" << std::endl;
+
+		sys_alloc_t sys_alloc(block_size_t{256}, block_size_t{1});
+		mem::meta_region_t region;
+		region.init(block_size_t{2}, block_size_t{32}, block_size_t{8}, block_size_t{1}, block_size_t{1}, mem::huge_page_mode_t::None);
+
+		void* chunks[6] = {};
+		for (auto& chunk : chunks) {
+			chunk = region.allocate(sys_alloc, block_size_t{2});
+		} if (region.get_committed_size() != block_size_t{16}) {
+			std::cerr << "unexpected size of committed metadata" << std::endl;
+			return -1;
+		}
+
+		// run of chunks 1-2 is decommitted except its first page, tail chunk 5 is uncommitted with the rest of the commit step
+		region.deallocate(chunks[2]);
+		region.deallocate(chunks[5]);
+		region.deallocate(chunks[1]);
+		if (std::size_t released = region.trim(sys_alloc); released != block_size_t{6 + 3}) {
+			std::cerr << "unexpected size of released metadata: " << released << std::endl;
+			return -1;
+		} if (region.get_committed_size() != block_size_t{10} || sys_alloc.get_decommitted_size() != block_size_t{3}) {
+			std::cerr << "unexpected size of committed metadata" << std::endl;
+			return -1;
+		} if (region.trim(sys_alloc) != 0) {
+			std::cerr << "clean runs were decommitted again" << std::endl;
+			return -1;
+		}
+
+		// free runs are reused in address order, then the region grows again
+		if (region.allocate(sys_alloc, block_size_t{2}) != chunks[1] || region.allocate(sys_alloc, block_size_t{2}) != chunks[2]
+			|| region.allocate(sys_alloc, block_size_t{2}) != chunks[5]) {
+			std::cerr << "free chunks were not reused" << std::endl;
+			return -1;
+		}
+
+		region.release(sys_alloc);
+
+		std::cout << "testing metadata region trim finished" << std::endl << std::endl;
+
+		return 0;
+	}
+
+	// 4K pages: descriptors take 32-byte slots of the metadata region (64K) & are linked relatively to its base
+	struct __compact_traits_t : __traits_t<64, 64, 64, 1024> {
+		static constexpr bool use_meta_region = true;
+		static constexpr std::size_t alloc_meta_reserve_size = block_size_t{1024};
+		static constexpr std::size_t alloc_meta_commit_size = block_size_t{128};
+	};
+
+	int test_compact_descr() {
+		using page_alloc_t = mem::page_alloc_t<dummy_allocator_t<mem::page_alloc_traits_t<__compact_traits_t>>>;
+
+		static_assert(page_alloc_t::use_compact_descr && page_alloc_t::meta_region_bits == 16);
+		static_assert(sizeof(page_alloc_t::fbd_t) == 32 && sizeof(page_alloc_t::smd_t) == 32);
+
+		std::cout << "testing compact descriptors" << std::endl;
+
+		constexpr std::size_t page_size = block_size_t{64};
+		page_alloc_t alloc(page_size * 2048, page_size);
+
+		// fragmented free memory requires several descriptor pools (126 descriptors per pool)
+		std::vector<void*> allocations;
+		for (int i = 0; i < 256; i++) {
+			allocations.push_back(alloc.allocate(page_size));
+		} for (int i = 0; i < 256; i += 2) {
+			alloc.deallocate(allocations[i], page_size);
+		}
+
+		if (count_free_blocks(alloc) != 128) {
+			std::cerr << "unexpected count of free blocks" << std::endl;
+			return -1;
+		}
+
+		bool half_slots = false;
+		void* prev_end = nullptr;
+		for (auto node : alloc.get_addr_index()) {
+			auto* fbd = page_alloc_t::fbd_t::addr_index_to_descr(node);
+			if (!alloc.is_meta_ptr(fbd)) {
+				std::cerr << "descriptor is not in the metadata region" << std::endl;
+				return -1;
+			} if (fbd->get_size() != page_size || (std::uintptr_t)fbd->get_start() <= (std::uintptr_t)prev_end) {
+				std::cerr << "unexpected free block" << std::endl;
+				return -1;
+			}
+			half_slots |= !mem::is_aligned(fbd, mem::block_size);
+			prev_end = fbd->get_end();
+		} if (!half_slots) {
+			std::cerr << "descriptors do not take 32-byte slots" << std::endl;
+			return -1;
+		}
+
+		// regions are unmapped when they become free, their descriptors are released
+		for (int i = 1; i < 256; i += 2) {
+			alloc.deallocate(allocations[i], page_size);
+		} if (count_free_blocks(alloc) != 0 || alloc.get_sysmem_size() != 0) {
+			std::cerr << "free regions were not released" << std::endl;
+			return -1;
+		} if (alloc.trim() == 0 || alloc.get_committed_size() != 0) {
+			std::cerr << "metadata was not released by trim" << std::endl;
+			return -1;
+		}
+		alloc.release_mem();
+
+		std::cout << "testing compact descriptors finished" << std::endl << std::endl;
+
+		return 0;
+	}
+
+	struct __heap_traits_t : __traits_t<1, 4, 4, 16> {
+		static constexpr bool use_heap_reservation = true;
+		static constexpr std::size_t alloc_heap_reserve_size = block_size_t{64};
+	};
+
+	int test_heap_reservation() {
+		using page_alloc_t = mem::page_alloc_t<dummy_allocator_t<mem::page_alloc_traits_t<__heap_traits_t>>>;
+
+		std::cout << "testing heap reservation" << std::endl;
+
+		page_alloc_t alloc(block_size_t{256}, block_size_t{1});
+
+		// heap is extended by min_block_size, allocations are contiguous
+		void* prev = alloc.allocate(block_size_t{16});
+		for (int i = 1; i < 4; i++) {
+			void* curr = alloc.allocate(block_size_t{16});
+			if (curr != advance_ptr(prev, block_size_t{16})) {
+				std::cerr << "heap is not contiguous" << std::endl;
+				return -1;
+			} prev = curr;
+		}
+		if (alloc.get_heap_size() != block_size_t{64} || alloc.get_committed_size() != block_size_t{64}) {
+			std::cerr << "unexpected heap size" << std::endl;
+			return -1;
+		}
+
+		// heap is exhausted: falls back to a separate region
+		void* extra = alloc.allocate(block_size_t{16});
+		if (!extra || alloc.get_heap_size() != block_size_t{64}) {
+			std::cerr << "failed to fall back to a region" << std::endl;
+			return -1;
+		}
+		alloc.deallocate(extra, block_size_t{16});
+
+		// heap memory is kept after everything is freed
+		for (int i = 0; i < 4; i++) {
+			alloc.deallocate(advance_ptr(prev, -(std::ptrdiff_t)block_size_t{16} * i), block_size_t{16});
+		}
+		if (count_free_blocks(alloc) != 1) {
+			std::cerr << "heap free runs were not coalesced" << std::endl;
+			return -1;
+		}
+
+		alloc.release_mem();
+		if (alloc.get_ranges().size() != 1) {
+			std::cerr << "memory leaked" << std::endl;
+			return -1;
+		}
+
+		std::cout << "testing heap reservation finished" << std::endl << std::endl;
+
+		return 0;
+	}
+
+	struct __heap_adjacent_traits_t : __heap_traits_t {
+		static constexpr bool use_region_retention = true;
+	};
+
+	// region mapped right below the heap is released when a heap block coalesces with it
+	int test_heap_adjacent_region() {
+		using base_alloc_t = dummy_allocator_t<mem::page_alloc_traits_t<__heap_adjacent_traits_t>>;
+		using page_alloc_t = mem::page_alloc_t<base_alloc_t>;
+
+		std::cout << "testing region adjacent to the heap" << std::endl;
+
+		page_alloc_t alloc(block_size_t{256}, block_size_t{1});
+
+		// hole is left below the heap so the region falls back into it (its first pages are taken by the sysmem pool)
+		void* hole = ((base_alloc_t&)alloc).allocate(block_size_t{20});
+		void* heap[4] = {};
+		for (auto& ptr : heap) {
+			ptr = alloc.allocate(block_size_t{16});
+		}
+		((base_alloc_t&)alloc).deallocate(hole, block_size_t{20});
+		if (advance_ptr(hole, block_size_t{20}) != heap[0]) {
+			std::cerr << "heap does not follow the hole" << std::endl;
+			return -1;
+		}
+
+		// region is retained while the heap is in use
+		void* region = alloc.allocate(block_size_t{16});
+		if (advance_ptr(region, block_size_t{16}) != heap[0]) {
+			std::cerr << "region is not adjacent to the heap" << std::endl;
+			return -1;
+		}
+		alloc.deallocate(region, block_size_t{16});
+		if (alloc.get_sysmem_size() != block_size_t{80}) {
+			std::cerr << "free region was not retained" << std::endl;
+			return -1;
+		}
+
+		// first heap block coalesces across heap_start with the region, one growth step of free memory remains
+		alloc.deallocate(heap[0], block_size_t{16});
+		if (alloc.get_sysmem_size() != block_size_t{64} || count_free_blocks(alloc) != 1) {
+			std::cerr << "region below the heap was not released: " << alloc.get_sysmem_size() << std::endl;
+			return -1;
+		}
+		for (int i = 1; i < 4; i++) {
+			alloc.deallocate(heap[i], block_size_t{16});
+		}
+
+		alloc.release_mem();
+		if (alloc.get_ranges().size() != 1) {
+			std::cerr << "memory leaked" << std::endl;
+			return -1;
+		}
+
+		std::cout << "testing region adjacent to the heap finished" << std::endl << std::endl;
+
+		return 0;
+	}
+
+	struct __growth_traits_t : __traits_t<1, 4, 4, 8> {
+		static constexpr std::size_t alloc_max_block_size = block_size_t{32};
+	};
+
+	int test_growth() {
+		using page_alloc_t = mem::page_alloc_t<dummy_allocator_t<mem::page_alloc_traits_t<__growth_traits_t>>>;
+
+		std::cout << "testing growth" << std::endl;
+
+		page_alloc_t alloc(block_size_t{256}, block_size_t{1});
+
+		// each new region is as big as the heap: 8, 8, 16, 32, 32 blocks
+		std::size_t expected[] = {8, 16, 32, 32, 64, 64, 64, 64, 96};
+		std::vector<void*> allocations;
+		for (std::size_t blocks : expected) {
+			allocations.push_back(alloc.allocate(block_size_t{8}));
+			if (alloc.get_sysmem_size() != block_size_t{blocks}) {
+				std::cerr << "unexpected heap size: " << alloc.get_sysmem_size() << std::endl;
+				return -1;
+			}
+		}
+
+		for (void* ptr : allocations) {
+			alloc.deallocate(ptr, block_size_t{8});
+		}
+		if (alloc.get_sysmem_size() != 0) {
+			std::cerr << "regions were not released" << std::endl;
+			return -1;
+		}
+
+		std::cout << "testing growth finished" << std::endl << std::endl;
+
+		return 0;
+	}
+
+	struct __retention_traits_t : __traits_t<1, 4, 4, 8> {
+		static constexpr bool use_region_retention = true;
+		static constexpr std::size_t alloc_max_block_size = block_size_t{32};
+	};
+
+	int test_region_retention() {
+		using page_alloc_t = mem::page_alloc_t<dummy_allocator_t<mem::page_alloc_traits_t<__retention_traits_t>>>;
+
+		std::cout << "testing region retention" << std::endl;
+
+		page_alloc_t alloc(block_size_t{256}, block_size_t{1});
+
+		// the only region stays mapped when it becomes free & is reused
+		void* a = alloc.allocate(block_size_t{8});
+		alloc.deallocate(a, block_size_t{8});
+		if (alloc.get_sysmem_size() != block_size_t{8} || alloc.allocate(block_size_t{8}) != a) {
+			std::cerr << "free region was not retained" << std::endl;
+			return -1;
+		}
+
+		// second region is retained while the first one is in use, then one growth step of free memory is kept
+		void* b = alloc.allocate(block_size_t{8});
+		alloc.deallocate(b, block_size_t{8});
+		if (alloc.get_sysmem_size() != block_size_t{16}) {
+			std::cerr << "free region was not retained" << std::endl;
+			return -1;
+		}
+		alloc.deallocate(a, block_size_t{8});
+		if (alloc.get_sysmem_size() != block_size_t{8}) {
+			std::cerr << "unexpected heap size: " << alloc.get_sysmem_size() << std::endl;
+			return -1;
+		}
+
+		// trim ignores retention
+		alloc.trim();
+		if (alloc.get_sysmem_size() != 0) {
+			std::cerr << "regions were not released" << std::endl;
+			return -1;
+		}
+
+		std::cout << "testing region retention finished" << std::endl << std::endl;
+
+		return 0;
+	}
+
+	struct __heap_shrink_traits_t : __traits_t<1, 4, 4, 8> {
+		static constexpr bool use_heap_reservation = true;
+		static constexpr std::size_t alloc_heap_reserve_size = block_size_t{128};
+		static constexpr std::size_t alloc_max_block_size = block_size_t{32};
+	};
+
+	int test_heap_shrink() {
+		using page_alloc_t = mem::page_alloc_t<dummy_allocator_t<mem::page_alloc_traits_t<__heap_shrink_traits_t>>>;
+
+		std::cout << "testing heap shrink" << std::endl;
+
+		page_alloc_t alloc(block_size_t{256}, block_size_t{1});
+
+		// 8 + 8 + 16 + 32 blocks are committed
+		std::vector<void*> allocations;
+		for (int i = 0; i < 8; i++) {
+			allocations.push_back(alloc.allocate(block_size_t{8}));
+		}
+		if (alloc.get_heap_size() != block_size_t{64}) {
+			std::cerr << "unexpected heap size: " << alloc.get_heap_size() << std::endl;
+			return -1;
+		}
+
+		// only one growth step of the trailing free run stays committed
+		for (int i = 7; i >= 1; i--) {
+			alloc.deallocate(allocations[i], block_size_t{8});
+		}
+		if (alloc.get_heap_size() != block_size_t{16} || alloc.get_committed_size() != block_size_t{16}) {
+			std::cerr << "heap was not shrinked: " << alloc.get_heap_size() << std::endl;
+			return -1;
+		}
+
+		alloc.deallocate(allocations[0], block_size_t{8});
+		alloc.release_mem();
+		if (alloc.get_ranges().size() != 1) {
+			std::cerr << "memory leaked" << std::endl;
+			return -1;
+		}
+
+		std::cout << "testing heap shrink finished" << std::endl << std::endl;
+
+		return 0;
+	}
+
+	// executes queued system calls the way the caller of a deferred mode allocator does outside of a lock
+	// returns true if failed allocation can be retried
+	template<class alloc_t, class base_t>
+	bool run_sysmem_ops(alloc_t& alloc, base_t& base, std::size_t& count) {
+		mem::sysmem_op_t ops[mem::default_sysmem_queue_size];
+		count = alloc.take_sysmem_ops(ops);
+		for (std::size_t i = 0; i < count; i++) {
+			mem::sysmem_op_t& op = ops[i];
+			switch (op.type) {
+				case mem::sysmem_op_type_t::Decommit: base.decommit(op.ptr, op.size); break;
+				case mem::sysmem_op_type_t::Uncommit: base.uncommit(op.ptr, op.size); break;
+				case mem::sysmem_op_type_t::Map: op.ptr = base.allocate(op.size); break;
+				case mem::sysmem_op_type_t::Commit: op.ptr = base.commit(op.ptr, op.size) ? op.ptr : nullptr; break;
+			}
+			op.done = op.ptr != nullptr;
+		}
+		return alloc.finish_sysmem_ops(ops, count);
+	}
+
+	int test_deferred_sysmem_ops() {
+		using basic_alloc_t = dummy_allocator_t<mem::page_alloc_traits_t<__decommit_traits_t>>;
+		using page_alloc_t = mem::page_alloc_t<basic_alloc_t>;
+
+		std::cout << "testing deferred system calls" << std::endl;
+
+		page_alloc_t alloc(block_size_t{256}, block_size_t{1});
+		basic_alloc_t& base = alloc;
+		alloc.set_deferred_sysmem_ops(true);
+
+		// allocation fails until the region is mapped outside of the lock, then the spare region is used
+		std::size_t count = 0;
+		if (alloc.allocate(block_size_t{16}) || alloc.get_sysmem_size() != 0) {
+			std::cerr << "region was mapped under the lock" << std::endl;
+			return -1;
+		} if (!run_sysmem_ops(alloc, base, count) || count != 1) {
+			std::cerr << "map was not queued" << std::endl;
+			return -1;
+		}
+		void* a = alloc.allocate(block_size_t{16});
+		void* b = alloc.allocate(block_size_t{16});
+		void* c = alloc.allocate(block_size_t{16});
+		if (!a || !b || !c || alloc.get_sysmem_size() != block_size_t{64} || run_sysmem_ops(alloc, base, count) || count != 0) {
+			std::cerr << "spare region was not used" << std::endl;
+			return -1;
+		}
+
+		// decommitted run is not in the index until the call is finished so it cannot be reused meanwhile
+		alloc.deallocate(b, block_size_t{16});
+		void* d = alloc.allocate(block_size_t{16});
+		if (alloc.get_decommitted_size() != 0 || count_free_blocks(alloc) != 0 || d == b) {
+			std::cerr << "decommitted run was reused before the call was finished" << std::endl;
+			return -1;
+		}
+		alloc.deallocate(d, block_size_t{16});
+		if (run_sysmem_ops(alloc, base, count) || count != 2 || alloc.get_decommitted_size() != block_size_t{32}) {
+			std::cerr << "decommits were not queued" << std::endl;
+			return -1;
+		} if (count_free_blocks(alloc) != 2 || alloc.get_dirty_size() != 0 || alloc.allocate(block_size_t{16}) != b) {
+			std::cerr << "decommitted runs were not returned" << std::endl;
+			return -1;
+		}
+
+		alloc.deallocate(b, block_size_t{16});
+		alloc.deallocate(a, block_size_t{16});
+		alloc.deallocate(c, block_size_t{16});
+		(void)run_sysmem_ops(alloc, base, count);
+		if (alloc.get_sysmem_size() != 0) {
+			std::cerr << "region was not released" << std::endl;
+			return -1;
+		}
+
+		alloc.release_mem();
+		if (alloc.get_ranges().size() != 1) {
+			std::cerr << "memory leaked" << std::endl;
+			return -1;
+		}
+
+		std::cout << "testing deferred system calls finished" << std::endl << std::endl;
+
+		return 0;
+	}
+
+	int test_deferred_heap_ops() {
+		using basic_alloc_t = dummy_allocator_t<mem::page_alloc_traits_t<__heap_shrink_traits_t>>;
+		using page_alloc_t = mem::page_alloc_t<basic_alloc_t>;
+
+		std::cout << "testing deferred heap commit & uncommit" << std::endl;
+
+		page_alloc_t alloc(block_size_t{256}, block_size_t{1});
+		basic_alloc_t& base = alloc;
+		alloc.set_deferred_sysmem_ops(true);
+
+		// each growth step is committed outside of the lock
+		std::size_t count = 0;
+		std::vector<void*> allocations;
+		while (allocations.size() != 8) {
+			if (void* ptr = alloc.allocate(block_size_t{8})) {
+				allocations.push_back(ptr);
+			} else if (alloc.get_committed_size() != alloc.get_heap_size() || !run_sysmem_ops(alloc, base, count) || count != 1) {
+				std::cerr << "heap commit was not queued" << std::endl;
+				return -1;
+			}
+		}
+		if (alloc.get_heap_size() != block_size_t{64} || alloc.get_committed_size() != block_size_t{64}) {
+			std::cerr << "unexpected heap size: " << alloc.get_heap_size() << std::endl;
+			return -1;
+		}
+
+		// heap stays committed until the uncommit is finished
+		for (int i = 7; i >= 1; i--) {
+			alloc.deallocate(allocations[i], block_size_t{8});
+		}
+		if (alloc.get_heap_size() != block_size_t{64} || alloc.get_committed_size() != block_size_t{64}) {
+			std::cerr << "heap was uncommitted under the lock" << std::endl;
+			return -1;
+		}
+		(void)run_sysmem_ops(alloc, base, count);
+		if (count != 1 || alloc.get_heap_size() >= block_size_t{64} || alloc.get_committed_size() != alloc.get_heap_size()) {
+			std::cerr << "heap was not shrinked: " << alloc.get_heap_size() << std::endl;
+			return -1;
+		}
+
+		alloc.deallocate(allocations[0], block_size_t{8});
+		alloc.set_deferred_sysmem_ops(false);
+		alloc.release_mem();
+		if (alloc.get_ranges().size() != 1) {
+			std::cerr << "memory leaked" << std::endl;
+			return -1;
+		}
+
+		std::cout << "testing deferred heap commit & uncommit finished" << std::endl << std::endl;
+
+		return 0;
+	}
+
 	int test_random_stuff() {
 		std::cout << "testing by random allocations/dellocations..." << std::endl;
 
@@ -274,7 +1131,6 @@ namespace {
 
 		auto print_status = [&] () {
 			std::cout << "-addr_index" << std::endl << addr_index_info_t{alloc};
-			std::cout << "-size_index" << std::endl << size_index_info_t{alloc};
 			std::cout << "-ranges" << std::endl << ranges_info_t{alloc};
 		};
 
@@ -359,6 +1215,26 @@ int main(int argc, char* argv[]) {
 		return -1;
 	}
 	
+	if (test_decommit() || test_decay() || test_decay_coalesce()) {
+		return -1;
+	}
+
+	if (test_reserve() || test_trim() || test_quick_lists() || test_meta_region() || test_meta_region_trim() || test_compact_descr()) {
+		return -1;
+	}
+
+	if (test_heap_reservation() || test_heap_adjacent_region()) {
+		return -1;
+	}
+
+	if (test_growth() || test_region_retention() || test_heap_shrink()) {
+		return -1;
+	}
+
+	if (test_deferred_sysmem_ops() || test_deferred_heap_ops()) {
+		return -1;
+	}
+
 	if (test_random_stuff()) {
 		return -1;
 	}
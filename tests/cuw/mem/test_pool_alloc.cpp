@@ -31,7 +31,7 @@ namespace {
 	struct is_page_alloc_t : std::false_type {};
 
 	template<class alloc_t>
-	struct is_page_alloc_t<alloc_t, std::void_t<decltype(&alloc_t::get_size_index), decltype(&alloc_t::get_addr_index)>> : std::true_type {};
+	struct is_page_alloc_t<alloc_t, std::void_t<decltype(&alloc_t::get_addr_index)>> : std::true_type {};
 
 	template<class alloc_t>
 	inline constexpr bool is_page_alloc_v = is_page_alloc_t<alloc_t>::value;
@@ -247,6 +247,351 @@ namespace {
 		return 0;
 	}
 
+	struct cached_alloc_traits_t : basic_alloc_traits_t {
+		static constexpr bool use_alloc_cache = true;
+		static constexpr std::size_t alloc_min_slot_size = block_size_t{4}; // min pool size
+		static constexpr std::size_t alloc_max_slot_size = block_size_t{64};
+	};
+
+	struct cached_pool_alloc_traits_t
+		: mem::pool_alloc_traits_t<cached_alloc_traits_t>
+		, mem::cached_alloc_traits_t<cached_alloc_traits_t>
+		, mem::page_alloc_traits_t<cached_alloc_traits_t> {};
+
+	int test_pool_from_cached_slot() {
+		std::cout << "testing pool creation from cached slot..." << std::endl;
+
+		using cached_pool_alloc_t = mem::pool_alloc_t<dummy_allocator_t<cached_pool_alloc_traits_t>>;
+
+		constexpr std::size_t page_size = cached_pool_alloc_t::alloc_page_size;
+		cached_pool_alloc_t alloc(page_size << 10, page_size);
+
+		std::size_t slot_size = block_size_t{32};
+		void* slot = alloc.allocate(slot_size);
+		alloc.deallocate(slot, slot_size);
+		if (alloc.get_cached_size() != slot_size) {
+			std::cerr << "block was not cached" << std::endl;
+			return -1;
+		}
+
+		// pool is smaller than the slot but takes all of it
+		void* ptr = alloc.malloc(min_pool_chunk_size);
+		if (ptr < slot || ptr >= advance_ptr(slot, slot_size) || alloc.get_cached_size() != 0) {
+			std::cerr << "cached slot was split" << std::endl;
+			return -1;
+		}
+		alloc.free(ptr);
+
+		std::cout << "testing finished" << std::endl;
+		return 0;
+	}
+
+	struct btree_alloc_traits_t : basic_alloc_traits_t {
+		static constexpr bool use_btree_addr_index = true;
+	};
+
+	struct btree_pool_alloc_traits_t
+		: mem::pool_alloc_traits_t<btree_alloc_traits_t>
+		, mem::page_alloc_traits_t<btree_alloc_traits_t> {};
+
+	int test_btree_addr_index() {
+		std::cout << "testing B+tree address index..." << std::endl;
+
+		using btree_pool_alloc_t = mem::pool_alloc_t<dummy_allocator_t<btree_pool_alloc_traits_t>>;
+
+		constexpr std::size_t page_size = btree_pool_alloc_t::alloc_page_size;
+		btree_pool_alloc_t alloc(page_size << 14, page_size);
+
+		// raw allocations & pools are found by pointer only
+		int_gen_t gen(42);
+		std::vector<std::pair<void*, std::size_t>> ptrs;
+		for (int i = 0; i < 1024; i++) {
+			std::size_t size = 1 + gen.gen(4 * max_pool_chunk_size);
+			if (void* ptr = alloc.malloc(size)) {
+				std::memset(ptr, 0xAB, size);
+				ptrs.push_back({ptr, size});
+			} else {
+				std::cerr << "failed to allocate memory" << std::endl;
+				return -1;
+			}
+		}
+
+		for (int i = 0; i < 256; i++) {
+			auto& [ptr, size] = ptrs[gen.gen(ptrs.size())];
+			std::size_t new_size = 1 + gen.gen(4 * max_pool_chunk_size);
+			if (void* new_ptr = alloc.realloc(ptr, new_size)) {
+				ptr = new_ptr;
+				size = new_size;
+			} else {
+				std::cerr << "failed to reallocate memory" << std::endl;
+				return -1;
+			}
+		}
+
+		for (auto& [ptr, size] : ptrs) {
+			if (!alloc.free(ptr)) {
+				std::cerr << "allocation was not found" << std::endl;
+				return -1;
+			}
+		}
+
+		std::cout << "testing finished" << std::endl;
+		return 0;
+	}
+
+	// descriptors left in sparse descriptor pools are moved by trim() so the pools are released
+	template<class alloc_t>
+	int test_descr_compaction_impl() {
+		constexpr std::size_t page_size = alloc_t::alloc_page_size;
+		alloc_t alloc(page_size << 14, page_size);
+
+		std::vector<void*> ptrs;
+		std::vector<std::size_t> sizes;
+		for (int i = 0; i < 1024; i++) {
+			std::size_t size = (i % 2 == 0 ? 4 : 1) * max_pool_chunk_size; // raw allocations & pools
+			if (void* ptr = alloc.malloc(size)) {
+				std::memset(ptr, 0xAB, size);
+				ptrs.push_back(ptr);
+				sizes.push_back(size);
+			} else {
+				std::cerr << "failed to allocate memory" << std::endl;
+				return -1;
+			}
+		}
+
+		std::vector<void*> kept;
+		std::vector<std::size_t> kept_sizes;
+		for (std::size_t i = 0; i < ptrs.size(); i++) {
+			if (i % 16 == 0) {
+				kept.push_back(ptrs[i]);
+				kept_sizes.push_back(sizes[i]);
+			} else if (!alloc.free(ptrs[i])) {
+				std::cerr << "allocation was not found" << std::endl;
+				return -1;
+			}
+		}
+
+		std::size_t capacity = alloc.get_descr_capacity();
+		std::size_t committed = alloc.get_committed_size();
+		std::size_t decommitted = alloc.get_decommitted_size();
+		alloc.trim();
+		std::cout << "descriptor capacity: " << capacity << " -> " << alloc.get_descr_capacity() << std::endl;
+		if (alloc.get_descr_capacity() * 2 > capacity) {
+			std::cerr << "descriptor pools were not compacted" << std::endl;
+			return -1;
+		} if constexpr(mem::has_meta_alloc_v<alloc_t>) {
+			// emptied pools don't stay resident in the metadata region
+			if (alloc.get_committed_size() == committed && alloc.get_decommitted_size() == decommitted) {
+				std::cerr << "emptied descriptor pools were not decommitted" << std::endl;
+				return -1;
+			}
+		}
+
+		// moved descriptors are still found by pointer & by size
+		for (std::size_t i = 0; i < kept.size(); i++) {
+			if (i % 2 == 0) {
+				std::size_t new_size = kept_sizes[i] + max_pool_chunk_size;
+				if (void* ptr = alloc.realloc(kept[i], new_size)) {
+					kept[i] = ptr;
+					kept_sizes[i] = new_size;
+				} else {
+					std::cerr << "failed to reallocate memory" << std::endl;
+					return -1;
+				}
+			}
+		}
+		for (std::size_t i = 0; i < kept.size(); i++) {
+			if (!alloc.free(kept[i])) {
+				std::cerr << "allocation was not found" << std::endl;
+				return -1;
+			}
+		}
+
+		return 0;
+	}
+
+	struct meta_alloc_traits_t : basic_alloc_traits_t {
+		static constexpr bool use_meta_region = true;
+		static constexpr std::size_t alloc_meta_reserve_size = block_size_t{1 << 12};
+		static constexpr std::size_t alloc_meta_commit_size = block_size_t{64};
+		static constexpr std::size_t alloc_quick_list_pages = 0;
+	};
+
+	struct meta_pool_alloc_traits_t
+		: mem::pool_alloc_traits_t<meta_alloc_traits_t>
+		, mem::page_alloc_traits_t<meta_alloc_traits_t> {};
+
+	int test_descr_compaction() {
+		std::cout << "testing descriptor compaction..." << std::endl;
+
+		if (test_descr_compaction_impl<mem::pool_alloc_t<dummy_allocator_t<pool_alloc_traits_t>>>()) {
+			return -1;
+		} if (test_descr_compaction_impl<mem::pool_alloc_t<dummy_allocator_t<btree_pool_alloc_traits_t>>>()) {
+			return -1;
+		} if (test_descr_compaction_impl<mem::pool_alloc_t<mem::page_alloc_t<dummy_allocator_t<meta_pool_alloc_traits_t>>>>()) {
+			return -1;
+		}
+
+		std::cout << "testing finished" << std::endl;
+		return 0;
+	}
+
+	struct direct_alloc_traits_t : basic_alloc_traits_t {
+		static constexpr std::size_t alloc_direct_threshold = block_size_t{128};
+	};
+
+	struct direct_pool_alloc_traits_t
+		: mem::pool_alloc_traits_t<direct_alloc_traits_t>
+		, mem::page_alloc_traits_t<direct_alloc_traits_t> {};
+
+	// huge allocations bypass page runs of the page allocator
+	int test_direct_alloc() {
+		std::cout << "testing direct allocations..." << std::endl;
+
+		using direct_pool_alloc_t = mem::pool_alloc_t<mem::page_alloc_t<dummy_allocator_t<direct_pool_alloc_traits_t>>>;
+
+		constexpr std::size_t page_size = direct_pool_alloc_t::alloc_page_size;
+		constexpr std::size_t huge_size = direct_pool_alloc_t::alloc_direct_threshold;
+		direct_pool_alloc_t alloc(page_size << 14, page_size);
+
+		void* small = alloc.malloc(4 * max_pool_chunk_size);
+		std::size_t sysmem_size = alloc.get_sysmem_size();
+
+		void* ptr = alloc.malloc(huge_size);
+		if (!ptr || alloc.get_sysmem_size() != sysmem_size) {
+			std::cerr << "huge allocation was not mapped directly" << std::endl;
+			return -1;
+		}
+		std::memset(ptr, 0xAB, huge_size);
+
+		// direct -> direct, direct -> page runs & back
+		for (std::size_t new_size : {2 * huge_size, 4 * max_pool_chunk_size, huge_size}) {
+			void* new_ptr = alloc.realloc(ptr, new_size);
+			if (!new_ptr || *(unsigned char*)new_ptr != 0xAB) {
+				std::cerr << "failed to reallocate memory" << std::endl;
+				return -1;
+			}
+			ptr = new_ptr;
+		}
+
+		if (!alloc.free(ptr) || !alloc.free(small)) {
+			std::cerr << "allocation was not found" << std::endl;
+			return -1;
+		}
+
+		// block mapped by the caller is registered & freed as any other direct block
+		std::size_t direct_size = alloc.get_direct_size(huge_size - 1, 0);
+		if (direct_size != huge_size || alloc.get_direct_size(4 * max_pool_chunk_size, 0) != 0) {
+			std::cerr << "unexpected direct size" << std::endl;
+			return -1;
+		}
+		void* data = alloc.allocate_direct(direct_size);
+		if (!data || alloc.adopt_direct(data, huge_size - 1, 0) != data || !alloc.free(data)) {
+			std::cerr << "mapped block was not adopted" << std::endl;
+			return -1;
+		}
+
+		// freed runs can wait in quick lists of the page allocator
+		alloc.trim();
+		if (alloc.get_sysmem_size() != 0) {
+			std::cerr << "memory was not released" << std::endl;
+			return -1;
+		}
+
+		std::cout << "testing finished" << std::endl;
+		return 0;
+	}
+
+	// chunks of one pool are allocated & freed in batches, they are interchangeable with regular allocations
+	int test_bulk() {
+		std::cout << "testing bulk operations..." << std::endl;
+
+		constexpr std::size_t page_size = pool_alloc_t::alloc_page_size;
+		pool_alloc_t alloc(page_size << 10, page_size);
+
+		std::size_t index = alloc.get_pool_index(min_pool_chunk_size + 1, 0);
+		if (index == alloc.get_pool_count() || alloc.get_pool_chunk_size(index) < min_pool_chunk_size + 1
+			|| alloc.get_pool_index(4 * max_pool_chunk_size, 0) != alloc.get_pool_count()) {
+			std::cerr << "unexpected pool index" << std::endl;
+			return -1;
+		}
+
+		void* ptrs[64] = {};
+		if (alloc.malloc_bulk(index, ptrs, 64) != 64) {
+			std::cerr << "failed to allocate memory" << std::endl;
+			return -1;
+		}
+		for (void* ptr : ptrs) {
+			std::memset(ptr, 0xAB, min_pool_chunk_size + 1);
+		}
+		if (!alloc.free(ptrs[0]) || !alloc.free_bulk(index, ptrs + 1, 63)) {
+			std::cerr << "allocation was not found" << std::endl;
+			return -1;
+		}
+
+		std::cout << "testing finished" << std::endl;
+		return 0;
+	}
+
+	struct page_map_alloc_traits_t : basic_alloc_traits_t {
+		static constexpr bool use_page_map = true;
+	};
+
+	struct page_map_pool_alloc_traits_t
+		: mem::pool_alloc_traits_t<page_map_alloc_traits_t>
+		, mem::page_alloc_traits_t<page_map_alloc_traits_t> {};
+
+	// pool of a chunk is found by pointer only, pages of released pools & raw allocations have no pool
+	int test_page_map() {
+		std::cout << "testing page map..." << std::endl;
+
+		using page_map_pool_alloc_t = mem::pool_alloc_t<dummy_allocator_t<page_map_pool_alloc_traits_t>>;
+
+		constexpr std::size_t page_size = page_map_pool_alloc_t::alloc_page_size;
+		page_map_pool_alloc_t alloc(page_size << 12, page_size);
+
+		std::vector<std::pair<void*, std::size_t>> ptrs;
+		for (std::size_t size = 1; size <= max_pool_chunk_size; size *= 2) {
+			for (int i = 0; i < 64; i++) {
+				if (void* ptr = alloc.malloc(size)) {
+					ptrs.push_back({ptr, size});
+				} else {
+					std::cerr << "failed to allocate memory" << std::endl;
+					return -1;
+				}
+			}
+		}
+
+		void* raw = alloc.malloc(4 * max_pool_chunk_size);
+		if (!raw || alloc.find_pool_index(raw) != alloc.get_pool_count()) {
+			std::cerr << "raw allocation was found in pools" << std::endl;
+			return -1;
+		}
+
+		for (auto& [ptr, size] : ptrs) {
+			if (alloc.find_pool_index(ptr) != alloc.get_pool_index(size, 0)) {
+				std::cerr << "unexpected pool index of " << pretty(ptr) << ": " << alloc.find_pool_index(ptr) << std::endl;
+				return -1;
+			}
+		}
+
+		for (auto& [ptr, size] : ptrs) {
+			if (!alloc.free(ptr)) {
+				std::cerr << "allocation was not found" << std::endl;
+				return -1;
+			}
+		} for (auto& [ptr, size] : ptrs) {
+			if (alloc.find_pool_index(ptr) != alloc.get_pool_count()) {
+				std::cerr << "released pool was found" << std::endl;
+				return -1;
+			}
+		}
+		alloc.free(raw);
+
+		std::cout << "testing finished" << std::endl;
+		return 0;
+	}
+
 	struct allocation_t {
 		void* ptr{};
 		std::size_t size{};
@@ -273,7 +618,6 @@ namespace {
 		auto print_status = [&] () {
 			if constexpr(is_page_alloc_v<pool_alloc_t>) {
 				std::cout << "- addr_index" << std::endl << addr_index_info_t{alloc};
-				std::cout << "- size_index" << std::endl << size_index_info_t{alloc};
 			}
 			std::cout << "- alloc ranges" << std::endl << ranges_info_t{alloc};
 		};
@@ -372,7 +716,37 @@ int main() {
 	}
 	std::cout << std::endl;
 	
-	if (test_pool_alloc_random()) {
+	if (test_pool_from_cached_slot()) {
+		return -1;
+	}
+	std::cout << std::endl;
+
+	if (test_btree_addr_index()) {
+		return -1;
+	}
+	std::cout << std::endl;
+
+	if (test_descr_compaction()) {
+		return -1;
+	}
+	std::cout << std::endl;
+
+	if (test_direct_alloc()) {
+		return -1;
+	}
+	std::cout << std::endl;
+
+	if (test_bulk()) {
+		return -1;
+	}
+	std::cout << std::endl;
+
+	if (test_page_map()) {
+		return -1;
+	}
+	std::cout << std::endl;
+
+		if (test_pool_alloc_random()) {
 		return -1;
 	}
 	std::cout << std::endl;
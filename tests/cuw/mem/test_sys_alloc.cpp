@@ -26,8 +26,58 @@ namespace {
 		std::cout << ":D" << std::endl;
 		return 0;
 	}
+
+	int test_huge_pages() {
+		allocator_t alloc;
+		alloc.set_huge_page_mode(mem::huge_page_mode_t::Transparent);
+
+		std::size_t huge_page_size = alloc.get_huge_page_size();
+		std::size_t alloc_size = 4 * huge_page_size;
+
+		void* ptr = alloc.allocate(alloc_size);
+		if (!ptr || !mem::is_aligned(ptr, huge_page_size)) {
+			std::cerr << "huge page region is not aligned" << std::endl;
+			return -1;
+		}
+		memset(ptr, 0xFF, alloc_size);
+		alloc.deallocate(ptr, alloc_size);
+		std::cout << ":D" << std::endl;
+		return 0;
+	}
+
+	int test_deferred_unmap() {
+		allocator_t alloc;
+		alloc.set_deferred_unmap(true);
+
+		std::size_t alloc_size = 1 << 16;
+		void* ptr = allocator_t::map(alloc_size, alloc.get_map_params());
+		if (!ptr) {
+			std::cerr << "failed to map memory" << std::endl;
+			return -1;
+		}
+
+		// range stays mapped until queued unmaps are taken
+		alloc.deallocate(ptr, alloc_size);
+		memset(ptr, 0xFF, alloc_size);
+
+		mem::sysmem_range_t ranges[allocator_t::sysmem_queue_size];
+		std::size_t count = alloc.take_unmaps(ranges);
+		if (count != 1 || ranges[0].ptr != ptr || ranges[0].size != alloc_size || alloc.take_unmaps(ranges) != 0) {
+			std::cerr << "unmap was not queued" << std::endl;
+			return -1;
+		}
+		allocator_t::unmap(ranges, count);
+		std::cout << ":D" << std::endl;
+		return 0;
+	}
 }
 
 int main(int argc, char* argv[]) {
-	return test_sys_alloc();
+	if (test_sys_alloc()) {
+		return -1;
+	}
+	if (test_deferred_unmap()) {
+		return -1;
+	}
+	return test_huge_pages();
 }
\ No newline at end of file
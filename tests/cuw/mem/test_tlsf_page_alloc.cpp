@@ -0,0 +1,336 @@
+#include <random>
+#include <iomanip>
+#include <iostream>
+
+#include <cuw/mem/alloc_traits.hpp>
+#include <cuw/mem/tlsf_page_alloc.hpp>
+
+#include "dummy_alloc.hpp"
+
+using namespace cuw;
+
+namespace {
+	template<std::size_t blocks_per_page,
+		std::size_t blocks_per_pool,
+		std::size_t blocks_per_sysmem_pool,
+		std::size_t blocks_per_min_block>
+	struct __traits_t {
+		static constexpr bool use_resolved_page_size = true;
+		static constexpr bool use_tlsf_page_alloc = true;
+		static constexpr std::size_t alloc_page_size = block_size_t{blocks_per_page};
+		static constexpr std::size_t alloc_block_pool_size = block_size_t{blocks_per_pool};
+		static constexpr std::size_t alloc_sysmem_pool_size = block_size_t{blocks_per_sysmem_pool};
+		static constexpr std::size_t alloc_min_block_size = block_size_t{blocks_per_min_block};
+		static constexpr std::size_t alloc_max_block_size = block_size_t{blocks_per_min_block}; // fixed size regions
+		static constexpr bool use_region_retention = false; // free regions are unmapped immediately
+	};
+
+	template<std::size_t blocks_per_page, std::size_t blocks_per_pool, std::size_t blocks_per_sysmem_pool, std::size_t blocks_per_min_block>
+	using traits_t = mem::page_alloc_traits_t<__traits_t<blocks_per_page, blocks_per_pool, blocks_per_sysmem_pool, blocks_per_min_block>>;
+
+	template<std::size_t blocks_per_page, std::size_t blocks_per_pool, std::size_t blocks_per_sysmem_pool, std::size_t blocks_per_min_block>
+	using basic_alloc_t = dummy_allocator_t<traits_t<blocks_per_page, blocks_per_pool, blocks_per_sysmem_pool, blocks_per_min_block>>;
+
+	template<class alloc_t>
+	std::size_t count_free_runs(alloc_t& alloc) {
+		std::size_t count = 0;
+		alloc.traverse_free_runs([&] (void* ptr, std::size_t size) { ++count; });
+		return count;
+	}
+
+	int test_coalesce() {
+		using page_alloc_t = mem::page_alloc_backend_t<basic_alloc_t<1, 4, 4, 8>>;
+
+		std::cout << "testing coalescing" << std::endl;
+
+		page_alloc_t alloc(block_size_t{64}, block_size_t{1});
+
+		void* a = alloc.allocate(block_size_t{2});
+		void* b = alloc.allocate(block_size_t{2});
+		void* c = alloc.allocate(block_size_t{2});
+		if (b != advance_ptr(a, block_size_t{2}) || c != advance_ptr(b, block_size_t{2})) {
+			std::cerr << "allocations are not adjacent" << std::endl;
+			return -1;
+		}
+
+		// only the tail of the region is free
+		if (count_free_runs(alloc) != 1) {
+			std::cerr << "unexpected count of free runs" << std::endl;
+			return -1;
+		}
+
+		alloc.deallocate(a, block_size_t{2});
+		alloc.deallocate(c, block_size_t{2}); // coalesces with the tail
+		if (count_free_runs(alloc) != 2) {
+			std::cerr << "free runs were not coalesced" << std::endl;
+			return -1;
+		}
+
+		// exact class must be reused
+		if (alloc.allocate(block_size_t{2}) != a) {
+			std::cerr << "free run was not reused" << std::endl;
+			return -1;
+		}
+		alloc.deallocate(a, block_size_t{2});
+
+		// whole region becomes free and is returned
+		alloc.deallocate(b, block_size_t{2});
+		if (count_free_runs(alloc) != 0) {
+			std::cerr << "region was not released" << std::endl;
+			return -1;
+		}
+
+		alloc.release_mem();
+
+		std::cout << "testing coalescing finished" << std::endl << std::endl;
+
+		return 0;
+	}
+
+	int test_reserve_trim() {
+		using page_alloc_t = mem::tlsf_page_alloc_t<basic_alloc_t<1, 4, 4, 8>>;
+
+		std::cout << "testing reserve & trim" << std::endl;
+
+		page_alloc_t alloc(block_size_t{64}, block_size_t{1});
+
+		// reserved region stays mapped while it is free
+		if (!alloc.reserve(block_size_t{8}) || alloc.get_sysmem_size() != block_size_t{8} || count_free_runs(alloc) != 1) {
+			std::cerr << "reserved region was not retained" << std::endl;
+			return -1;
+		}
+
+		void* a = alloc.allocate(block_size_t{8});
+		alloc.deallocate(a, block_size_t{8});
+		if (alloc.get_sysmem_size() != block_size_t{8}) {
+			std::cerr << "reserved region was released" << std::endl;
+			return -1;
+		}
+
+		if (alloc.trim() < block_size_t{8} || alloc.get_sysmem_size() != 0 || count_free_runs(alloc) != 0) {
+			std::cerr << "region was not trimmed" << std::endl;
+			return -1;
+		}
+
+		alloc.release_mem();
+
+		std::cout << "testing reserve & trim finished" << std::endl << std::endl;
+
+		return 0;
+	}
+
+	struct __retention_traits_t : __traits_t<1, 4, 4, 8> {
+		static constexpr bool use_region_retention = true;
+		static constexpr std::size_t alloc_max_block_size = block_size_t{32};
+	};
+
+	int test_region_retention() {
+		using page_alloc_t = mem::tlsf_page_alloc_t<dummy_allocator_t<mem::page_alloc_traits_t<__retention_traits_t>>>;
+
+		std::cout << "testing region retention" << std::endl;
+
+		page_alloc_t alloc(block_size_t{64}, block_size_t{1});
+
+		// the only region stays mapped when it becomes free & is reused
+		void* a = alloc.allocate(block_size_t{8});
+		alloc.deallocate(a, block_size_t{8});
+		if (alloc.get_sysmem_size() != block_size_t{8} || alloc.allocate(block_size_t{8}) != a) {
+			std::cerr << "free region was not retained" << std::endl;
+			return -1;
+		}
+
+		// second region is retained while the first one is in use, then one growth step of free memory is kept
+		void* b = alloc.allocate(block_size_t{8});
+		alloc.deallocate(b, block_size_t{8});
+		if (alloc.get_sysmem_size() != block_size_t{16}) {
+			std::cerr << "free region was not retained" << std::endl;
+			return -1;
+		}
+		alloc.deallocate(a, block_size_t{8});
+		if (alloc.get_sysmem_size() != block_size_t{8}) {
+			std::cerr << "unexpected heap size: " << alloc.get_sysmem_size() << std::endl;
+			return -1;
+		}
+
+		// trim ignores retention
+		if (alloc.trim() < block_size_t{8} || alloc.get_sysmem_size() != 0) {
+			std::cerr << "regions were not released" << std::endl;
+			return -1;
+		}
+
+		alloc.release_mem();
+
+		std::cout << "testing region retention finished" << std::endl << std::endl;
+
+		return 0;
+	}
+
+	// maps queued regions the way the caller of a deferred mode allocator does outside of a lock
+	// returns true if failed allocation can be retried
+	template<class alloc_t, class base_t>
+	bool run_sysmem_ops(alloc_t& alloc, base_t& base, std::size_t& count) {
+		mem::sysmem_op_t ops[mem::default_sysmem_queue_size];
+		count = alloc.take_sysmem_ops(ops);
+		for (std::size_t i = 0; i < count; i++) {
+			if (ops[i].type == mem::sysmem_op_type_t::Map) {
+				ops[i].ptr = base.allocate(ops[i].size);
+				ops[i].done = ops[i].ptr != nullptr;
+			}
+		}
+		return alloc.finish_sysmem_ops(ops, count);
+	}
+
+	int test_deferred_sysmem_ops() {
+		using basic_alloc_t = basic_alloc_t<1, 4, 4, 8>;
+		using page_alloc_t = mem::tlsf_page_alloc_t<basic_alloc_t>;
+
+		std::cout << "testing deferred system calls" << std::endl;
+
+		page_alloc_t alloc(block_size_t{64}, block_size_t{1});
+		basic_alloc_t& base = alloc;
+		alloc.set_deferred_sysmem_ops(true);
+
+		// allocation fails until the region is mapped outside of the lock, then the spare region is used
+		std::size_t count = 0;
+		if (alloc.allocate(block_size_t{2}) || alloc.get_sysmem_size() != 0) {
+			std::cerr << "region was mapped under the lock" << std::endl;
+			return -1;
+		} if (!run_sysmem_ops(alloc, base, count) || count != 1) {
+			std::cerr << "map was not queued" << std::endl;
+			return -1;
+		}
+		void* a = alloc.allocate(block_size_t{2});
+		if (!a || alloc.get_sysmem_size() != block_size_t{8} || count_free_runs(alloc) != 1) {
+			std::cerr << "spare region was not used" << std::endl;
+			return -1;
+		}
+
+		// the next region is requested only when free runs are too small
+		if (alloc.allocate(block_size_t{8}) || !run_sysmem_ops(alloc, base, count) || count != 1) {
+			std::cerr << "map was not queued" << std::endl;
+			return -1;
+		}
+		void* b = alloc.allocate(block_size_t{8});
+		if (!b || alloc.get_sysmem_size() != block_size_t{16}) {
+			std::cerr << "spare region was not used" << std::endl;
+			return -1;
+		}
+		alloc.deallocate(a, block_size_t{2});
+		alloc.deallocate(b, block_size_t{8});
+		if (alloc.get_sysmem_size() != 0) {
+			std::cerr << "regions were not released" << std::endl;
+			return -1;
+		}
+
+		// spare region that was not used is released by trim
+		if (alloc.allocate(block_size_t{2}) || !run_sysmem_ops(alloc, base, count) || alloc.trim() < block_size_t{8}) {
+			std::cerr << "spare region was not trimmed" << std::endl;
+			return -1;
+		}
+
+		alloc.release_mem();
+		if (alloc.get_ranges().size() != 1) {
+			std::cerr << "memory leaked" << std::endl;
+			return -1;
+		}
+
+		std::cout << "testing deferred system calls finished" << std::endl << std::endl;
+
+		return 0;
+	}
+
+	struct allocation_t {
+		void* ptr{};
+		std::size_t size{};
+	};
+
+	int test_random_stuff() {
+		std::cout << "testing by random allocations/dellocations..." << std::endl;
+
+		constexpr int total_commands = 1 << 14;
+		constexpr std::size_t min_alloc_size = block_size_t{1};
+		constexpr std::size_t max_alloc_size = block_size_t{1 << 10};
+
+		using alloc_t = mem::tlsf_page_alloc_t<basic_alloc_t<1, 8, 4, 32>>;
+
+		alloc_t alloc(block_size_t{1 << 15}, block_size_t{1});
+		int_gen_t gen(42);
+		std::vector<allocation_t> allocations;
+		std::set<range_t> used;
+
+		auto try_allocate = [&] () {
+			std::size_t size = gen.gen(min_alloc_size, max_alloc_size);
+			if (void* ptr = alloc.allocate(size)) {
+				range_t range{nullptr, ptr, alloc.get_true_size(size)};
+				if (auto it = used.lower_bound(range); it != used.end() && it->get_start() < range.get_end()
+					|| it != used.begin() && std::prev(it)->get_end() > range.get_start()) {
+					std::cerr << "allocation " << range << " overlaps" << std::endl;
+					std::abort();
+				}
+				used.insert(range);
+				allocations.push_back({ptr, size});
+				memset_deadbeef(ptr, size);
+			}
+		};
+
+		auto try_deallocate = [&] () {
+			if (allocations.empty()) {
+				return;
+			}
+
+			int index = gen.gen(allocations.size());
+			std::swap(allocations[index], allocations.back());
+			auto curr = allocations.back();
+			allocations.pop_back();
+
+			used.erase(range_t{nullptr, curr.ptr, 0});
+			std::memset(curr.ptr, 0xFF, curr.size);
+			alloc.deallocate(curr.ptr, curr.size);
+		};
+
+		for (int i = 0; i < total_commands; i++) {
+			if (gen.gen(2) == 0) {
+				try_allocate();
+			} else {
+				try_deallocate();
+			}
+		}
+
+		std::cout << "deallocating all..." << std::endl;
+		std::cout << "total allocations: " << allocations.size() << std::endl;
+		for (auto& [ptr, size] : allocations) {
+			alloc.deallocate(ptr, size);
+		}
+
+		if (count_free_runs(alloc) != 0) {
+			std::cerr << "free runs left after everything was deallocated" << std::endl;
+			return -1;
+		}
+
+		alloc.release_mem();
+		if (alloc.get_ranges().size() != 1) {
+			std::cerr << "memory leaked" << std::endl;
+			return -1;
+		}
+
+		std::cout << "testing finished" << std::endl << std::endl;
+
+		return 0;
+	}
+}
+
+int main(int argc, char* argv[]) {
+	if (test_coalesce()) {
+		return -1;
+	}
+
+	if (test_reserve_trim() || test_region_retention() || test_deferred_sysmem_ops()) {
+		return -1;
+	}
+
+	if (test_random_stuff()) {
+		return -1;
+	}
+
+	return 0;
+}
@@ -126,9 +126,9 @@ namespace {
 	struct fbd_info_t {
 		friend std::ostream& operator << (std::ostream& os, const fbd_info_t& info) {
 			return os << " fbd: " << (void*)info.fbd
-				<< " off: " << info.fbd->offset
-				<< " size: " << info.fbd->size
-				<< " data: " << info.fbd->data;
+				<< " size: " << info.fbd->get_size()
+				<< " max size: " << info.fbd->get_max_size()
+				<< " data: " << info.fbd->get_start();
 		}
 
 		fbd_t* fbd{};
@@ -138,7 +138,7 @@ namespace {
 	struct addr_index_info_t {
 		friend std::ostream& operator << (std::ostream& os, const addr_index_info_t& nodes) {
 			for (auto index : nodes.alloc.get_addr_index()) {
-				os << fbd_info_t{mem::free_block_descr_t::addr_index_to_descr(index)} << std::endl;
+				os << fbd_info_t{page_alloc_t::fbd_t::addr_index_to_descr(index)} << std::endl;
 			}
 			return os;
 		}
@@ -146,22 +146,10 @@ namespace {
 		page_alloc_t& alloc;
 	};
 
-	template<class page_alloc_t>
-	struct size_index_info_t {
-		friend std::ostream& operator << (std::ostream& os, const size_index_info_t& nodes) {
-			for (auto index : nodes.alloc.get_size_index()) {
-				os << fbd_info_t{mem::free_block_descr_t::size_index_to_descr(index)} << std::endl;
-			} return os;
-		}
-
-		page_alloc_t& alloc;
-	};
-
 	template<class page_alloc_t>
 	struct page_alloc_info_t {
 		friend std::ostream& operator << (std::ostream& os, const page_alloc_info_t& info) {
-			return os << "addr index:" << std::endl << addr_index_info_t{info.alloc} << std::endl
-				<< "size index:" << std::endl << size_index_info_t{info.alloc} << std::endl;
+			return os << "addr index:" << std::endl << addr_index_info_t{info.alloc} << std::endl;
 		}
 
 		page_alloc_t& alloc;
@@ -0,0 +1,299 @@
+#include <set>
+#include <chrono>
+#include <random>
+#include <vector>
+#include <iostream>
+#include <algorithm>
+
+#include <cuw/utils/trb.hpp>
+#include <cuw/utils/trb_node.hpp>
+#include <cuw/utils/btree.hpp>
+
+using namespace cuw;
+
+namespace {
+	struct value_t {
+		std::uint64_t key{};
+	};
+
+	struct key_ops_t {
+		std::uint64_t get_key(value_t* value) const {
+			return value->key;
+		}
+
+		bool compare(std::uint64_t lhs, std::uint64_t rhs) const {
+			return lhs < rhs;
+		}
+	};
+
+	struct chunk_alloc_t {
+		void* allocate(std::size_t size) {
+			++chunks;
+			return ::operator new(size, std::align_val_t{64});
+		}
+
+		void deallocate(void* ptr, std::size_t size) {
+			--chunks;
+			::operator delete(ptr, std::align_val_t{64});
+		}
+
+		int chunks{};
+	};
+
+	// small nodes so the tree grows high
+	using tree_t = btree::btree_t<value_t, key_ops_t, 128>;
+
+	int test_random() {
+		std::cout << "testing random insertions/removals" << std::endl;
+
+		constexpr int total_values = 20000;
+		constexpr int total_commands = 1 << 17;
+
+		std::minstd_rand gen(42);
+		std::vector<value_t> values(total_values);
+		std::vector<value_t*> inserted;
+		std::vector<value_t*> free_values;
+		std::multiset<std::uint64_t> keys;
+		chunk_alloc_t alloc;
+		tree_t tree;
+		tree.set_chunk_size(1 << 12);
+
+		for (auto& value : values) {
+			free_values.push_back(&value);
+		}
+
+		for (int i = 0; i < total_commands; i++) {
+			if (inserted.empty() || !free_values.empty() && gen() % 8 < 5) {
+				value_t* value = free_values.back();
+				free_values.pop_back();
+				value->key = gen() % (total_values / 2); // plenty of equal keys
+				if (!tree.insert(alloc, value)) {
+					std::cerr << "insertion failed" << std::endl;
+					return -1;
+				}
+				inserted.push_back(value);
+				keys.insert(value->key);
+			} else {
+				std::size_t index = gen() % inserted.size();
+				std::swap(inserted[index], inserted.back());
+				value_t* value = inserted.back();
+				inserted.pop_back();
+				if (!tree.erase(value)) {
+					std::cerr << "value was not found" << std::endl;
+					return -1;
+				}
+				free_values.push_back(value);
+				keys.erase(keys.find(value->key));
+			}
+
+			if (i % 1024 == 0 && !tree.check_invariant()) {
+				std::cerr << "invariant is broken" << std::endl;
+				return -1;
+			}
+
+			std::uint64_t key = gen() % (total_values / 2);
+			value_t* lb = tree.lower_bound(key);
+			auto lb_it = keys.lower_bound(key);
+			if ((lb == nullptr) != (lb_it == keys.end()) || lb && lb->key != *lb_it) {
+				std::cerr << "lower_bound mismatch" << std::endl;
+				return -1;
+			}
+
+			value_t* fl = tree.floor(key);
+			auto fl_it = keys.upper_bound(key);
+			if ((fl == nullptr) != (fl_it == keys.begin()) || fl && fl->key != *std::prev(fl_it)) {
+				std::cerr << "floor mismatch" << std::endl;
+				return -1;
+			}
+		}
+
+		if (!tree.check_invariant() || tree.get_size() != keys.size()) {
+			std::cerr << "invariant is broken" << std::endl;
+			return -1;
+		}
+
+		std::cout << "size: " << tree.get_size() << " height: " << tree.get_height() << std::endl;
+
+		// all values are traversed in order
+		auto it = keys.begin();
+		bool ordered = true;
+		tree.traverse([&] (value_t* value) { ordered = ordered && value->key == *it++; });
+		if (!ordered || it != keys.end()) {
+			std::cerr << "traversal mismatch" << std::endl;
+			return -1;
+		}
+
+		for (value_t* value : inserted) {
+			if (!tree.erase(value)) {
+				std::cerr << "value was not found" << std::endl;
+				return -1;
+			}
+		}
+		if (!tree.empty() || tree.get_height() != 0 || !tree.check_invariant()) {
+			std::cerr << "tree is not empty" << std::endl;
+			return -1;
+		}
+
+		tree.release(alloc);
+		if (alloc.chunks != 0) {
+			std::cerr << "chunks leaked" << std::endl;
+			return -1;
+		}
+
+		std::cout << "testing finished" << std::endl << std::endl;
+
+		return 0;
+	}
+
+	int test_sequential() {
+		std::cout << "testing sequential insertions" << std::endl;
+
+		constexpr int total_values = 1 << 16;
+
+		std::vector<value_t> values(total_values);
+		chunk_alloc_t alloc;
+		btree::btree_t<value_t, key_ops_t> tree;
+
+		for (int i = 0; i < total_values; i++) {
+			values[i].key = 2 * i;
+			if (!tree.insert(alloc, &values[i])) {
+				std::cerr << "insertion failed" << std::endl;
+				return -1;
+			}
+		}
+
+		// 4-line nodes keep the tree shallow
+		if (!tree.check_invariant() || tree.get_height() > 5) {
+			std::cerr << "unexpected tree shape, height: " << tree.get_height() << std::endl;
+			return -1;
+		}
+
+		for (int i = 0; i < total_values; i++) {
+			if (tree.floor(2 * i + 1) != &values[i] || tree.lower_bound(2 * i + 1) != (i + 1 < total_values ? &values[i + 1] : nullptr)) {
+				std::cerr << "search mismatch" << std::endl;
+				return -1;
+			}
+		}
+
+		tree.release(alloc);
+
+		std::cout << "testing finished" << std::endl << std::endl;
+
+		return 0;
+	}
+
+	using trb_node_t = trb::tree_node_t<trb::tree_node_traits_t<void>>;
+
+	// descriptor-like value: tree node is embedded, values are scattered in memory
+	struct indexed_value_t {
+		trb_node_t node{};
+		std::uint64_t key{};
+		char padding[64]{};
+	};
+
+	struct trb_key_ops_t {
+		std::uint64_t get_key(trb_node_t* node) const {
+			return ((indexed_value_t*)node)->key;
+		}
+
+		bool compare(std::uint64_t lhs, std::uint64_t rhs) const {
+			return lhs < rhs;
+		}
+	};
+
+	struct indexed_key_ops_t {
+		std::uint64_t get_key(indexed_value_t* value) const {
+			return value->key;
+		}
+
+		bool compare(std::uint64_t lhs, std::uint64_t rhs) const {
+			return lhs < rhs;
+		}
+	};
+
+	template<class func_t>
+	long long measure_us(func_t func) {
+		auto t0 = std::chrono::steady_clock::now();
+		func();
+		auto t1 = std::chrono::steady_clock::now();
+		return std::chrono::duration_cast<std::chrono::microseconds>(t1 - t0).count();
+	}
+
+	// compares lookups of the B+tree (keys in nodes) against the red-black tree (keys in descriptors)
+	// timings are informational only, results must match
+	int test_lookup_bench() {
+		std::cout << "testing lookup benchmark" << std::endl;
+
+		constexpr int total_values = 1 << 17;
+		constexpr int total_lookups = 1 << 21;
+
+		std::minstd_rand gen(42);
+		std::vector<indexed_value_t> values(total_values);
+		std::vector<indexed_value_t*> order(total_values);
+		for (int i = 0; i < total_values; i++) {
+			values[i].key = 16 * (std::uint64_t)i;
+			order[i] = &values[i];
+		}
+		std::shuffle(order.begin(), order.end(), gen);
+
+		chunk_alloc_t alloc;
+		btree::btree_t<indexed_value_t, indexed_key_ops_t> tree;
+		trb_node_t* root = nullptr;
+		for (indexed_value_t* value : order) {
+			if (!tree.insert(alloc, value)) {
+				std::cerr << "insertion failed" << std::endl;
+				return -1;
+			}
+			root = trb::insert_lb(root, &value->node, trb_key_ops_t{});
+		}
+
+		std::vector<std::uint64_t> keys(total_lookups);
+		for (auto& key : keys) {
+			key = gen() % (16 * (std::uint64_t)total_values);
+		}
+
+		std::uintptr_t btree_sum = 0;
+		long long btree_us = measure_us([&] () {
+			for (std::uint64_t key : keys) {
+				btree_sum += (std::uintptr_t)tree.lower_bound(key);
+			}
+		});
+
+		std::uintptr_t trb_sum = 0;
+		long long trb_us = measure_us([&] () {
+			for (std::uint64_t key : keys) {
+				trb_sum += (std::uintptr_t)bst::lower_bound(root, key, trb_key_ops_t{});
+			}
+		});
+
+		if (btree_sum != trb_sum) {
+			std::cerr << "lookup mismatch" << std::endl;
+			return -1;
+		}
+
+		std::cout << "values: " << total_values << " lookups: " << total_lookups << std::endl;
+		std::cout << "btree: " << btree_us << "us trb: " << trb_us << "us" << std::endl;
+
+		tree.release(alloc);
+
+		std::cout << "testing finished" << std::endl << std::endl;
+
+		return 0;
+	}
+}
+
+int main(int argc, char* argv[]) {
+	if (test_random()) {
+		return -1;
+	}
+
+	if (test_sequential()) {
+		return -1;
+	}
+
+	if (test_lookup_bench()) {
+		return -1;
+	}
+
+	return 0;
+}
@@ -6,6 +6,9 @@
 #include <chrono>
 #include <random>
 #include <cassert>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
 #include <sstream>
 #include <utility>
 #include <numeric>
@@ -13,6 +16,7 @@
 #include <iostream>
 #include <stdexcept>
 #include <algorithm>
+#include <unordered_map>
 #include <type_traits>
 
 #include <cuw/utils/trb.hpp>
@@ -380,6 +384,360 @@ int tree_test3() {
 	return 0;
 }
 
+// augmented data (subtree size) is stored outside of the node
+struct subtree_size_ops_t {
+	void update(node_t* node) const {
+		int size = 1;
+		if (node->left) {
+			size += sizes.at(node->left);
+		} if (node->right) {
+			size += sizes.at(node->right);
+		} sizes[node] = size;
+	}
+
+	std::unordered_map<node_t*, int>& sizes;
+};
+
+int check_subtree_sizes(node_t* node, const std::unordered_map<node_t*, int>& sizes) {
+	if (!node) {
+		return 0;
+	}
+
+	int size = 1 + check_subtree_sizes(node->left, sizes) + check_subtree_sizes(node->right, sizes);
+	if (sizes.at(node) != size) {
+		throw std::runtime_error(join("[augment] key: ", node->data, " expected: ", size, " stored: ", sizes.at(node)));
+	} return size;
+}
+
+int tree_augment_test() {
+	std::cout << "augment test" << std::endl;
+
+	int nodes = 2000;
+	std::minstd_rand gen(42);
+	std::unordered_map<node_t*, int> sizes;
+	std::vector<node_t*> inserted;
+	node_t* root = nullptr;
+
+	subtree_size_ops_t aug_ops{sizes};
+	for (int i = 0; i < 4 * nodes; i++) {
+		if (inserted.empty() || gen() % 3 != 0) {
+			node_t* node = new node_t{};
+			node->data = (int)(gen() % nodes);
+			root = trb::insert_ub(root, node, key_ops_t{}, aug_ops);
+			inserted.push_back(node);
+		} else {
+			std::size_t index = gen() % inserted.size();
+			std::swap(inserted[index], inserted.back());
+			node_t* node = inserted.back();
+			inserted.pop_back();
+			root = trb::remove(root, node, aug_ops);
+			sizes.erase(node);
+			delete node;
+		}
+
+		if (!trb::check_rb_invariant(root)) {
+			throw std::runtime_error("[augment] invariant");
+		} if (check_subtree_sizes(root, sizes) != (int)inserted.size()) {
+			throw std::runtime_error("[augment] size");
+		}
+	}
+
+	for (node_t* node : inserted) {
+		delete node;
+	}
+
+	std::cout << "augment test passed" << std::endl;
+	return 0;
+}
+
+int tree_finger_test() {
+	std::cout << "finger test" << std::endl;
+
+	int nodes = 2000;
+	std::minstd_rand gen(42);
+	std::vector<node_t*> inserted;
+	node_t* root = nullptr;
+	for (int i = 0; i < nodes; i++) {
+		node_t* node = new node_t{};
+		node->data = (int)(gen() % nodes); // equal keys as well
+		root = trb::insert_ub(root, node, key_ops_t{});
+		inserted.push_back(node);
+	}
+
+	// result must not depend on the starting node
+	for (int i = 0; i < 8 * nodes; i++) {
+		node_t* finger = i % 16 == 0 ? nullptr : inserted[gen() % inserted.size()];
+		int key = (int)(gen() % (nodes + 2)) - 1;
+		if (bst::finger_lower_bound(root, finger, key, key_ops_t{}) != bst::lower_bound(root, key, key_ops_t{})) {
+			throw std::runtime_error(join("[finger] key: ", key, " finger: ", finger ? finger->data : -1));
+		}
+	}
+
+	for (node_t* node : inserted) {
+		delete node;
+	}
+
+	std::cout << "finger test passed" << std::endl;
+	return 0;
+}
+
+// neighbour links must follow the in-order sequence after every insert & remove
+using linked_node_t = cuw::trb::tree_node_linked_t<traits_t>;
+
+struct linked_key_ops_t {
+	int get_key(linked_node_t* node) const {
+		return node->data;
+	}
+
+	bool compare(int lhs, int rhs) const {
+		return lhs < rhs;
+	}
+};
+
+void collect_inorder(linked_node_t* root, std::vector<linked_node_t*>& nodes) {
+	if (root) {
+		collect_inorder(root->left, nodes);
+		nodes.push_back(root);
+		collect_inorder(root->right, nodes);
+	}
+}
+
+bool check_links(linked_node_t* root) {
+	std::vector<linked_node_t*> nodes;
+	collect_inorder(root, nodes);
+	for (std::size_t i = 0; i < nodes.size(); i++) {
+		if (nodes[i]->prev != (i > 0 ? nodes[i - 1] : nullptr) || nodes[i]->next != (i + 1 < nodes.size() ? nodes[i + 1] : nullptr)) {
+			return false;
+		}
+	}
+
+	std::size_t visited = 0;
+	bst::traverse_inorder(root, [&] (linked_node_t* node) { visited += node == nodes[visited]; });
+	return visited == nodes.size();
+}
+
+int tree_linked_test() {
+	std::cout << "linked test" << std::endl;
+
+	int nodes = 2000;
+	std::minstd_rand gen(42);
+	std::vector<linked_node_t*> inserted;
+	linked_node_t* root = nullptr;
+	for (int i = 0; i < 4 * nodes; i++) {
+		if (inserted.empty() || gen() % 3 != 0) {
+			linked_node_t* node = trb::alloc_node<linked_node_t>([&] (auto&& ... args) {
+				return new linked_node_t{std::forward<decltype(args)>(args)...};
+			}, (int)(gen() % nodes));
+			if (gen() % 2 == 0) {
+				root = trb::insert_lb(root, node, linked_key_ops_t{});
+			} else {
+				root = trb::insert_ub(root, node, linked_key_ops_t{});
+			}
+			inserted.push_back(node);
+		} else {
+			std::size_t index = gen() % inserted.size();
+			std::swap(inserted[index], inserted.back());
+			root = trb::remove(root, inserted.back());
+			delete inserted.back();
+			inserted.pop_back();
+		}
+
+		if (!trb::check_rb_invariant(root)) {
+			throw std::runtime_error("[linked] invariant");
+		} if (i % 64 == 0 && !check_links(root)) {
+			throw std::runtime_error("[linked] links");
+		}
+	}
+
+	if (!check_links(root)) {
+		throw std::runtime_error("[linked] links");
+	}
+
+	for (linked_node_t* node : inserted) {
+		delete node;
+	}
+
+	std::cout << "linked test passed" << std::endl;
+	return 0;
+}
+
+// trees built, split & joined in bulk must stay valid red-black trees with correct neighbour links
+void check_bulk(linked_node_t* root, const std::vector<linked_node_t*>& expected) {
+	std::vector<linked_node_t*> nodes;
+	collect_inorder(root, nodes);
+	if (nodes != expected) {
+		throw std::runtime_error(join("[bulk] order, expected: ", expected.size(), " got: ", nodes.size()));
+	} if (root && root->parent) {
+		throw std::runtime_error("[bulk] root parent");
+	} if (!trb::check_rb_invariant(root) || root && trb::get_color(root) != color_t::Black) {
+		throw std::runtime_error("[bulk] invariant");
+	} if (!check_links(root)) {
+		throw std::runtime_error("[bulk] links");
+	}
+}
+
+int tree_bulk_test() {
+	std::cout << "bulk test" << std::endl;
+
+	std::minstd_rand gen(42);
+	for (int count = 0; count < 300; count += 1 + count / 16) {
+		std::vector<linked_node_t*> sorted;
+		for (int i = 0; i < count; i++) {
+			sorted.push_back(new linked_node_t{nullptr, nullptr, nullptr, nullptr, nullptr, (int)(gen() % (count + 1))});
+		}
+		std::sort(sorted.begin(), sorted.end(), [] (auto* a, auto* b) { return a->data < b->data; });
+
+		std::size_t index = 0;
+		linked_node_t* root = trb::build(sorted.size(), [&] () { return sorted[index++]; });
+		check_bulk(root, sorted);
+
+		for (int i = 0; i < 8; i++) {
+			int key = (int)(gen() % (count + 3)) - 1;
+			auto [less, rest] = trb::split(root, key, linked_key_ops_t{});
+			auto bound = std::lower_bound(sorted.begin(), sorted.end(), key, [] (auto* node, int key) { return node->data < key; });
+			check_bulk(less, {sorted.begin(), bound});
+			check_bulk(rest, {bound, sorted.end()});
+
+			if (i % 2 == 0 || !rest) {
+				root = trb::concat(less, rest);
+			} else {
+				linked_node_t* mid = bst::tree_min(rest);
+				rest = trb::remove(rest, mid);
+				root = trb::join(less, mid, rest);
+			}
+			check_bulk(root, sorted);
+		}
+
+		int destroyed = 0;
+		bst::destroy(root, [&] (linked_node_t* node) {
+			++destroyed;
+			delete node;
+		});
+		if (destroyed != count) {
+			throw std::runtime_error("[bulk] destroy");
+		}
+	}
+
+	// augmented data is kept up to date by bulk operations too
+	std::unordered_map<node_t*, int> sizes;
+	std::vector<node_t*> sorted(1000);
+	for (int i = 0; i < (int)sorted.size(); i++) {
+		sorted[i] = new node_t{};
+		sorted[i]->data = i;
+	}
+
+	std::size_t index = 0;
+	subtree_size_ops_t aug_ops{sizes};
+	node_t* root = trb::build(sorted.size(), [&] () { return sorted[index++]; }, aug_ops);
+	for (int i = 0; i < 64; i++) {
+		auto [less, rest] = trb::split(root, (int)(gen() % sorted.size()), key_ops_t{}, aug_ops);
+		if (check_subtree_sizes(less, sizes) + check_subtree_sizes(rest, sizes) != (int)sorted.size()) {
+			throw std::runtime_error("[bulk] size");
+		}
+		root = trb::concat(less, rest, aug_ops);
+		if (!trb::check_rb_invariant(root) || check_subtree_sizes(root, sizes) != (int)sorted.size()) {
+			throw std::runtime_error("[bulk] augment");
+		}
+	}
+	bst::destroy(root, [&] (node_t* node) { delete node; });
+
+	std::cout << "bulk test passed" << std::endl;
+	return 0;
+}
+
+// compact nodes link each other relatively to the base of their region, tree must stay valid & linked
+using compact_traits_t = cuw::trb::tree_node_compact_traits_t<int, 16>;
+using compact_node_t = cuw::trb::tree_node_compact_t<compact_traits_t>;
+using compact_linked_node_t = cuw::trb::tree_node_compact_linked_t<compact_traits_t>;
+
+static_assert(sizeof(compact_node_t) == 16 && sizeof(compact_linked_node_t) == 24);
+
+struct compact_key_ops_t {
+	int get_key(compact_linked_node_t* node) const {
+		return node->data;
+	}
+
+	bool compare(int lhs, int rhs) const {
+		return lhs < rhs;
+	}
+};
+
+void collect_inorder(compact_linked_node_t* root, std::vector<compact_linked_node_t*>& nodes) {
+	if (root) {
+		collect_inorder(root->left, nodes);
+		nodes.push_back(root);
+		collect_inorder(root->right, nodes);
+	}
+}
+
+bool check_links(compact_linked_node_t* root) {
+	std::vector<compact_linked_node_t*> nodes;
+	collect_inorder(root, nodes);
+	for (std::size_t i = 0; i < nodes.size(); i++) {
+		if (nodes[i]->prev != (i > 0 ? nodes[i - 1] : nullptr) || nodes[i]->next != (i + 1 < nodes.size() ? nodes[i + 1] : nullptr)) {
+			return false;
+		} if (i > 0 && nodes[i - 1]->data > nodes[i]->data) {
+			return false;
+		}
+	} return true;
+}
+
+int tree_compact_test() {
+	std::cout << "compact test" << std::endl;
+
+	constexpr std::size_t region_size = (std::size_t)1 << compact_traits_t::region_bits;
+	constexpr int nodes = region_size / sizeof(compact_linked_node_t) - 1; // region base cannot be a node
+
+	void* region = std::aligned_alloc(region_size, region_size);
+	auto* storage = (compact_linked_node_t*)region + 1;
+
+	std::minstd_rand gen(42);
+	std::vector<int> free_nodes(nodes);
+	std::vector<int> inserted;
+	compact_linked_node_t* root = nullptr;
+
+	std::iota(free_nodes.rbegin(), free_nodes.rend(), 0);
+	for (int i = 0; i < 4 * nodes; i++) {
+		if (inserted.empty() || !free_nodes.empty() && gen() % 3 != 0) {
+			int index = free_nodes.back();
+			free_nodes.pop_back();
+
+			compact_linked_node_t* node = trb::alloc_node<compact_linked_node_t>([&] (auto&& ... args) {
+				return new (storage + index) compact_linked_node_t{std::forward<decltype(args)>(args)...};
+			}, (int)(gen() % nodes));
+			if (gen() % 2 == 0) {
+				root = trb::insert_lb(root, node, compact_key_ops_t{});
+			} else {
+				root = trb::insert_ub(root, node, compact_key_ops_t{});
+			}
+			inserted.push_back(index);
+		} else {
+			std::size_t pos = gen() % inserted.size();
+			std::swap(inserted[pos], inserted.back());
+			root = trb::remove(root, storage + inserted.back());
+			free_nodes.push_back(inserted.back());
+			inserted.pop_back();
+		}
+
+		if (!trb::check_rb_invariant(root)) {
+			throw std::runtime_error("[compact] invariant");
+		} if (i % 64 == 0 && !check_links(root)) {
+			throw std::runtime_error("[compact] links");
+		}
+	}
+
+	std::size_t visited = 0;
+	bst::traverse_inorder(root, [&] (compact_linked_node_t*) { visited++; });
+	if (!check_links(root) || visited != inserted.size()) {
+		throw std::runtime_error("[compact] links");
+	}
+
+	std::free(region);
+
+	std::cout << "compact test passed" << std::endl;
+	return 0;
+}
+
 using seq_t = std::vector<int>;
 
 struct seq_wrapper_t {
@@ -716,6 +1074,26 @@ int main(int argc, char* argv[]) {
 		if (tree_test3()) {
 			return -1;
 		}
+
+		if (tree_augment_test()) {
+			return -1;
+		}
+
+		if (tree_finger_test()) {
+			return -1;
+		}
+
+		if (tree_linked_test()) {
+			return -1;
+		}
+
+		if (tree_bulk_test()) {
+			return -1;
+		}
+
+		if (tree_compact_test()) {
+			return -1;
+		}
 		
 		/*if (tree_factorial_test()) {
 			return -1;